@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Accuracy versus speed of the approximate processing paths.
+ *
+ * Build with `make accuracy` in build/ and run from there:
+ *
+ *   ./loudness-accuracy [-w wavDir] [-r rates] [-d seconds] [-p phons]
+ *                       [-l sones] [-f filter]
+ *
+ *   -w  directory holding the test wavs (default ../wavs)
+ *   -r  comma separated sampling rates of the synthetic signals
+ *       (default 44100)
+ *   -d  duration of the synthetic signals in seconds (default 0.5)
+ *   -p  maximum phon error tolerated by every pipeline, replacing the
+ *       per-pipeline defaults
+ *   -l  loudness floor in sones below which frames are excluded from the
+ *       phon error (default 0.01)
+ *   -f  only run pipelines whose name contains this string
+ *
+ * The reference is DynamicLoudnessGM with the GM02 parameter set
+ * (PowerSpectrum with uniform sampling, RoexBankANSIS3407). Each approximate
+ * pipeline changes one or more stages of the reference and is run on the
+ * same signals: the mono wavs in the wav directory plus synthetic tones,
+ * noise, an amplitude modulated complex and a sweep. Signals sharing a
+ * sampling rate are processed together as the tracks of a single model.
+ *
+ * One CSV row is printed per pipeline, signal and quantity (IL, STL, LTL):
+ *
+ *   pipeline,signal,fs,quantity,max_sone,rms_sone,max_phon,rms_phon,
+ *   wall_s,ref_wall_s,tolerance_phon,status
+ *
+ * wall_s and ref_wall_s are the processing times of the pipeline and the
+ * reference for all signals at that sampling rate. The program exits with
+ * status 1 if any max_phon exceeds the tolerance of its pipeline.
+ */
+
+#include "../src/Support/Timer.h"
+#include "../src/Support/AuditoryTools.h"
+#include "../src/Modules/AudioFileCutter.h"
+#include "../src/Models/DynamicLoudnessGM.h"
+#include <dirent.h>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <sstream>
+
+using namespace loudness;
+
+namespace{
+
+    struct Options
+    {
+        string wavDir, filter;
+        vector<int> rates;
+        Real duration, tolerance, floor;
+    };
+
+    struct Signal
+    {
+        string name;
+        RealVec x;
+    };
+
+    struct Variant
+    {
+        string name;
+        Real tolerance; //max phon error
+        std::function<void(DynamicLoudnessGM&)> configure;
+    };
+
+    /*
+     * frames[track][frame * 3 + q] holds quantity q (IL, STL, LTL).
+     */
+    typedef RealVecVec Loudness;
+
+    vector<int> parseList(const char *arg)
+    {
+        vector<int> values;
+        std::stringstream ss(arg);
+        string item;
+        while (std::getline(ss, item, ','))
+            values.push_back(atoi(item.c_str()));
+        return values;
+    }
+
+    vector<Variant> getVariants()
+    {
+        vector<Variant> pipelines;
+        pipelines.push_back({"FastRoexBank", 0.5, [](DynamicLoudnessGM &model)
+        {
+            model.setFastBank(true);
+        }});
+        pipelines.push_back({"FastRoexBank.interp", 0.5, [](DynamicLoudnessGM &model)
+        {
+            model.setFastBank(true);
+            model.setInterpRoexBank(true);
+        }});
+        pipelines.push_back({"FastRoexBank.levelCache", 0.5, [](DynamicLoudnessGM &model)
+        {
+            model.setFastBank(true);
+            model.setRoexLevelResolution(0.5);
+        }});
+        //0.5 dB level steps add about 5e-4 phon to the exact bank
+        pipelines.push_back({"RoexBankANSIS3407.levelCache", 0.01, [](DynamicLoudnessGM &model)
+        {
+            model.setRoexLevelResolution(0.5);
+        }});
+        //tables accurate to 1e-5 give about 1e-5 phon (double and float)
+        pipelines.push_back({"SpecificLoudnessGM.table", 0.001, [](DynamicLoudnessGM &model)
+        {
+            model.setSpecificLoudnessTableTolerance(1e-5);
+        }});
+        pipelines.push_back({"CompressSpectrum", 0.5, [](DynamicLoudnessGM &model)
+        {
+            model.setCompressionCriterion(0.3);
+        }});
+        //coarser low-frequency sampling; the worst case is the instantaneous
+        //loudness of the 44.1 kHz sweep (0.56 phon)
+        pipelines.push_back({"PowerSpectrum.nonuniform", 0.6, [](DynamicLoudnessGM &model)
+        {
+            model.setUniform(false);
+        }});
+        pipelines.push_back({"SlidingPowerSpectrum", 0.01, [](DynamicLoudnessGM &model)
+        {
+            model.setSlidingSpectrum(true);
+        }});
+        pipelines.push_back({"SlidingPowerSpectrum.autotune", 0.01, [](DynamicLoudnessGM &model)
+        {
+            model.setAutotuneSpectrum(true);
+        }});
+        //bins spaced at fs / windowSize, sparser than the FFT bins; the worst
+        //case is the instantaneous loudness of the sweep (2.3 phon)
+        pipelines.push_back({"GoertzelPS", 2.5, [](DynamicLoudnessGM &model)
+        {
+            model.setGoertzel(true);
+        }});
+        pipelines.push_back({"FASTER1", 1.0, [](DynamicLoudnessGM &model)
+        {
+            model.loadParameterSet(DynamicLoudnessGM::FASTER1);
+        }});
+        return pipelines;
+    }
+
+    /*
+     * Reads the first channel of a wav file with AudioFileCutter.
+     */
+    bool loadWav(const string &path, int &fs, RealVec &x)
+    {
+        const int frameSize = 4096;
+        AudioFileCutter cutter(vector<string>(1, path), frameSize);
+        if (!cutter.initialize())
+            return false;
+        fs = cutter.getFs();
+        const TrackBank *frame = cutter.getOutput();
+        x.clear();
+        for (int i = 0; i < cutter.getNFrames(); i++)
+        {
+            cutter.process();
+            const Real *samples = frame->getSignalReadPointer(0, 0);
+            x.insert(x.end(), samples, samples + frameSize);
+        }
+        x.resize(cutter.getNSamples());
+        return true;
+    }
+
+    void addWavs(const Options &opts, std::map<int, vector<Signal> > &groups)
+    {
+        DIR *dir = opendir(opts.wavDir.c_str());
+        if (!dir)
+        {
+            LOUDNESS_WARNING("Accuracy: Cannot open " << opts.wavDir);
+            return;
+        }
+        vector<string> names;
+        while (struct dirent *entry = readdir(dir))
+        {
+            string name = entry->d_name;
+            if ((name.size() > 4) && (name.substr(name.size() - 4) == ".wav"))
+                names.push_back(name);
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+
+        for (unsigned int i = 0; i < names.size(); i++)
+        {
+            Signal signal;
+            int fs;
+            signal.name = names[i];
+            if (loadWav(opts.wavDir + "/" + names[i], fs, signal.x))
+                groups[fs].push_back(signal);
+        }
+    }
+
+    /*
+     * Amplitude of a sinusoid at @a dB SPL given the 2e-5 reference used by
+     * the power spectrum modules.
+     */
+    Real amplitude(Real dB)
+    {
+        return 2e-5 * sqrt(2.0) * pow(10, dB / 20.0);
+    }
+
+    void addSynthetic(const Options &opts, std::map<int, vector<Signal> > &groups)
+    {
+        for (unsigned int r = 0; r < opts.rates.size(); r++)
+        {
+            int fs = opts.rates[r];
+            int n = (int)(opts.duration * fs);
+            Signal tone, noise, am, sweep;
+            tone.name = "tone1kHz60dB";
+            noise.name = "noise70dB";
+            am.name = "am4Hz70dB";
+            sweep.name = "sweep65dB";
+            unsigned int seed = 1;
+            Real phase = 0;
+            for (int i = 0; i < n; i++)
+            {
+                Real t = i / (Real)fs;
+                seed = seed * 1103515245u + 12345u;
+                Real uniform = ((seed >> 8) & 0xffff) / 65536.0 - 0.5;
+
+                tone.x.push_back(amplitude(60) * sin(2 * PI * 1000 * t));
+                //uniform noise has an rms of 1/sqrt(12)
+                noise.x.push_back(amplitude(70) / sqrt(2.0) * sqrt(12.0) * uniform);
+                am.x.push_back(amplitude(64) * (1 + sin(2 * PI * 4 * t)) *
+                        (sin(2 * PI * 250 * t) + sin(2 * PI * 1000 * t)));
+                //logarithmic sweep from 50 Hz to 15 kHz
+                Real freq = 50 * pow(15000 / 50.0, t / opts.duration);
+                phase += 2 * PI * freq / fs;
+                sweep.x.push_back(amplitude(65) * sin(phase));
+            }
+            groups[fs].push_back(tone);
+            groups[fs].push_back(noise);
+            groups[fs].push_back(am);
+            groups[fs].push_back(sweep);
+        }
+    }
+
+    /*
+     * Runs the model set up by @a configure over all signals of a group and
+     * returns the wall-clock processing time.
+     */
+    double run(const std::function<void(DynamicLoudnessGM&)> &configure,
+            int fs, const vector<Signal> &signals, Loudness &loudness)
+    {
+        int nTracks = (int)signals.size();
+        int nSamples = 0;
+        for (int track = 0; track < nTracks; track++)
+            nSamples = std::max(nSamples, (int)signals[track].x.size());
+
+        TrackBank block;
+        block.initialize(nTracks, 1, nSamples, fs);
+        for (int track = 0; track < nTracks; track++)
+        {
+            std::copy(signals[track].x.begin(), signals[track].x.end(),
+                    block.getSignalWritePointer(track, 0));
+        }
+
+        DynamicLoudnessGM model;
+        model.loadParameterSet(DynamicLoudnessGM::GM02);
+        configure(model);
+
+        TrackBank init;
+        init.initialize(nTracks, 1, (int)round(model.getTimeStep() * fs), fs);
+        if (!model.initialize(init))
+        {
+            LOUDNESS_ERROR("Accuracy: Model not initialised.");
+            return 0;
+        }
+
+        Timer timer("WALL");
+        timer.tic();
+        const TrackBank &frames = model.processBlock(block);
+        timer.toc();
+
+        loudness.assign(nTracks, RealVec());
+        for (int track = 0; track < frames.getNTracks(); track++)
+        {
+            for (int frame = 0; frame < frames.getNChannels(); frame++)
+            {
+                const Real *values = frames.getSignalReadPointer(track, frame);
+                loudness[track].insert(loudness[track].end(), values, values + 3);
+            }
+        }
+        return timer.getElapsedTime();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    opts.wavDir = "../wavs";
+    opts.rates = {44100};
+    opts.duration = 0.5;
+    opts.tolerance = -1;
+    opts.floor = 0.01;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-w" && hasValue)
+            opts.wavDir = argv[++i];
+        else if (arg == "-r" && hasValue)
+            opts.rates = parseList(argv[++i]);
+        else if (arg == "-d" && hasValue)
+            opts.duration = atof(argv[++i]);
+        else if (arg == "-p" && hasValue)
+            opts.tolerance = atof(argv[++i]);
+        else if (arg == "-l" && hasValue)
+            opts.floor = atof(argv[++i]);
+        else if (arg == "-f" && hasValue)
+            opts.filter = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [-w wavDir] [-r rates] [-d seconds] "
+                    "[-p phons] [-l sones] [-f filter]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::map<int, vector<Signal> > groups;
+    addWavs(opts, groups);
+    addSynthetic(opts, groups);
+
+    vector<Variant> pipelines = getVariants();
+    const char *quantities[3] = {"IL", "STL", "LTL"};
+    bool pass = true;
+
+    printf("pipeline,signal,fs,quantity,max_sone,rms_sone,max_phon,rms_phon,"
+            "wall_s,ref_wall_s,tolerance_phon,status\n");
+
+    for (std::map<int, vector<Signal> >::iterator group = groups.begin();
+            group != groups.end(); ++group)
+    {
+        int fs = group->first;
+        const vector<Signal> &signals = group->second;
+
+        Loudness reference;
+        double refWall = run([](DynamicLoudnessGM&){}, fs, signals, reference);
+
+        for (unsigned int p = 0; p < pipelines.size(); p++)
+        {
+            const Variant &pipeline = pipelines[p];
+            if (!opts.filter.empty() && (pipeline.name.find(opts.filter) == string::npos))
+                continue;
+
+            Loudness approx;
+            double wall = run(pipeline.configure, fs, signals, approx);
+            Real tolerance = opts.tolerance < 0 ? pipeline.tolerance : opts.tolerance;
+
+            for (unsigned int track = 0; track < signals.size(); track++)
+            {
+                int nFrames = (int)reference[track].size() / 3;
+                for (int q = 0; q < 3; q++)
+                {
+                    double maxSone = 0, sumSone = 0, maxPhon = 0, sumPhon = 0;
+                    int nPhon = 0;
+                    for (int frame = 0; frame < nFrames; frame++)
+                    {
+                        Real ref = reference[track][frame * 3 + q];
+                        Real val = approx[track][frame * 3 + q];
+                        double err = fabs(val - ref);
+                        maxSone = std::max(maxSone, err);
+                        sumSone += err * err;
+                        if ((ref >= opts.floor) && (val >= opts.floor))
+                        {
+                            err = fabs(SoneToPhon(val, false) - SoneToPhon(ref, false));
+                            maxPhon = std::max(maxPhon, err);
+                            sumPhon += err * err;
+                            nPhon++;
+                        }
+                    }
+
+                    bool ok = maxPhon <= tolerance;
+                    pass = pass && ok;
+                    printf("%s,%s,%d,%s,%.6g,%.6g,%.6g,%.6g,%.6f,%.6f,%g,%s\n",
+                            pipeline.name.c_str(), signals[track].name.c_str(), fs,
+                            quantities[q], maxSone,
+                            nFrames ? sqrt(sumSone / nFrames) : 0.0,
+                            maxPhon, nPhon ? sqrt(sumPhon / nPhon) : 0.0,
+                            wall, refWall, tolerance, ok ? "ok" : "FAIL");
+                }
+            }
+            fflush(stdout);
+        }
+    }
+
+    if (!pass)
+    {
+        fprintf(stderr, "Accuracy: tolerance exceeded.\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,598 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark for modules and models.
+ *
+ * Build with `make bench` in build/ and run from there:
+ *
+ *   ./loudness-bench [-r rates] [-t tracks] [-j threads] [-d seconds]
+ *                    [-f filter] [-c coefDir] [-w wisdom] [-m | -M]
+ *
+ *   -r  comma separated sampling rates in Hz (default 32000,44100,48000)
+ *   -t  comma separated track counts (default 1)
+ *   -j  number of threads (default 1)
+ *   -d  seconds of audio processed per case (default 2)
+ *   -f  only run cases whose name contains this string
+ *   -c  directory holding the filter coefficients (default ../filterCoefs)
+ *   -w  FFTW wisdom file, read at startup and updated with new plans
+ *   -m  modules only
+ *   -M  models only
+ *
+ * Each module is timed in isolation. Time-domain modules process a new block
+ * of one hop (1 ms) of audio per call. Every other module repeatedly processes
+ * a fixed input frame, produced by running the modules listed before it in
+ * its chain on the same synthetic audio. Models process the audio one hop at
+ * a time with Model::process(); with a frame batch size (.batch cases), the
+ * stateless modules process a batch of frames per call.
+ *
+ * One CSV row is printed per case:
+ *
+ *   kind,name,fs,tracks,threads,frames,audio_s,wall_s,rtf,frames_per_s
+ *
+ * rtf is the wall-clock time divided by the duration of the audio processed,
+ * so values below 1 are faster than real time. Modules and models comparing
+ * target and masker tracks (SpecificPartialLoudnessGM, DynamicPartialLoudnessGM
+ * ...) need an even number of tracks; odd counts are rounded up and the
+ * count actually used is reported.
+ */
+
+#include "../src/Support/Timer.h"
+#include "../src/Support/ThreadPool.h"
+#include "../src/Support/FFTW.h"
+#include "../src/cnpy/cnpy.h"
+#include "../src/Modules/FIR.h"
+#include "../src/Modules/IIR.h"
+#include "../src/Modules/Butter.h"
+#include "../src/Modules/FrameGenerator.h"
+#include "../src/Modules/PowerSpectrum.h"
+#include "../src/Modules/SlidingPowerSpectrum.h"
+#include "../src/Modules/GoertzelPS.h"
+#include "../src/Modules/PowerSpectrumAndSpatialDetection.h"
+#include "../src/Modules/CompressSpectrum.h"
+#include "../src/Modules/WeightSpectrum.h"
+#include "../src/Modules/FastRoexBank.h"
+#include "../src/Modules/RoexBankANSIS3407.h"
+#include "../src/Modules/DoubleRoexBank.h"
+#include "../src/Modules/SpecificLoudnessGM.h"
+#include "../src/Modules/SpecificPartialLoudnessGM.h"
+#include "../src/Modules/IntegratedLoudnessGM.h"
+#include "../src/Modules/IntegratedPartialLoudnessGM.h"
+#include "../src/Models/DynamicLoudnessGM.h"
+#include "../src/Models/DynamicPartialLoudnessGM.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+
+using namespace loudness;
+
+namespace{
+
+    struct Options
+    {
+        vector<int> rates, tracks;
+        int nThreads;
+        Real duration;
+        string filter, coefDir;
+        bool modules, models;
+    };
+
+    typedef vector<unique_ptr<Module> > Chain;
+
+    /*
+     * A module case builds a chain whose last module is the one timed; the
+     * modules before it only generate its input. Model cases build and
+     * initialise a model.
+     */
+    struct ModuleCase
+    {
+        string name;
+        bool pairs;
+        std::function<Chain(int fs, int nTracks, const Options &opts)> build;
+    };
+
+    struct ModelCase
+    {
+        string name;
+        bool pairs;
+        std::function<Model*()> build;
+    };
+
+    vector<int> parseList(const char *arg)
+    {
+        vector<int> values;
+        std::stringstream ss(arg);
+        string item;
+        while (std::getline(ss, item, ','))
+            values.push_back(atoi(item.c_str()));
+        return values;
+    }
+
+    int getHopSize(int fs)
+    {
+        return (int)round(0.001 * fs);
+    }
+
+    /*
+     * Noise plus a tone per track, at roughly 70 dB SPL.
+     */
+    void fillAudio(TrackBank &audio)
+    {
+        unsigned int seed = 1;
+        for (int track = 0; track < audio.getNTracks(); track++)
+        {
+            Real *x = audio.getSignalWritePointer(track, 0);
+            Real freq = 250.0 * (track + 1);
+            for (int i = 0; i < audio.getNSamples(); i++)
+            {
+                seed = seed * 1103515245u + 12345u;
+                Real noise = ((seed >> 8) & 0xffff) / 65536.0 - 0.5;
+                x[i] = 0.05 * noise + 0.1 * sin(2 * PI * freq * i / audio.getFs());
+            }
+        }
+    }
+
+    void copyBlock(const TrackBank &audio, int start, TrackBank &block)
+    {
+        for (int track = 0; track < block.getNTracks(); track++)
+        {
+            const Real *x = audio.getSignalReadPointer(track, 0, start);
+            std::copy(x, x + block.getNSamples(), block.getSignalWritePointer(track, 0));
+        }
+    }
+
+    vector<double> loadCoefs(const Options &opts, int fs, const string &type, vector<double> &aCoefs)
+    {
+        std::stringstream path;
+        path << opts.coefDir << "/" << fs << "_" << type << "_freemid.npy";
+        cnpy::NpyArray arr = cnpy::npy_load(path.str());
+        vector<double> data = cnpy::npy_data_as<double>(arr);
+        vector<double> bCoefs;
+        aCoefs.clear();
+        for (unsigned int i = 0; i < arr.shape[1]; i++)
+        {
+            bCoefs.push_back(data[i]);
+            if (arr.shape[0] == 2)
+                aCoefs.push_back(data[i + arr.shape[1]]);
+        }
+        arr.destruct();
+        return bCoefs;
+    }
+
+    /*
+     * The front end shared by all spectral cases.
+     */
+    Chain spectrum(int fs, bool uniform, bool sliding = false, bool autotune = false)
+    {
+        RealVec bandFreqsHz {10, 80, 500, 1250, 2540, 4050, 15001};
+        RealVec windowSizeSecs {0.064, 0.032, 0.016, 0.008, 0.004, 0.002};
+        Chain chain;
+        chain.push_back(unique_ptr<Module>
+                (new FrameGenerator(round(0.064 * fs), getHopSize(fs))));
+        if (sliding)
+        {
+            SlidingPowerSpectrum *module =
+                new SlidingPowerSpectrum(bandFreqsHz, windowSizeSecs, uniform);
+            module->setAutotune(autotune);
+            chain.push_back(unique_ptr<Module>(module));
+        }
+        else
+            chain.push_back(unique_ptr<Module>
+                    (new PowerSpectrum(bandFreqsHz, windowSizeSecs, uniform)));
+        return chain;
+    }
+
+    Chain append(Chain chain, Module *module)
+    {
+        chain.push_back(unique_ptr<Module>(module));
+        return chain;
+    }
+
+    vector<ModuleCase> getModuleCases()
+    {
+        vector<ModuleCase> cases;
+
+        cases.push_back({"FIR", false, [](int fs, int, const Options &opts)
+        {
+            vector<double> aCoefs;
+            vector<double> bCoefs = loadCoefs(opts, fs, "FIR_4096", aCoefs);
+            Chain chain;
+            chain.push_back(unique_ptr<Module>(new FIR(bCoefs)));
+            return chain;
+        }});
+        cases.push_back({"IIR", false, [](int fs, int nTracks, const Options &opts)
+        {
+            vector<double> aCoefs;
+            vector<double> bCoefs = loadCoefs(opts, fs, "IIR_23", aCoefs);
+            Chain chain;
+            chain.push_back(unique_ptr<Module>(new IIR(nTracks, bCoefs, aCoefs)));
+            return chain;
+        }});
+        cases.push_back({"Butter", false, [](int, int, const Options&)
+        {
+            Chain chain;
+            chain.push_back(unique_ptr<Module>(new Butter(3, 0, 50.0)));
+            return chain;
+        }});
+        cases.push_back({"FrameGenerator", false, [](int fs, int, const Options&)
+        {
+            Chain chain;
+            chain.push_back(unique_ptr<Module>
+                    (new FrameGenerator(round(0.064 * fs), getHopSize(fs))));
+            return chain;
+        }});
+        cases.push_back({"PowerSpectrum.uniform", false, [](int fs, int, const Options&)
+        {
+            return spectrum(fs, true);
+        }});
+        cases.push_back({"PowerSpectrum.nonuniform", false, [](int fs, int, const Options&)
+        {
+            return spectrum(fs, false);
+        }});
+        cases.push_back({"SlidingPowerSpectrum.uniform", false, [](int fs, int, const Options&)
+        {
+            return spectrum(fs, true, true);
+        }});
+        cases.push_back({"SlidingPowerSpectrum.nonuniform", false, [](int fs, int, const Options&)
+        {
+            return spectrum(fs, false, true);
+        }});
+        cases.push_back({"SlidingPowerSpectrum.autotune.uniform", false, [](int fs, int, const Options&)
+        {
+            return spectrum(fs, true, true, true);
+        }});
+        cases.push_back({"SlidingPowerSpectrum.autotune.nonuniform", false, [](int fs, int, const Options&)
+        {
+            return spectrum(fs, false, true, true);
+        }});
+        cases.push_back({"GoertzelPS", false, [](int fs, int, const Options&)
+        {
+            RealVec bandFreqsHz {10, 80, 500, 1250, 2540, 4050, 15001};
+            RealVec windowSizeSecs {0.064, 0.032, 0.016, 0.008, 0.004, 0.002};
+            Chain chain;
+            chain.push_back(unique_ptr<Module>(new GoertzelPS(bandFreqsHz,
+                            windowSizeSecs, getHopSize(fs) / (Real)fs)));
+            return chain;
+        }});
+        cases.push_back({"PowerSpectrumAndSpatialDetection", true, [](int fs, int, const Options&)
+        {
+            RealVec bandFreqsHz {10, 80, 500, 1250, 2540, 4050, 15001};
+            RealVec windowSizeSecs {0.064, 0.032, 0.016, 0.008, 0.004, 0.002};
+            Chain chain;
+            chain.push_back(unique_ptr<Module>
+                    (new FrameGenerator(round(0.064 * fs), getHopSize(fs))));
+            chain.push_back(unique_ptr<Module>
+                    (new PowerSpectrumAndSpatialDetection(bandFreqsHz, windowSizeSecs, true)));
+            return chain;
+        }});
+        cases.push_back({"CompressSpectrum", false, [](int fs, int, const Options&)
+        {
+            return append(spectrum(fs, true), new CompressSpectrum(0.3));
+        }});
+        cases.push_back({"WeightSpectrum", false, [](int fs, int, const Options&)
+        {
+            return append(spectrum(fs, true), new WeightSpectrum(OME::ANSI_HPF, OME::ANSI_FREE));
+        }});
+        cases.push_back({"FastRoexBank", false, [](int fs, int, const Options&)
+        {
+            return append(spectrum(fs, true), new FastRoexBank(0.25, true));
+        }});
+        cases.push_back({"RoexBankANSIS3407", false, [](int fs, int, const Options&)
+        {
+            return append(spectrum(fs, true), new RoexBankANSIS3407(1.8, 38.9, 0.25));
+        }});
+        cases.push_back({"FastRoexBank.levelCache", false, [](int fs, int, const Options&)
+        {
+            FastRoexBank *module = new FastRoexBank(0.25, true);
+            module->setLevelResolution(0.5);
+            return append(spectrum(fs, true), module);
+        }});
+        cases.push_back({"RoexBankANSIS3407.levelCache", false, [](int fs, int, const Options&)
+        {
+            RoexBankANSIS3407 *module = new RoexBankANSIS3407(1.8, 38.9, 0.25);
+            module->setLevelResolution(0.5);
+            return append(spectrum(fs, true), module);
+        }});
+        cases.push_back({"DoubleRoexBank", false, [](int fs, int, const Options&)
+        {
+            return append(spectrum(fs, true), new DoubleRoexBank(1.5, 40.1, 0.25));
+        }});
+        cases.push_back({"SpecificLoudnessGM", false, [](int fs, int, const Options&)
+        {
+            Chain chain = append(spectrum(fs, true), new RoexBankANSIS3407(1.8, 38.9, 0.25));
+            return append(std::move(chain), new SpecificLoudnessGM);
+        }});
+        cases.push_back({"SpecificLoudnessGM.table", false, [](int fs, int, const Options&)
+        {
+            Chain chain = append(spectrum(fs, true), new RoexBankANSIS3407(1.8, 38.9, 0.25));
+            SpecificLoudnessGM *module = new SpecificLoudnessGM;
+            module->setTableTolerance(1e-5);
+            return append(std::move(chain), module);
+        }});
+        cases.push_back({"SpecificPartialLoudnessGM", true, [](int fs, int, const Options&)
+        {
+            Chain chain = append(spectrum(fs, true), new RoexBankANSIS3407(1.8, 38.9, 0.25));
+            return append(std::move(chain), new SpecificPartialLoudnessGM);
+        }});
+        cases.push_back({"IntegratedLoudnessGM", false, [](int fs, int, const Options&)
+        {
+            Chain chain = append(spectrum(fs, true), new RoexBankANSIS3407(1.8, 38.9, 0.25));
+            chain = append(std::move(chain), new SpecificLoudnessGM);
+            return append(std::move(chain), new IntegratedLoudnessGM);
+        }});
+        cases.push_back({"IntegratedPartialLoudnessGM", true, [](int fs, int, const Options&)
+        {
+            Chain chain = append(spectrum(fs, true), new RoexBankANSIS3407(1.8, 38.9, 0.25));
+            chain = append(std::move(chain), new SpecificPartialLoudnessGM);
+            return append(std::move(chain), new IntegratedPartialLoudnessGM);
+        }});
+
+        return cases;
+    }
+
+    vector<ModelCase> getModelCases()
+    {
+        vector<ModelCase> cases;
+        cases.push_back({"DynamicLoudnessGM.GM02", false, []()
+        {
+            DynamicLoudnessGM *model = new DynamicLoudnessGM;
+            model->loadParameterSet(DynamicLoudnessGM::GM02);
+            return (Model*)model;
+        }});
+        cases.push_back({"DynamicLoudnessGM.GM02.levelCache", false, []()
+        {
+            DynamicLoudnessGM *model = new DynamicLoudnessGM;
+            model->loadParameterSet(DynamicLoudnessGM::GM02);
+            model->setRoexLevelResolution(0.5);
+            return (Model*)model;
+        }});
+        cases.push_back({"DynamicLoudnessGM.GM02.table", false, []()
+        {
+            DynamicLoudnessGM *model = new DynamicLoudnessGM;
+            model->loadParameterSet(DynamicLoudnessGM::GM02);
+            model->setSpecificLoudnessTableTolerance(1e-5);
+            return (Model*)model;
+        }});
+        cases.push_back({"DynamicLoudnessGM.GM02.batch8", false, []()
+        {
+            DynamicLoudnessGM *model = new DynamicLoudnessGM;
+            model->loadParameterSet(DynamicLoudnessGM::GM02);
+            model->setFrameBatchSize(8);
+            return (Model*)model;
+        }});
+        cases.push_back({"DynamicLoudnessGM.FASTER1", false, []()
+        {
+            DynamicLoudnessGM *model = new DynamicLoudnessGM;
+            model->loadParameterSet(DynamicLoudnessGM::FASTER1);
+            return (Model*)model;
+        }});
+        cases.push_back({"DynamicPartialLoudnessGM.GM02", true, []()
+        {
+            DynamicPartialLoudnessGM *model = new DynamicPartialLoudnessGM;
+            model->loadParameterSet(DynamicPartialLoudnessGM::GM02);
+            return (Model*)model;
+        }});
+        cases.push_back({"DynamicPartialLoudnessGM.FASTER1", true, []()
+        {
+            DynamicPartialLoudnessGM *model = new DynamicPartialLoudnessGM;
+            model->loadParameterSet(DynamicPartialLoudnessGM::FASTER1);
+            return (Model*)model;
+        }});
+        return cases;
+    }
+
+    void printResult(const string &kind, const string &name, int fs, int nTracks,
+            int nThreads, long nFrames, double audioSecs, double wallSecs)
+    {
+        printf("%s,%s,%d,%d,%d,%ld,%.6f,%.6f,%.6f,%.1f\n",
+                kind.c_str(), name.c_str(), fs, nTracks, nThreads, nFrames,
+                audioSecs, wallSecs, wallSecs / audioSecs, nFrames / wallSecs);
+        fflush(stdout);
+    }
+
+    void benchModule(const ModuleCase &mc, int fs, int nTracks, const Options &opts)
+    {
+        int hopSize = getHopSize(fs);
+        long nFrames = (long)(opts.duration * fs) / hopSize;
+
+        TrackBank audio, block;
+        audio.initialize(nTracks, 1, nFrames * hopSize, fs);
+        fillAudio(audio);
+        block.initialize(nTracks, 1, hopSize, fs);
+
+        ThreadPool *pool = nullptr;
+        unique_ptr<ThreadPool> threadPool;
+        if (opts.nThreads > 1)
+        {
+            threadPool.reset(new ThreadPool(opts.nThreads));
+            pool = threadPool.get();
+        }
+
+        Chain chain = mc.build(fs, nTracks, opts);
+        int last = (int)chain.size() - 1;
+        for (int i = 0; i <= last; i++)
+        {
+            chain[i]->setThreadPool(pool);
+            if (i < last)
+                chain[i]->setTargetModule(chain[i + 1].get());
+        }
+        if (!chain[0]->initialize(block))
+        {
+            LOUDNESS_ERROR("Benchmark: " << mc.name << " not initialised.");
+            return;
+        }
+
+        Module *module = chain[last].get();
+        Timer timer("WALL");
+        double wallSecs = 0;
+
+        if (last == 0)
+        {
+            //time-domain module: new audio on every call
+            for (long frame = 0; frame < nFrames; frame++)
+            {
+                copyBlock(audio, frame * hopSize, block);
+                timer.tic();
+                module->process(block);
+                timer.toc();
+                wallSecs += timer.getElapsedTime();
+            }
+        }
+        else
+        {
+            //run the chain until the module input holds a full frame
+            int nWarmUp = (int)ceil(0.07 * fs / hopSize);
+            for (int frame = 0; frame < nWarmUp; frame++)
+            {
+                copyBlock(audio, (frame % nFrames) * hopSize, block);
+                chain[0]->process(block);
+            }
+            TrackBank input(*chain[last - 1]->getOutput());
+            chain[last - 1]->removeTargetModule();
+
+            timer.tic();
+            for (long frame = 0; frame < nFrames; frame++)
+                module->process(input);
+            timer.toc();
+            wallSecs = timer.getElapsedTime();
+        }
+
+        printResult("module", mc.name, fs, nTracks, opts.nThreads, nFrames,
+                nFrames * hopSize / (double)fs, wallSecs);
+    }
+
+    void benchModel(const ModelCase &mc, int fs, int nTracks, const Options &opts)
+    {
+        int hopSize = getHopSize(fs);
+        long nFrames = (long)(opts.duration * fs) / hopSize;
+
+        TrackBank audio, block;
+        audio.initialize(nTracks, 1, nFrames * hopSize, fs);
+        fillAudio(audio);
+        block.initialize(nTracks, 1, hopSize, fs);
+
+        unique_ptr<Model> model(mc.build());
+        model->setNThreads(opts.nThreads);
+        if (!model->initialize(block))
+        {
+            LOUDNESS_ERROR("Benchmark: " << mc.name << " not initialised.");
+            return;
+        }
+
+        Timer timer("WALL");
+        double wallSecs = 0;
+        for (long frame = 0; frame < nFrames; frame++)
+        {
+            copyBlock(audio, frame * hopSize, block);
+            timer.tic();
+            model->process(block);
+            timer.toc();
+            wallSecs += timer.getElapsedTime();
+        }
+
+        printResult("model", mc.name, fs, nTracks, opts.nThreads, nFrames,
+                nFrames * hopSize / (double)fs, wallSecs);
+    }
+
+    bool selected(const string &name, const Options &opts)
+    {
+        return opts.filter.empty() || (name.find(opts.filter) != string::npos);
+    }
+
+    int evenTracks(int nTracks, bool pairs)
+    {
+        return (pairs && (nTracks % 2)) ? nTracks + 1 : nTracks;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    opts.rates = {32000, 44100, 48000};
+    opts.tracks = {1};
+    opts.nThreads = 1;
+    opts.duration = 2;
+    opts.coefDir = "../filterCoefs";
+    opts.modules = true;
+    opts.models = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-r" && hasValue)
+            opts.rates = parseList(argv[++i]);
+        else if (arg == "-t" && hasValue)
+            opts.tracks = parseList(argv[++i]);
+        else if (arg == "-j" && hasValue)
+            opts.nThreads = atoi(argv[++i]);
+        else if (arg == "-d" && hasValue)
+            opts.duration = atof(argv[++i]);
+        else if (arg == "-f" && hasValue)
+            opts.filter = argv[++i];
+        else if (arg == "-c" && hasValue)
+            opts.coefDir = argv[++i];
+        else if (arg == "-w" && hasValue)
+            FFTWPlanCache::setWisdomFile(argv[++i]);
+        else if (arg == "-m")
+            opts.models = false;
+        else if (arg == "-M")
+            opts.modules = false;
+        else
+        {
+            fprintf(stderr, "Usage: %s [-r rates] [-t tracks] [-j threads] "
+                    "[-d seconds] [-f filter] [-c coefDir] [-w wisdom] [-m | -M]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("kind,name,fs,tracks,threads,frames,audio_s,wall_s,rtf,frames_per_s\n");
+
+    if (opts.modules)
+    {
+        vector<ModuleCase> cases = getModuleCases();
+        for (unsigned int c = 0; c < cases.size(); c++)
+        {
+            if (!selected(cases[c].name, opts))
+                continue;
+            for (unsigned int r = 0; r < opts.rates.size(); r++)
+                for (unsigned int t = 0; t < opts.tracks.size(); t++)
+                    benchModule(cases[c], opts.rates[r],
+                            evenTracks(opts.tracks[t], cases[c].pairs), opts);
+        }
+    }
+
+    if (opts.models)
+    {
+        vector<ModelCase> cases = getModelCases();
+        for (unsigned int c = 0; c < cases.size(); c++)
+        {
+            if (!selected(cases[c].name, opts))
+                continue;
+            for (unsigned int r = 0; r < opts.rates.size(); r++)
+                for (unsigned int t = 0; t < opts.tracks.size(); t++)
+                    benchModel(cases[c], opts.rates[r],
+                            evenTracks(opts.tracks[t], cases[c].pairs), opts);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+// test signals and checks shared by the cppTests
+// include from a test in this directory: #include "TestSignals.h"
+
+#ifndef TESTSIGNALS_H
+#define TESTSIGNALS_H
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <loudness/Support/TrackBank.h>
+
+// 24 pseudo-random bits, advancing a linear congruential generator
+inline unsigned int randomBits(unsigned int &seed)
+{
+	seed = seed * 1103515245u + 12345u;
+	return seed >> 8;
+}
+
+// uniform noise in [-0.5, 0.5)
+inline Real noise(unsigned int &seed)
+{
+	return (randomBits(seed) & 0xffff) / 65536.0 - 0.5;
+}
+
+// noise plus a tone per track (250 Hz times the track number, counting from
+// 1) in channel 0 of every track, for samples start to start + nSamples - 1
+inline void fillNoiseAndTones(loudness::TrackBank &bank, int start, unsigned int &seed)
+{
+	for (int track = 0; track < bank.getNTracks(); track++)
+	{
+		for (int i = 0; i < bank.getNSamples(); i++)
+		{
+			int n = start + i;
+			bank.setSample(track, 0, i, 0.02 * (track + 1) * noise(seed) +
+					0.1 * sin(2 * PI * 250.0 * (track + 1) * n / bank.getFs()));
+		}
+	}
+}
+
+// prints one result line and returns 1 on failure
+inline int check(const std::string &name, bool ok)
+{
+	std::cout << name << ": " << (ok ? "ok" : "FAILED") << std::endl;
+	return !ok;
+}
+
+// as check(), for outputs that must be bit-identical
+inline int checkIdentical(const std::string &name, const std::vector<Real> &a,
+		const std::vector<Real> &b)
+{
+	bool same = !a.empty() && (a == b);
+	std::cout << name << ": " << (same ? "identical" : "DIFFERENT") << std::endl;
+	return !same;
+}
+
+#endif
@@ -0,0 +1,66 @@
+// checks fixed_knot_spline against the band matrix spline it replaces in
+// FastRoexBank, on the knots and query points used there
+// first build and install library, then compile this file
+// compile using g++ -std=c++11 test_FixedKnotSpline.cpp -lloudness
+
+#include <loudness/Support/Spline.h>
+#include "TestSignals.h"
+
+int main()
+{
+	// the splines should agree to rounding error (about 5e-16 in double and
+	// 3e-7 in single precision); the bound is relative to the largest value
+	// interpolated
+	const Real bound = sizeof(Real) == sizeof(double) ? 1e-12 : 1e-5;
+
+	// FastRoexBank interpolates 372 points 0.1 Cam apart from filters
+	// camStep apart, starting at 1.8 Cam
+	std::vector<Real> queries(372);
+	for (int i = 0; i < 372; i++)
+		queries[i] = 1.8 + i * 0.1;
+
+	const Real camSteps[] = {0.25, 0.5, 0.75, 1.0};
+	unsigned int seed = 1;
+	int nFailed = 0;
+	for (int c = 0; c < 4; c++)
+	{
+		int nKnots = 1 + (int)((39.0 - 1.8) / camSteps[c]);
+		std::vector<Real> knots(nKnots);
+		for (int k = 0; k < nKnots; k++)
+			knots[k] = 1.8 + k * camSteps[c];
+
+		loudness::fixed_knot_spline fixed;
+		fixed.set_knots(knots);
+		fixed.set_queries(queries);
+
+		Real maxError = 0;
+		for (int pattern = 0; pattern < 50; pattern++)
+		{
+			// excitation patterns in dB: a peak over a noisy floor
+			std::vector<Real> y(nKnots);
+			Real peak = knots[pattern % nKnots];
+			for (int k = 0; k < nKnots; k++)
+			{
+				Real d = knots[k] - peak;
+				y[k] = 90 * exp(-d * d / 8.0) - 20 + 10 * noise(seed);
+			}
+
+			loudness::spline banded;
+			banded.set_points(knots, y);
+			std::vector<Real> out(queries.size());
+			fixed.interpolate(&y[0], &out[0]);
+
+			Real scale = 0;
+			for (int k = 0; k < nKnots; k++)
+				scale = std::max(scale, (Real)fabs(y[k]));
+			for (unsigned int i = 0; i < queries.size(); i++)
+				maxError = std::max(maxError, (Real)(fabs(out[i] - banded(queries[i])) / scale));
+		}
+
+		bool ok = maxError <= bound;
+		std::cout << "Cam step " << camSteps[c] << ": largest relative difference "
+			<< maxError << (ok ? "" : ", ABOVE BOUND") << std::endl;
+		nFailed += !ok;
+	}
+	return nFailed ? 1 : 0;
+}
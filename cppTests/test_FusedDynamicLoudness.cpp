@@ -0,0 +1,84 @@
+// checks that a fused DynamicLoudnessGM (Model::setFused()) gives bit-identical
+// loudness to the unfused chain, and the same specific loudness when that
+// output is requested with Model::requestModuleOutput()
+// first build and install library, then compile this file
+// compile using g++ -std=c++11 test_FusedDynamicLoudness.cpp -lloudness
+
+#include <algorithm>
+#include <loudness/Models/DynamicLoudnessGM.h>
+#include "TestSignals.h"
+
+// every sample of @a bank appended to @a out
+void append(const loudness::TrackBank &bank, std::vector<Real> &out)
+{
+	for (int track = 0; track < bank.getNTracks(); track++)
+		for (int chn = 0; chn < bank.getNChannels(); chn++)
+			for (int i = 0; i < bank.getNSamples(); i++)
+				out.push_back(bank.getSample(track, chn, i));
+}
+
+// the loudness (last module) and the specific loudness (the module before it)
+// of every track and hop; unless requested, only the final specific loudness,
+// which is never written when fused
+void run(loudness::DynamicLoudnessGM::ParameterSet set, bool fused,
+		bool requestSpecific, int nHops, std::vector<Real> &output,
+		std::vector<Real> &specific)
+{
+	loudness::TrackBank hop;
+	hop.initialize(3, 1, 44, 44100);
+
+	// module indices are only known once a model has been initialised
+	loudness::DynamicLoudnessGM probe;
+	probe.loadParameterSet(set);
+	probe.initialize(hop);
+	const int last = probe.getNModules() - 1;
+
+	loudness::DynamicLoudnessGM model;
+	model.loadParameterSet(set);
+	model.setFused(fused);
+	if (requestSpecific)
+		model.requestModuleOutput(last - 1);
+	model.initialize(hop);
+
+	unsigned int seed = 1;
+	for (int hopIdx = 0; hopIdx < nHops; hopIdx++)
+	{
+		fillNoiseAndTones(hop, hopIdx * hop.getNSamples(), seed);
+		model.process(hop);
+		append(*model.getModuleOutput(last), output);
+		if (requestSpecific)
+			append(*model.getModuleOutput(last - 1), specific);
+	}
+	if (!requestSpecific)
+		append(*model.getModuleOutput(last - 1), specific);
+}
+
+int main()
+{
+	const int nHops = 300;
+	const loudness::DynamicLoudnessGM::ParameterSet sets[] =
+		{loudness::DynamicLoudnessGM::GM02, loudness::DynamicLoudnessGM::FASTER1};
+
+	int nFailed = 0;
+	for (int s = 0; s < 2; s++)
+	{
+		std::vector<Real> output, specific, fusedOutput, fusedSpecific,
+			requestedOutput, requestedSpecific;
+		run(sets[s], false, true, nHops, output, specific);
+		run(sets[s], true, false, nHops, fusedOutput, fusedSpecific);
+		run(sets[s], true, true, nHops, requestedOutput, requestedSpecific);
+
+		// an unrequested fused output stays as initialised (zeros)
+		bool unwritten = std::count(fusedSpecific.begin(), fusedSpecific.end(), 0.0) ==
+			(int)fusedSpecific.size();
+
+		std::string name = "parameter set " + std::to_string(sets[s]) + ", fused ";
+		nFailed += check(name + "specific loudness not written", unwritten);
+		nFailed += check(name + "loudness identical", fusedOutput == output);
+		nFailed += check(name + "loudness identical with specific loudness requested",
+				requestedOutput == output);
+		nFailed += check(name + "requested specific loudness identical",
+				!specific.empty() && (requestedSpecific == specific));
+	}
+	return nFailed ? 1 : 0;
+}
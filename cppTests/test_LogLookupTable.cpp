@@ -0,0 +1,80 @@
+// checks that LogLookupTable::getMaxError() bounds the error of the tables
+// against exact power laws, sampled far more densely than getMaxError() does
+// first build and install library, then compile this file
+// compile using g++ -std=c++11 test_LogLookupTable.cpp -lloudness
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <loudness/Support/LogLookupTable.h>
+
+int main()
+{
+	// getMaxError() samples three points per segment, which misses the peak
+	// of the error by under 10%; rounding adds a few ulps (and the AVX2 array
+	// lookup may round differently to the single lookup)
+	const Real factor = 1.25;
+	const Real epsilon = 8 * std::numeric_limits<Real>::epsilon();
+	const int nDense = 64, lowOctave = -40, highOctave = 40;
+
+	// power laws with the exponents of the specific loudness mappings
+	const Real exponents[] = {0.2, 0.25, 0.3, 0.5, 1.5};
+	const int nFunctions = 5;
+	auto function = [&](int k, Real x)
+	{
+		return (Real)pow(x, exponents[k]);
+	};
+
+	int nFailed = 0;
+	for (int n = 4; n <= 64; n *= 2)
+	{
+		loudness::LogLookupTable table;
+		if (!table.initialize(nFunctions, lowOctave, highOctave, n))
+			return 1;
+		table.fill(function);
+		Real maxError = table.getMaxError(function);
+		Real bound = factor * maxError + epsilon;
+
+		// nDense points per segment, looked up one at a time and as an array
+		int nSegments = (highOctave - lowOctave) * n;
+		std::vector<Real> x(nSegments * nDense), y(x.size()), scale(x.size(), 1.0);
+		std::vector<int> functions(x.size());
+		Real singleError = 0, arrayError = 0;
+		for (int k = 0; k < nFunctions; k++)
+		{
+			for (int s = 0; s < nSegments; s++)
+			{
+				Real x0 = table.getSegmentStart(s);
+				Real width = table.getSegmentStart(s + 1) - x0;
+				for (int i = 0; i < nDense; i++)
+					x[s * nDense + i] = x0 + width * (i + 0.5) / nDense;
+			}
+			std::fill(functions.begin(), functions.end(), k);
+			table.lookup(&x[0], &scale[0], &functions[0], &y[0], x.size());
+			for (unsigned int i = 0; i < x.size(); i++)
+			{
+				Real exact = function(k, x[i]);
+				singleError = std::max(singleError, (Real)fabs(table.lookup(k, x[i]) / exact - 1));
+				arrayError = std::max(arrayError, (Real)fabs(y[i] / exact - 1));
+			}
+		}
+
+		// below the table gives 0, above it is clamped to the top
+		Real below = ldexp((Real)1.0, lowOctave - 1);
+		Real above = ldexp((Real)1.0, highOctave + 1);
+		Real top = ldexp((Real)1.0, highOctave);
+		bool rangeOk = true;
+		for (int k = 0; k < nFunctions; k++)
+			rangeOk = rangeOk && (table.lookup(k, below) == 0) &&
+				(fabs(table.lookup(k, above) / function(k, top) - 1) <= bound);
+
+		bool ok = rangeOk && (singleError <= bound) && (arrayError <= bound);
+		std::cout << n << " segments per octave: getMaxError " << maxError
+			<< ", dense " << singleError << " (single) " << arrayError << " (array)"
+			<< (rangeOk ? "" : ", WRONG OUTSIDE THE TABLE")
+			<< (ok || !rangeOk ? "" : ", ABOVE BOUND") << std::endl;
+		nFailed += !ok;
+	}
+	return nFailed ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+// checks that a MirroredRing mirrored by copying gives the same contiguous
+// windows as one mirrored by the virtual memory mapping (memfd on Linux)
+// first build and install library, then compile this file
+// compile using g++ -std=c++11 test_MirroredRing.cpp -lloudness
+
+#include <loudness/Support/MirroredRing.h>
+#include "TestSignals.h"
+
+int main()
+{
+	const int nTracks = 3, minSize = 3000, nWrites = 2000;
+
+	loudness::MirroredRing mapped, copied;
+	if (!mapped.initialize(nTracks, minSize) || !copied.initialize(nTracks, minSize, false))
+		return 1;
+	const int size = mapped.getSize();
+	std::cout << "ring of " << size << " samples, "
+		<< (mapped.isMirrored() ? "mapped" : "mapping not available, both copied")
+		<< std::endl;
+	if ((copied.getSize() != size) || copied.isMirrored())
+		return 1;
+
+	// every sample written to each track, to check the windows against
+	std::vector<std::vector<Real> > history(nTracks, std::vector<Real>(size, 0.0));
+	std::vector<Real> x(size);
+	unsigned int seed = 1;
+	int writeIdx = 0, nFailed = 0;
+	for (int write = 0; write < nWrites; write++)
+	{
+		// lengths from a single sample up to a whole ring, wrapping freely
+		int nSamples = 1 + randomBits(seed) % (write % 4 ? 64 : size);
+		for (int track = 0; track < nTracks; track++)
+		{
+			for (int i = 0; i < nSamples; i++)
+				x[i] = history[track].size() + i + track;
+			mapped.write(track, writeIdx, &x[0], nSamples);
+			copied.write(track, writeIdx, &x[0], nSamples);
+			history[track].insert(history[track].end(), x.begin(), x.begin() + nSamples);
+		}
+		writeIdx = (writeIdx + nSamples) % size;
+
+		// the last size samples, and a shorter window ending earlier, read
+		// without wrapping from both rings
+		for (int track = 0; track < nTracks; track++)
+		{
+			const std::vector<Real> &h = history[track];
+			const int lengths[] = {size, size / 3};
+			const int lags[] = {0, size - size / 3};
+			for (int w = 0; w < 2; w++)
+			{
+				int start = (writeIdx - lengths[w] - lags[w] + 2 * size) % size;
+				const Real *a = mapped.getTrackPointer(track) + start;
+				const Real *b = copied.getTrackPointer(track) + start;
+				const Real *expected = &h[h.size() - lengths[w] - lags[w]];
+				for (int i = 0; i < lengths[w]; i++)
+				{
+					if ((a[i] != expected[i]) || (b[i] != expected[i]))
+					{
+						nFailed++;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	mapped.clear();
+	copied.clear();
+	for (int track = 0; track < nTracks; track++)
+	{
+		for (int i = 0; i < 2 * size; i++)
+		{
+			if ((mapped.getTrackPointer(track)[i] != 0) || (copied.getTrackPointer(track)[i] != 0))
+			{
+				nFailed++;
+				break;
+			}
+		}
+	}
+
+	return check(std::to_string(nWrites) + " writes and clear(), windows of both rings",
+			nFailed == 0);
+}
@@ -0,0 +1,102 @@
+// checks that a pipelined DynamicLoudnessGM (Model::setPipelined()) gives the
+// same output as the serial chain after flush(), processBlock() and reset()
+// first build and install library, then compile this file
+// compile using g++ -std=c++11 test_PipelinedDynamicLoudness.cpp -lloudness
+
+#include <loudness/Models/DynamicLoudnessGM.h>
+#include "TestSignals.h"
+
+// noise plus a tone per track, seeded by the first sample of the block
+void fillBlock(loudness::TrackBank &block, int start)
+{
+	unsigned int seed = 1 + start;
+	fillNoiseAndTones(block, start, seed);
+}
+
+struct Config
+{
+	bool pipelined;
+	int modulesPerStage, queueLength;
+};
+
+void setUp(loudness::DynamicLoudnessGM &model, const Config &config, const loudness::TrackBank &input)
+{
+	model.loadParameterSet(loudness::DynamicLoudnessGM::FASTER1);
+	model.setPipelined(config.pipelined, config.modulesPerStage, config.queueLength);
+	model.initialize(input);
+}
+
+// loudness of every hop, flushing the pipeline after each one; with a
+// number of hops to process before a reset, the run starts after the reset
+std::vector<Real> runHops(const Config &config, int nHops, int nHopsBeforeReset)
+{
+	const int hopSize = 44;
+	loudness::TrackBank hop;
+	hop.initialize(3, 1, hopSize, 44100);
+	loudness::DynamicLoudnessGM model;
+	setUp(model, config, hop);
+	const loudness::TrackBank *output = model.getModuleOutput(model.getNModules() - 1);
+
+	for (int hopIdx = 0; hopIdx < nHopsBeforeReset; hopIdx++)
+	{
+		fillBlock(hop, (nHops + hopIdx) * hopSize);
+		model.process(hop);
+	}
+	if (nHopsBeforeReset)
+		model.reset();
+
+	std::vector<Real> out;
+	for (int hopIdx = 0; hopIdx < nHops; hopIdx++)
+	{
+		fillBlock(hop, hopIdx * hopSize);
+		model.process(hop);
+		model.flush();
+		for (int track = 0; track < output->getNTracks(); track++)
+			for (int chn = 0; chn < output->getNChannels(); chn++)
+				out.push_back(output->getSample(track, chn, 0));
+	}
+	return out;
+}
+
+// loudness of every frame, processing blocks of many hops without flushing
+std::vector<Real> runBlocks(const Config &config, int nBlocks)
+{
+	const int blockSize = 1000;
+	loudness::TrackBank block;
+	block.initialize(3, 1, blockSize, 44100);
+	loudness::DynamicLoudnessGM model;
+	setUp(model, config, block);
+
+	std::vector<Real> out;
+	for (int blockIdx = 0; blockIdx < nBlocks; blockIdx++)
+	{
+		fillBlock(block, blockIdx * blockSize);
+		const loudness::TrackBank &frames = model.processBlock(block);
+		for (int track = 0; track < frames.getNTracks(); track++)
+			for (int frame = 0; frame < frames.getNChannels(); frame++)
+				for (int i = 0; i < frames.getNSamples(); i++)
+					out.push_back(frames.getSample(track, frame, i));
+	}
+	return out;
+}
+
+int main()
+{
+	const Config serial = {false, 1, 8};
+	const Config pipelines[] = {{true, 1, 8}, {true, 2, 8}, {true, 1, 1}};
+	const int nHops = 200, nBlocks = 10;
+
+	std::vector<Real> serialHops = runHops(serial, nHops, 0);
+	std::vector<Real> serialBlocks = runBlocks(serial, nBlocks);
+
+	int nFailed = checkIdentical("serial after reset", runHops(serial, nHops, 50), serialHops);
+	for (int p = 0; p < 3; p++)
+	{
+		std::string name = "pipelined, " + std::to_string(pipelines[p].modulesPerStage) +
+			" module(s) per stage, queue " + std::to_string(pipelines[p].queueLength);
+		nFailed += checkIdentical(name + ", flush", runHops(pipelines[p], nHops, 0), serialHops);
+		nFailed += checkIdentical(name + ", reset", runHops(pipelines[p], nHops, 50), serialHops);
+		nFailed += checkIdentical(name + ", processBlock", runBlocks(pipelines[p], nBlocks), serialBlocks);
+	}
+	return nFailed ? 1 : 0;
+}
@@ -0,0 +1,54 @@
+// checks that DynamicLoudnessGM gives bit-identical output when its tracks
+// are processed in parallel (Model::setNThreads()) and serially
+// first build and install library, then compile this file
+// compile using g++ -std=c++11 test_ThreadedDynamicLoudness.cpp -lloudness
+
+#include <loudness/Models/DynamicLoudnessGM.h>
+#include "TestSignals.h"
+
+// instantaneous, short-term and long-term loudness of every track and hop
+std::vector<Real> run(loudness::DynamicLoudnessGM::ParameterSet set,
+		int nThreads, int nTracks, int nHops)
+{
+	loudness::TrackBank hop;
+	hop.initialize(nTracks, 1, 44, 44100);
+
+	loudness::DynamicLoudnessGM model;
+	model.loadParameterSet(set);
+	model.setNThreads(nThreads);
+	model.initialize(hop);
+	const loudness::TrackBank *output = model.getModuleOutput(model.getNModules() - 1);
+
+	std::vector<Real> out;
+	unsigned int seed = 1;
+	for (int hopIdx = 0; hopIdx < nHops; hopIdx++)
+	{
+		fillNoiseAndTones(hop, hopIdx * hop.getNSamples(), seed);
+		model.process(hop);
+		for (int track = 0; track < output->getNTracks(); track++)
+			for (int chn = 0; chn < output->getNChannels(); chn++)
+				out.push_back(output->getSample(track, chn, 0));
+	}
+	return out;
+}
+
+int main()
+{
+	const int nTracks = 7, nHops = 300;
+	const loudness::DynamicLoudnessGM::ParameterSet sets[] =
+		{loudness::DynamicLoudnessGM::GM02, loudness::DynamicLoudnessGM::FASTER1};
+	const int threads[] = {2, 3, 8};
+
+	int nFailed = 0;
+	for (int s = 0; s < 2; s++)
+	{
+		std::vector<Real> serial = run(sets[s], 1, nTracks, nHops);
+		for (int t = 0; t < 3; t++)
+		{
+			nFailed += checkIdentical("parameter set " + std::to_string(sets[s]) + ", " +
+					std::to_string(threads[t]) + " threads",
+					run(sets[s], threads[t], nTracks, nHops), serial);
+		}
+	}
+	return nFailed ? 1 : 0;
+}
@@ -24,6 +24,7 @@
 #include "../Modules/FIR.h"
 #include "../Modules/IIR.h"
 #include "../Modules/PowerSpectrum.h"
+#include "../Modules/SlidingPowerSpectrum.h"
 #include "../Modules/GoertzelPS.h"
 #include "../Modules/CompressSpectrum.h"
 #include "../Modules/WeightSpectrum.h"
@@ -72,6 +73,23 @@ namespace loudness{
     {
         uniform_ = uniform;
     }
+    void DynamicLoudnessGM::setSlidingSpectrum(bool slidingSpectrum)
+    {
+        slidingSpectrum_ = slidingSpectrum;
+    }
+    void DynamicLoudnessGM::setAutotuneSpectrum(bool autotuneSpectrum)
+    {
+        autotuneSpectrum_ = autotuneSpectrum;
+    }
+    void DynamicLoudnessGM::setRoexLevelResolution(Real roexLevelResolution)
+    {
+        roexLevelResolution_ = roexLevelResolution;
+    }
+    void DynamicLoudnessGM::setSpecificLoudnessTableTolerance(
+            Real specificLoudnessTableTolerance)
+    {
+        specificLoudnessTableTolerance_ = specificLoudnessTableTolerance;
+    }
     void DynamicLoudnessGM::setInterpRoexBank(bool interpRoexBank)
     {
         interpRoexBank_ = interpRoexBank;
@@ -112,6 +130,10 @@ namespace loudness{
         setGoertzel(false);
         setDiotic(true);
         setUniform(true);
+        setSlidingSpectrum(false);
+        setAutotuneSpectrum(false);
+        setRoexLevelResolution(0);
+        setSpecificLoudnessTableTolerance(0);
         setInterpRoexBank(false);
         setFilterSpacing(0.25);
         setCompressionCriterion(0.0);
@@ -131,7 +153,7 @@ namespace loudness{
         }
     }
 
-    bool DynamicLoudnessGM::initializeInternal(const SignalBank &input)
+    bool DynamicLoudnessGM::initializeInternal(const TrackBank &input)
     {
         /*
          * Outer-Middle ear filter 
@@ -158,15 +180,15 @@ namespace loudness{
 
             //load numpy array holding the filter coefficients
             cnpy::NpyArray arr = cnpy::npy_load(pathToFilterCoefs_);
-            Real *data = reinterpret_cast<Real*> (arr.data);
+            vector<double> data = cnpy::npy_data_as<double>(arr);
 
             //check if filter is IIR or FIR
             bool iir = false;
             if(arr.shape[0]==2)
                 iir = true;
 
-            //load the coefficients
-            RealVec bCoefs, aCoefs;
+            //load the coefficients (always double precision, see FilterBank)
+            vector<double> bCoefs, aCoefs;
             for(unsigned int i=0; i<arr.shape[1];i++)
             {
                 bCoefs.push_back(data[i]);
@@ -177,13 +199,13 @@ namespace loudness{
             //create module
             if(iir)
                 modules_.push_back(unique_ptr<Module> 
-                        (new IIR(bCoefs, aCoefs))); 
+                        (new IIR(input.getNTracks(), bCoefs, aCoefs))); 
             else
                 modules_.push_back(unique_ptr<Module>
                         (new FIR(bCoefs))); 
 
             //clean up
-            delete [] data;
+            arr.destruct();
         }
 
         /*
@@ -206,15 +228,24 @@ namespace loudness{
         RealVec windowSizeSecs {0.064, 0.032, 0.016, 0.008, 0.004, 0.002};
         
         //create module
-        if(goertzel_)
+        if(goertzel_ && (slidingSpectrum_ || autotuneSpectrum_))
         {
+            LOUDNESS_WARNING(name_
+                    << ": Bank of Goertzels used, ignoring sliding spectrum and autotune.");
+        }
+        if(goertzel_)
             modules_.push_back(unique_ptr<Module> 
                     (new GoertzelPS(bandFreqsHz, windowSizeSecs, timeStep_))); 
+        else if(slidingSpectrum_ || autotuneSpectrum_)
+        {
+            SlidingPowerSpectrum *spectrum = 
+                new SlidingPowerSpectrum(bandFreqsHz, windowSizeSecs, uniform_);
+            spectrum->setAutotune(autotuneSpectrum_);
+            modules_.push_back(unique_ptr<Module> (spectrum)); 
         }
-        else{
+        else
             modules_.push_back(unique_ptr<Module> 
                     (new PowerSpectrum(bandFreqsHz, windowSizeSecs, uniform_))); 
-        }
 
         /*
          * Compression
@@ -253,20 +284,25 @@ namespace loudness{
          */
         if(fastBank_)
         {
-            modules_.push_back(unique_ptr<Module>
-                    (new FastRoexBank(filterSpacing_, interpRoexBank_)));
+            FastRoexBank *roexBank = new FastRoexBank(filterSpacing_,
+                    interpRoexBank_);
+            roexBank->setLevelResolution(roexLevelResolution_);
+            modules_.push_back(unique_ptr<Module>(roexBank));
         }
         else
         {
-            modules_.push_back(unique_ptr<Module> 
-                    (new RoexBankANSIS3407(1.8, 38.9, filterSpacing_)));
+            RoexBankANSIS3407 *roexBank = new RoexBankANSIS3407(1.8, 38.9,
+                    filterSpacing_);
+            roexBank->setLevelResolution(roexLevelResolution_);
+            modules_.push_back(unique_ptr<Module>(roexBank));
         }
         
         /*
          * Specific loudness
          */
-        modules_.push_back(unique_ptr<Module>
-                (new SpecificLoudnessGM));
+        SpecificLoudnessGM *specificLoudness = new SpecificLoudnessGM;
+        specificLoudness->setTableTolerance(specificLoudnessTableTolerance_);
+        modules_.push_back(unique_ptr<Module>(specificLoudness));
 
         /*
         * Loudness integration 
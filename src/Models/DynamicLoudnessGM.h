@@ -51,6 +51,25 @@ namespace loudness{
      * pattern can be interpolated to approximate the high resolution pattern.
      * If you want this, use setInterpRoexBank(true).
      *
+     * The fastest way of computing the power spectrum depends on the host.
+     * With setAutotuneSpectrum(true), each window of the spectrum is timed
+     * with the methods of SlidingPowerSpectrum (slid sums, Goertzel or FFT of
+     * the windowed segment) during initialisation and the fastest is kept.
+     * The output bins are those of PowerSpectrum. Uniform or non-uniform
+     * sampling (setUniform()) and the bank of Goertzels (setGoertzel()) are
+     * not candidates: they output different bins, and hence a different
+     * loudness. setGoertzel(true) overrides setAutotuneSpectrum(true).
+     *
+     * setRoexLevelResolution() reads the lower skirt weights of the roex
+     * filters from a cache of levels spaced by the given resolution in dB
+     * (see FastRoexBank::setLevelResolution()). 0 (default) evaluates them
+     * per frame.
+     *
+     * setSpecificLoudnessTableTolerance() maps excitation to specific
+     * loudness with tables accurate to the given relative error (see
+     * SpecificLoudnessGM::setTableTolerance()). 0 (default) evaluates the
+     * formulas exactly.
+     *
      * REFERENCES:
      *
      * Glasberg, B. R., & Moore, B. C. J. (1990). Derivation of Auditory Filter
@@ -102,6 +121,10 @@ namespace loudness{
             void setGoertzel(bool goertzel);
             void setDiotic(bool diotic);
             void setUniform(bool uniform);
+            void setSlidingSpectrum(bool slidingSpectrum);
+            void setAutotuneSpectrum(bool autotuneSpectrum);
+            void setRoexLevelResolution(Real roexLevelResolution);
+            void setSpecificLoudnessTableTolerance(Real specificLoudnessTableTolerance);
             void setInterpRoexBank(bool interpRoexBank);
             void setFilterSpacing(Real filterSpacing);
             void setCompressionCriterion(Real compressionCriterion);
@@ -112,11 +135,12 @@ namespace loudness{
             Real getTimeStep() const;
             
         private:
-            virtual bool initializeInternal(const SignalBank &input);
+            virtual bool initializeInternal(const TrackBank &input);
 
             int outerEarType_;
             Real timeStep_, filterSpacing_, compressionCriterion_;
-            bool ansiBank_, fastBank_, interpRoexBank_, uniform_, diotic_, goertzel_;
+            Real roexLevelResolution_, specificLoudnessTableTolerance_;
+            bool ansiBank_, fastBank_, interpRoexBank_, uniform_, slidingSpectrum_, autotuneSpectrum_, diotic_, goertzel_;
             bool hpf_, diffuseField_;
             string pathToFilterCoefs_;
 
@@ -24,6 +24,7 @@
 #include "../Modules/FIR.h"
 #include "../Modules/IIR.h"
 #include "../Modules/PowerSpectrum.h"
+#include "../Modules/SlidingPowerSpectrum.h"
 #include "../Modules/PowerSpectrumAndSpatialDetection.h"
 #include "../Modules/CompressSpectrum.h"
 #include "../Modules/WeightSpectrum.h"
@@ -72,6 +73,18 @@ namespace loudness{
     {
         uniform_ = uniform;
     }
+    void DynamicPartialLoudnessGM::setSlidingSpectrum(bool slidingSpectrum)
+    {
+        slidingSpectrum_ = slidingSpectrum;
+    }
+    void DynamicPartialLoudnessGM::setAutotuneSpectrum(bool autotuneSpectrum)
+    {
+        autotuneSpectrum_ = autotuneSpectrum;
+    }
+    void DynamicPartialLoudnessGM::setRoexLevelResolution(Real roexLevelResolution)
+    {
+        roexLevelResolution_ = roexLevelResolution;
+    }
     void DynamicPartialLoudnessGM::setInterpRoexBank(bool interpRoexBank)
     {
         interpRoexBank_ = interpRoexBank;
@@ -117,6 +130,9 @@ namespace loudness{
         setGoertzel(false);
         setDiotic(true);
         setUniform(true);
+        setSlidingSpectrum(false);
+        setAutotuneSpectrum(false);
+        setRoexLevelResolution(0);
         setInterpRoexBank(false);
         setFilterSpacing(0.25);
         setCompressionCriterion(0.0);
@@ -164,15 +180,15 @@ namespace loudness{
 
             //load numpy array holding the filter coefficients
             cnpy::NpyArray arr = cnpy::npy_load(pathToFilterCoefs_);
-            Real *data = reinterpret_cast<Real*> (arr.data);
+            vector<double> data = cnpy::npy_data_as<double>(arr);
 
             //check if filter is IIR or FIR
             bool iir = false;
             if(arr.shape[0]==2)
                 iir = true;
 
-            //load the coefficients
-            RealVec bCoefs, aCoefs;
+            //load the coefficients (always double precision, see FilterBank)
+            vector<double> bCoefs, aCoefs;
             for(unsigned int i=0; i<arr.shape[1];i++)
             {
                 bCoefs.push_back(data[i]);
@@ -189,7 +205,7 @@ namespace loudness{
                         (new FIR(bCoefs))); 
 
             //clean up
-            delete [] data;
+            arr.destruct();
         }
 
         /*
@@ -211,9 +227,19 @@ namespace loudness{
         //create appropriate power spectrum module
         if(stereoToMono_)
         {
+            if(slidingSpectrum_ || autotuneSpectrum_)
+                LOUDNESS_WARNING(name_
+                        << ": Sliding spectrum is not available with stereo to mono conversion.");
             modules_.push_back(unique_ptr<Module> 
                     (new PowerSpectrumAndSpatialDetection(bandFreqsHz, windowSizeSecs, uniform_)));
         }
+        else if(slidingSpectrum_ || autotuneSpectrum_)
+        {
+            SlidingPowerSpectrum *spectrum =
+                new SlidingPowerSpectrum(bandFreqsHz, windowSizeSecs, uniform_);
+            spectrum->setAutotune(autotuneSpectrum_);
+            modules_.push_back(unique_ptr<Module>(spectrum));
+        }
         else
         {
             modules_.push_back(unique_ptr<Module>
@@ -248,13 +274,17 @@ namespace loudness{
          */
         if(fastBank_)
         {
-            modules_.push_back(unique_ptr<Module>
-                    (new FastRoexBank(filterSpacing_, interpRoexBank_)));
+            FastRoexBank *roexBank = new FastRoexBank(filterSpacing_,
+                    interpRoexBank_);
+            roexBank->setLevelResolution(roexLevelResolution_);
+            modules_.push_back(unique_ptr<Module>(roexBank));
         }
         else
         {
-            modules_.push_back(unique_ptr<Module> 
-                    (new RoexBankANSIS3407(1.8, 38.9, filterSpacing_)));
+            RoexBankANSIS3407 *roexBank = new RoexBankANSIS3407(1.8, 38.9,
+                    filterSpacing_);
+            roexBank->setLevelResolution(roexLevelResolution_);
+            modules_.push_back(unique_ptr<Module>(roexBank));
         }
         
         /*
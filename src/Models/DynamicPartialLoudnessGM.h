@@ -47,6 +47,19 @@ namespace loudness{
      * pattern can be interpolated to approximate the high resolution pattern.
      * If you want this, use setInterpRoexBank(true).
      *
+     * The fastest way of computing the power spectrum depends on the host.
+     * With setAutotuneSpectrum(true), each window of the spectrum is timed
+     * with the methods of SlidingPowerSpectrum (slid sums, Goertzel or FFT of
+     * the windowed segment) during initialisation and the fastest is kept.
+     * The output bins are those of PowerSpectrum. Uniform or non-uniform
+     * sampling (setUniform()) is not a candidate: it changes the bins, and
+     * hence the loudness.
+     *
+     * setRoexLevelResolution() reads the lower skirt weights of the roex
+     * filters from a cache of levels spaced by the given resolution in dB
+     * (see FastRoexBank::setLevelResolution()). 0 (default) evaluates them
+     * per frame.
+     *
      * REFERENCES:
      *
      * Glasberg, B. R., & Moore, B. C. J. (1990). Derivation of Auditory Filter
@@ -98,6 +111,9 @@ namespace loudness{
             void setGoertzel(bool goertzel);
             void setDiotic(bool diotic);
             void setUniform(bool uniform);
+            void setSlidingSpectrum(bool slidingSpectrum);
+            void setAutotuneSpectrum(bool autotuneSpectrum);
+            void setRoexLevelResolution(Real roexLevelResolution);
             void setInterpRoexBank(bool interpRoexBank);
             void setFilterSpacing(Real filterSpacing);
             void setCompressionCriterion(Real compressionCriterion);
@@ -113,7 +129,8 @@ namespace loudness{
 
             int outerEarType_;
             Real timeStep_, filterSpacing_, compressionCriterion_;
-            bool ansiBank_, fastBank_, interpRoexBank_, uniform_, diotic_, goertzel_, stereoToMono_;
+            Real roexLevelResolution_;
+            bool ansiBank_, fastBank_, interpRoexBank_, uniform_, slidingSpectrum_, autotuneSpectrum_, diotic_, goertzel_, stereoToMono_;
             bool hpf_, diffuseField_;
             string pathToFilterCoefs_;
 
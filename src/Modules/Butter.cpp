@@ -29,7 +29,7 @@ namespace loudness{
 
     Butter::Butter(int order, int type, Real fc) :
         Module("Butter"),
-        Filter(order),
+        FilterBank(order),
         type_(type),
         fc_(fc)
     {}
@@ -72,8 +72,10 @@ namespace loudness{
         //normalise by a[0]
         normaliseCoefs();
 
-        //delay line
-        z_.assign(2*order_,0.0);
+        //one delay line per track
+        setNTracks(input.getNTracks());
+        for (int track = 0; track < nTracks_; track++)
+            z_[track].assign(2*order_,0.0);
 
         //output TrackBank
         output_.initialize(input.getNTracks(), input.getNChannels(), input.getNSamples(), input.getFs());
@@ -83,34 +85,38 @@ namespace loudness{
 
     void Butter::processInternal(const TrackBank &input)
     {
-        for (int track = 0; track < input.getNTracks(); track++)
+        processTracks(input.getNTracks(), [&](int track, int)
         {
+            const Real *inputSignal = input.getSignalReadPointer(track, 0);
+            Real *outputSignal = output_.getSignalWritePointer(track, 0);
+            vector<double> &z = z_[track];
+
             switch(order_)
             {
                 case 3:
-                    Real x,y;
+                    double x,y;
                     for(int smp=0; smp<input.getNSamples(); smp++)
                     {
                         //input sample
-                        x = input.getSample(track, 0, smp) * gain_;
+                        x = inputSignal[smp] * gain_;
                         
                         //filter
-                        y = bCoefs_[0]*(x-z_[2]) + bCoefs_[2]*(z_[1]-z_[0]) - 
-                            aCoefs_[1]*z_[3] - aCoefs_[2]*z_[4] - aCoefs_[3]*z_[5];
+                        y = bCoefs_[0]*(x-z[2]) + bCoefs_[2]*(z[1]-z[0]) - 
+                            aCoefs_[1]*z[3] - aCoefs_[2]*z[4] - aCoefs_[3]*z[5];
 
                         //update delay line
-                        z_[5] = z_[4];
-                        z_[4] = z_[3];
-                        z_[3] = y;
-                        z_[2] = z_[1];
-                        z_[1] = z_[0];
-                        z_[0] = x;
+                        z[5] = z[4];
+                        z[4] = z[3];
+                        z[3] = y;
+                        z[2] = z[1];
+                        z[1] = z[0];
+                        z[0] = x;
 
                         //output sample
-                        output_.setSample(track, 0, smp, y);
+                        outputSignal[smp] = y;
                     }
             }
-        }
+        });
     }
     void Butter::resetInternal()
     {
@@ -20,11 +20,11 @@
 #ifndef  BUTTER_H
 #define  BUTTER_H
 
-#include "../Support/Filter.h"
+#include "../Support/FilterBank.h"
 
 namespace loudness{
 
-    class Butter : public Module, public Filter
+    class Butter : public Module, public FilterBank
     {
         public:
 
@@ -48,7 +48,7 @@ namespace loudness{
         int nChannels = input.getNChannels();
         int i=0, binIdxPrev = 0;
         Real dif = FreqToCam(input.getCentreFreq(1)) - FreqToCam(input.getCentreFreq(0));
-        int groupSize = std::max(2.0, floor(alpha_/(dif)));
+        int groupSize = std::max((Real)2.0, floor(alpha_/(dif)));
         int groupSizePrev = groupSize;
         vector<int> groupSizeStore, binIdx;
 
@@ -89,7 +89,7 @@ namespace loudness{
                 if(store<nChannels)
                 {
                     dif = FreqToCam(input.getCentreFreq(store)) - FreqToCam(input.getCentreFreq(store-1));
-                    groupSize = std::max((double)groupSize, floor(alpha_/dif));
+                    groupSize = std::max((Real)groupSize, floor(alpha_/dif));
                 }
 
                 //fill variables
@@ -173,8 +173,7 @@ namespace loudness{
 
     void CompressSpectrum::processInternal(const TrackBank &input)
     {
-
-        for (int track = 0; track < input.getNTracks(); track++)
+        processTracks(input.getNTracks(), [&](int track, int)
         {
             Real out = 0;
             int i = 0, j = 0;
@@ -190,7 +189,12 @@ namespace loudness{
                     out = 0;
                 }
             }
-        }
+        });
+    }
+
+    bool CompressSpectrum::isStateless() const
+    {
+        return 1;
     }
 
     void CompressSpectrum::resetInternal(){};
@@ -57,6 +57,8 @@ namespace loudness{
 
         virtual ~CompressSpectrum();
 
+        virtual bool isStateless() const;
+
     private:
         virtual bool initializeInternal(const TrackBank &input);
 
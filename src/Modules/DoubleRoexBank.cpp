@@ -107,11 +107,11 @@ namespace loudness{
         /*
          * Perform the excitation transformation
          */
-        Real excitationLinP, excitationLinA, excitationLog, gain,
-             excitationLogMinus30;
-
-        for (int track = 0; track < input.getNTracks(); track++)
+        processTracks(input.getNTracks(), [&](int track, int)
         {
+            Real excitationLinP, excitationLinA, excitationLog, gain,
+                 excitationLogMinus30;
+
             for(int i=0; i<nFilters_; i++)
             {
                 excitationLinP = 0.0;
@@ -146,7 +146,12 @@ namespace loudness{
                 //excitation pattern
                 output_.setSample(track, i, 0, excitationLinP + excitationLinA);
             }
-        }
+        });
+    }
+
+    bool DoubleRoexBank::isStateless() const
+    {
+        return 1;
     }
 
     void DoubleRoexBank::resetInternal(){};
@@ -34,6 +34,8 @@ namespace loudness{
 
         virtual ~DoubleRoexBank();
 
+        virtual bool isStateless() const;
+
     private:
 
         virtual bool initializeInternal(const TrackBank &input);
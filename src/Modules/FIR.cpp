@@ -23,7 +23,7 @@ namespace loudness{
 
     FIR::FIR() : Module("FIR") {}
 
-    FIR::FIR(const RealVec &bCoefs) :
+    FIR::FIR(const vector<double> &bCoefs) :
         Module("FIR")
     {
         setBCoefs(bCoefs);
@@ -40,6 +40,11 @@ namespace loudness{
             orderMinus1_ = order_-1;
             LOUDNESS_DEBUG("FIR: Filter order is: " << order_);
 
+            //one delay line per track
+            setNTracks(input.getNTracks());
+            for (int track = 0; track < nTracks_; track++)
+                z_[track].assign(order_,0.0);
+
             //output TrackBank
             output_.initialize(input.getNTracks(), input.getNChannels(), input.getNSamples(), input.getFs());
 
@@ -53,33 +58,33 @@ namespace loudness{
 
     void FIR::processInternal(const TrackBank &input)
     {
-        int smp, j;
-        Real x;
-
         LOUDNESS_DEBUG("FIR: New block");
-        for (int track = 0; track < input.getNTracks(); track++)
+        processTracks(input.getNTracks(), [&](int track, int)
         {
-            //delay line
-            z_.assign(order_,0.0);
-            
+            int smp, j;
+            double x;
+            const Real *inputSignal = input.getSignalReadPointer(track, 0);
+            Real *outputSignal = output_.getSignalWritePointer(track, 0);
+            vector<double> &z = z_[track];
+
             for(smp=0; smp<input.getNSamples(); smp++)
             {
                 //input sample
-                x = input.getSample(track, 0, smp) * gain_;
+                x = inputSignal[smp] * gain_;
 
                 LOUDNESS_DEBUG("FIR: Input sample: " << x);
 
                 //output sample
-                output_.setSample(track, 0, smp, bCoefs_[0] * x + z_[0]);
+                outputSignal[smp] = bCoefs_[0] * x + z[0];
 
                 //fill delay
                 for (j=1; j<order_; j++)
-                    z_[j-1] = bCoefs_[j] * x + z_[j];
+                    z[j-1] = bCoefs_[j] * x + z[j];
 
                 //final sample
-                z_[orderMinus1_] = bCoefs_[order_] * x;
+                z[orderMinus1_] = bCoefs_[order_] * x;
             }
-        }
+        });
     }
 
     void FIR::resetInternal()
@@ -20,7 +20,7 @@
 #ifndef FIR_H
 #define FIR_H
 
-#include "../Support/Filter.h"
+#include "../Support/FilterBank.h"
 
 /*
  * =====================================================================================
@@ -32,12 +32,12 @@
 
 namespace loudness{
 
-    class FIR : public Module, public Filter
+    class FIR : public Module, public FilterBank
     {
         public:
 
             FIR();
-            FIR(const RealVec &bCoefs);
+            FIR(const vector<double> &bCoefs);
 
             virtual ~FIR();
 
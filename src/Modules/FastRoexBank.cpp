@@ -19,17 +19,84 @@
 
 #include "FastRoexBank.h"
 #include "../Support/AuditoryTools.h"
+#include "../Support/SIMD.h"
+#include "../Support/SIMDMath.h"
 
 namespace loudness{
 
+LOUDNESS_SIMD_BEGIN
+    /*
+     * Excitation of one filter from nLower channels of its lower skirt and
+     * nUpper channels of its upper skirt. The lower skirt weights are
+     * evaluated into lowerWeights from g and the level per ERB (minus 51 dB)
+     * of each channel, with the same arithmetic as a direct evaluation, so
+     * they are identical. The loop has no branches or calls, so the compiler
+     * vectorises it (the table reads become gathers with AVX2).
+     */
+    template<class Ops>
+    static LOUDNESS_ALWAYS_INLINE Real skirtExcitation(const Real *lowerG,
+            const Real *level, const Real *lowerInput, int nLower, Real pu,
+            Real pl, Real step, int idxLimit, const Real *roexTable,
+            Real *lowerWeights, const Real *upperWeights,
+            const Real *upperInput, int nUpper)
+    {
+        for(int j=0; j<nLower; j++)
+        {
+            Real p = pu - (pl * level[j]);
+            p = p < 0.1 ? 0.1 : p; //p can go negative for very high levels
+            Real pg = -p * lowerG[j];
+            int idx = (int)(pg / step + 0.5);
+            idx = idx > idxLimit ? idxLimit : idx;
+            lowerWeights[j] = roexTable[idx];
+        }
+
+        return simd::dot<Ops>(lowerWeights, lowerInput, nLower)
+            + simd::dot<Ops>(upperWeights, upperInput, nUpper);
+    }
+
+    static Real skirtExcitationDefault(const Real *lowerG, const Real *level,
+            const Real *lowerInput, int nLower, Real pu, Real pl, Real step,
+            int idxLimit, const Real *roexTable, Real *lowerWeights,
+            const Real *upperWeights, const Real *upperInput, int nUpper)
+    {
+        return skirtExcitation<simd::Baseline<Real> >(lowerG, level,
+                lowerInput, nLower, pu, pl, step, idxLimit, roexTable,
+                lowerWeights, upperWeights, upperInput, nUpper);
+    }
+
+#if LOUDNESS_X86_DISPATCH
+    LOUDNESS_TARGET_AVX2 static Real skirtExcitationAVX2(const Real *lowerG,
+            const Real *level, const Real *lowerInput, int nLower, Real pu,
+            Real pl, Real step, int idxLimit, const Real *roexTable,
+            Real *lowerWeights, const Real *upperWeights,
+            const Real *upperInput, int nUpper)
+    {
+        return skirtExcitation<simd::AVX2<Real> >(lowerG, level,
+                lowerInput, nLower, pu, pl, step, idxLimit, roexTable,
+                lowerWeights, upperWeights, upperInput, nUpper);
+    }
+#endif
+LOUDNESS_SIMD_END
+
     FastRoexBank::FastRoexBank(Real camStep, bool interp) :
         Module("FastRoexBank"),
         camStep_(camStep),
+        levelResolution_(0),
         interp_(interp)
     {}
 
     FastRoexBank::~FastRoexBank() {}
 
+    void FastRoexBank::setLevelResolution(Real levelResolution)
+    {
+        levelResolution_ = levelResolution;
+    }
+
+    Real FastRoexBank::getLevelResolution() const
+    {
+        return levelResolution_;
+    }
+
     bool FastRoexBank::initializeInternal(const TrackBank &input)
     {
 
@@ -93,12 +160,12 @@ namespace loudness{
         //p lower is level dependent
         pl_.assign(nFilters_, 0.0);
 
-        //comp_level holds level per ERB on each component
-        compLevel_.assign(input.getNChannels(), 0.0);
+        //comp_level holds level per ERB on each component (one per worker)
+        compLevel_.assign(getNWorkers(), RealVec(input.getNChannels(), 0.0));
 
         //required for log interpolation
         if(interp_)
-            excitationLevel_.assign(nFilters_, 0.0);
+            excitationLevel_.assign(getNWorkers(), RealVec(nFilters_, 0.0));
         
         //centre freqs in cams
         cams_.assign(nFilters_, 0);
@@ -135,9 +202,117 @@ namespace loudness{
             pu_[i] = 4*fc_[i]/erb;
             pl_[i] = 0.35*(pu_[i]/p51_1k);
         }
+
+        //knots and query points are fixed, so factorise the spline once
+        if(interp_)
+        {
+            RealVec queryCams(372);
+            for(int i=0; i<372; i++)
+                queryCams[i] = 1.8 + i*0.1;
+            fixed_knot_spline s;
+            s.set_knots(cams_);
+            s.set_queries(queryCams);
+            splines_.assign(getNWorkers(), s);
+        }
         
         //generate lookup table for rounded exponential
         generateRoexTable(1024);
+
+        /*
+         * Sparse filter support. Channels with g < 0 form the lower skirt
+         * and those with 0 <= g <= 2 the upper skirt, whose weights are
+         * fixed. Input centre frequencies are in ascending order.
+         */
+        int nChannels = input.getNChannels();
+        centreChannel_.assign(nFilters_, 0);
+        upperClamp_.assign(nFilters_, 0);
+        upperEnd_.assign(nFilters_, 0);
+        upperOffset_.assign(nFilters_, 0);
+        lowerOffset_.assign(nFilters_, 0);
+        upperWeights_.clear();
+        lowerG_.clear();
+        for(int i=0; i<nFilters_; i++)
+        {
+            lowerOffset_[i] = lowerG_.size();
+            int j = 0;
+            Real g;
+            while((j < nChannels) && ((g = (input.getCentreFreq(j)-fc_[i])/fc_[i]) < 0))
+            {
+                lowerG_.push_back(g);
+                j++;
+            }
+            centreChannel_[i] = j;
+
+            //beyond the end of the table the weight is constant
+            upperOffset_[i] = upperWeights_.size();
+            upperClamp_[i] = -1;
+            while(j < nChannels)
+            {
+                g = (input.getCentreFreq(j)-fc_[i])/fc_[i];
+                if(g>2)
+                    break;
+                int idx = (int)(pu_[i]*g/step_ + 0.5);
+                if((idx >= roexIdxLimit_) && (upperClamp_[i] < 0))
+                    upperClamp_[i] = j;
+                if(upperClamp_[i] < 0)
+                    upperWeights_.push_back(roexTable_[idx]);
+                j++;
+            }
+            upperEnd_[i] = j;
+            if(upperClamp_[i] < 0)
+                upperClamp_[i] = j;
+        }
+
+        LOUDNESS_DEBUG(name_ << ": Stored " << upperWeights_.size()
+                << " upper skirt weights and " << lowerG_.size()
+                << " lower skirt deviations.");
+
+        spectrum_.assign(getNWorkers(), RealVec(nChannels, 0.0));
+        powerSum_.assign(getNWorkers(), RealVec(nChannels + 1, 0.0));
+        lowerWeights_.assign(getNWorkers(), RealVec(nChannels, 0.0));
+        excitation_.assign(getNWorkers(), RealVec(nFilters_, 0.0));
+        erbPower_.assign(getNWorkers(), RealVec(nChannels, 0.0));
+        if(interp_)
+            interpolated_.assign(getNWorkers(), RealVec(372, 0.0));
+
+        /*
+         * Level quantised lower skirt weights. Channel j is on the lower
+         * skirt of every filter from the first whose centre is above it. The
+         * levels span the floor of -151 up to where p reaches its minimum
+         * in every filter, beyond which the weights no longer change.
+         */
+        lowerSkirtCache_.clear();
+        if(levelResolution_ > 0)
+        {
+            vector<int> firstFilter(nChannels, nFilters_);
+            Real levelHi = -151.0;
+            for(int i=nFilters_-1; i>=0; i--)
+            {
+                for(int j=0; j<centreChannel_[i]; j++)
+                    firstFilter[j] = i;
+                Real level = (pu_[i] - 0.1) / pl_[i];
+                levelHi = level > levelHi ? level : levelHi;
+            }
+
+            if(lowerSkirtCache_.initialize(firstFilter, nFilters_, -151.0,
+                        levelHi, levelResolution_))
+            {
+                lowerSkirtCache_.fill([&](int j, int i, Real level)
+                {
+                    Real p = pu_[i] - (pl_[i] * level);
+                    p = p < 0.1 ? 0.1 : p;
+                    Real pg = -p * lowerG_[lowerOffset_[i] + j];
+                    int idx = (int)(pg / step_ + 0.5);
+                    idx = idx > roexIdxLimit_ ? roexIdxLimit_ : idx;
+                    return roexTable_[idx];
+                });
+            }
+            else
+            {
+                LOUDNESS_WARNING(name_
+                        << ": Evaluating lower skirts without the level cache.");
+            }
+        }
         
         return 1;
     }
@@ -145,78 +320,119 @@ namespace loudness{
 
     void FastRoexBank::processInternal(const TrackBank &input)
     {
-        /*
-         * Part 1: Obtain the level per ERB about each input component
-         */
         int nChannels = input.getNChannels();
+        const int inStride = input.getChannelStride();
+        const int outStride = output_.getChannelStride();
 
-        for (int track = 0; track < input.getNTracks(); track++)
+        processTracks(input.getNTracks(), [&](int track, int worker)
         {
+            const Real *inputSpectrum = input.getTrackReadPointer(track);
+            Real *outputExcitation = output_.getTrackWritePointer(track);
+            RealVec &compLevel = compLevel_[worker];
+
+            /*
+             * Part 1: Obtain the level per ERB about each input component
+             */
             int j = 0;
             int k = rectBinIndices_[0][0];
             Real runningSum = 0;
+            Real maxLevel = -151.0;
 
             for(int i=0; i<nChannels; i++)
             {
                 //running sum of component powers
                 while(j<rectBinIndices_[i][1])
-                    runningSum += input.getSample(track, j++, 0);
+                    runningSum += inputSpectrum[inStride * j++];
 
                 //subtract components outside the window
                 while(k<rectBinIndices_[i][0])
-                    runningSum -= input.getSample(track, k++, 0);
+                    runningSum -= inputSpectrum[inStride * k++];
 
-                //convert to dB, subtract 51 here to save operations later
-                if (runningSum < 1e-10)
-                    compLevel_[i] = -151.0;
+                compLevel[i] = runningSum;
+            }
+
+            //convert to dB, subtract 51 here to save operations later
+            Real *erbPower = &erbPower_[worker][0];
+            Log10Array(&compLevel[0], erbPower, nChannels);
+            for(int i=0; i<nChannels; i++)
+            {
+                if (compLevel[i] < 1e-10)
+                    compLevel[i] = -151.0;
                 else
-                    compLevel_[i] = 10*log10(runningSum)-51;
+                    compLevel[i] = 10*erbPower[i]-51;
+
+                if(compLevel[i] > maxLevel)
+                    maxLevel = compLevel[i];
 
-                LOUDNESS_DEBUG("FastRoexBank: ERB/dB : " << compLevel_[i]+1e-10);
+                LOUDNESS_DEBUG("FastRoexBank: ERB/dB : " << compLevel[i]+1e-10);
             }
-        }
 
-        for (int track = 0; track < input.getNTracks(); track++)
-        {
             /*
              * Part 2: Complete roex filter response and compute excitation per ERB
              */
-            Real g, p, pg, excitationLin;
-            int idx;
+
+            //contiguous input and its running sum
+            const Real *x = inputSpectrum;
+            if(inStride != 1)
+            {
+                for(int i=0; i<nChannels; i++)
+                    spectrum_[worker][i] = inputSpectrum[inStride * i];
+                x = &spectrum_[worker][0];
+            }
+            Real *powerSum = &powerSum_[worker][0];
+            for(int i=0; i<nChannels; i++)
+                powerSum[i + 1] = powerSum[i] + x[i];
+
+            const Real clampedWeight = roexTable_[roexIdxLimit_];
+            const bool avx2 = cpuHasAVX2();
+            const bool cached = lowerSkirtCache_.isInitialized();
+            Real *excitation = &excitation_[worker][0];
             for(int i=0; i<nFilters_; i++)
             {
-                excitationLin = 0;
-                int j = 0;
+                //channels beyond the end of the table share a weight
+                const int centre = centreChannel_[i];
+                const int lo = cached ? centre : firstLowerSkirtChannel(i, maxLevel);
+                Real excitationLin = clampedWeight * (powerSum[upperEnd_[i]]
+                        - powerSum[upperClamp_[i]]);
+                if(!cached)
+                    excitationLin += clampedWeight * powerSum[lo];
+
+                const Real *lowerG = &lowerG_[0] + lowerOffset_[i] + lo;
+                const Real *upperWeights = &upperWeights_[0] + upperOffset_[i];
+                const int nLower = centre - lo;
+                const int nUpper = upperClamp_[i] - centre;
+#if LOUDNESS_X86_DISPATCH
+                if(avx2)
+                    excitationLin += skirtExcitationAVX2(lowerG, &compLevel[0] + lo,
+                            x + lo, nLower, pu_[i], pl_[i], step_, roexIdxLimit_,
+                            &roexTable_[0], &lowerWeights_[worker][0],
+                            upperWeights, x + centre, nUpper);
+                else
+#endif
+                    excitationLin += skirtExcitationDefault(lowerG, &compLevel[0] + lo,
+                            x + lo, nLower, pu_[i], pl_[i], step_, roexIdxLimit_,
+                            &roexTable_[0], &lowerWeights_[worker][0],
+                            upperWeights, x + centre, nUpper);
 
-                while(j<nChannels)
-                {
-                    //normalised deviation
-                    g = (input.getCentreFreq(j)-fc_[i])/fc_[i];
-
-                    if(g>2)
-                        break;
-                    if(g<0) //lower skirt - level dependent
-                    {
-                        p = pu_[i]-(pl_[i]*compLevel_[j]); //51dB subtracted above
-                        p = p < 0.1 ? 0.1 : p; //p can go negative for very high levels
-                        pg = -p*g; 
-                    }
-                    else //upper skirt
-                    {
-                        pg = pu_[i]*g; 
-                    }
-                    
-                    //excitation
-                    idx = (int)(pg/step_ + 0.5);
-                    idx = idx > roexIdxLimit_ ? roexIdxLimit_ : idx;
-                    excitationLin += roexTable_[idx]*input.getSample(track, j++, 0); 
-                }
+                excitation[i] = excitationLin;
+            }
 
-                //excitation level
-                if(interp_)
-                    excitationLevel_[i] = log(excitationLin + 1e-10);
-                else
-                    output_.setSample(track, i, 0, excitationLin);
+            //lower skirts from the level cache
+            if(cached)
+                lowerSkirtCache_.accumulate(x, &compLevel[0], excitation);
+
+            //excitation level
+            if(interp_)
+            {
+                Real *excitationLevel = &excitationLevel_[worker][0];
+                for(int i=0; i<nFilters_; i++)
+                    excitationLevel[i] = excitation[i] + 1e-10;
+                LogArray(excitationLevel, excitationLevel, nFilters_);
+            }
+            else
+            {
+                for(int i=0; i<nFilters_; i++)
+                    outputExcitation[outStride * i] = excitation[i];
             }
 
             /*
@@ -225,14 +441,52 @@ namespace loudness{
              */
             if(interp_)
             {
-                spline_.set_points(cams_, excitationLevel_);
-                for(int i=0; i < 372; i++)
+                if(outStride == 1)
+                {
+                    splines_[worker].interpolate(&excitationLevel_[worker][0],
+                            outputExcitation, 1);
+                    ExpArray(outputExcitation, outputExcitation, 372);
+                }
+                else
                 {
-                    excitationLin = exp(spline_(1.8 + i*0.1));
-                    output_.setSample(track, i, 0, excitationLin);
+                    Real *interpolated = &interpolated_[worker][0];
+                    splines_[worker].interpolate(&excitationLevel_[worker][0],
+                            interpolated, 1);
+                    ExpArray(interpolated, interpolated, 372);
+                    for(int i=0; i < 372; i++)
+                        outputExcitation[outStride * i] = interpolated[i];
                 }
             }
+        });
+    }
+
+    int FastRoexBank::firstLowerSkirtChannel(int i, Real maxLevel) const
+    {
+        /*
+         * The level only lowers p, so p at the highest level bounds pg from
+         * below for every channel. Where that bound already reaches the end
+         * of the table, so does pg. |g| decreases with the channel index, so
+         * this region is a prefix of the lower skirt.
+         */
+        Real p = pu_[i] - (pl_[i] * maxLevel);
+        p = p < 0.1 ? 0.1 : p;
+        const Real *g = &lowerG_[lowerOffset_[i]];
+        int lo = 0, hi = centreChannel_[i];
+        while(lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            Real pg = -p * g[mid];
+            if((int)(pg / step_ + 0.5) >= roexIdxLimit_)
+                lo = mid + 1;
+            else
+                hi = mid;
         }
+        return lo;
+    }
+
+    bool FastRoexBank::isStateless() const
+    {
+        return 1;
     }
 
     void FastRoexBank::resetInternal(){};
@@ -22,6 +22,7 @@
 
 #include "../Support/Module.h"
 #include "../Support/Spline.h"
+#include "../Support/LevelWeightCache.h"
 
 /*
  * =====================================================================================
@@ -45,6 +46,31 @@ namespace loudness{
      * A lookup table is employed for the computing the rounded exponential
      * filter.
      *
+     * Everything that does not depend on level is computed at initialisation.
+     * The upper skirt of each filter is stored as a row of a sparse
+     * (compressed row) weight matrix over a contiguous range of input
+     * channels. For the level dependent lower skirt, only the normalised
+     * deviations g are stored. Beyond the end of the lookup table the roex
+     * weight is constant, so channels in that region contribute a
+     * constant times their summed power, which is taken from a running sum of
+     * the spectrum. For the upper skirt this region is fixed. For the lower
+     * skirt it is found each frame from the highest level in the spectrum.
+     * Per frame, each filter then costs one lower skirt evaluation over the
+     * channels close to its centre plus two dot products, using AVX2 when the
+     * processor supports it.
+     *
+     * With setLevelResolution(), the lower skirt weights are instead read
+     * from a LevelWeightCache holding them for every filter and channel at
+     * levels per ERB spaced by the resolution, interpolated linearly between
+     * levels. This removes the per pair weight evaluation at the cost of
+     * memory. If the cache would exceed its memory limit, the lower skirts
+     * are evaluated directly.
+     *
+     * If interp is true, the log excitation pattern is interpolated with a
+     * cubic spline onto a 0.1 Cam grid between 1.8 and 38.9. The knots and
+     * grid do not change, so the spline system is factorised at
+     * initialisation (see fixed_knot_spline).
+     *
      * This implementation follows a combination of:
      *
      * Glasberg, B. R., & Moore, B. C. J. (1990).  Derivation of Auditory Filter
@@ -62,6 +88,16 @@ namespace loudness{
 
         virtual ~FastRoexBank();
 
+        /**
+         * @brief Sets the level resolution in dB of cached lower skirt
+         * weights, or 0 (default) to evaluate them per frame.
+         */
+        void setLevelResolution(Real levelResolution);
+
+        Real getLevelResolution() const;
+
+        virtual bool isStateless() const;
+
     private:
 
         virtual bool initializeInternal(const TrackBank &input);
@@ -72,13 +108,37 @@ namespace loudness{
 
         void generateRoexTable(int size = 1024);
 
-        Real camStep_;
+        /*
+         * Index of the first lower skirt channel of filter i whose weight
+         * can be below the end of the table when no channel exceeds
+         * maxLevel (level per ERB minus 51 dB).
+         */
+        int firstLowerSkirtChannel(int i, Real maxLevel) const;
+
+        Real camStep_, levelResolution_;
         bool interp_;
         int nFilters_, roexIdxLimit_;
         Real step_;
         vector<vector<int> > rectBinIndices_;
-        RealVec cams_, pu_, pl_, fc_, compLevel_, roexTable_, excitationLevel_;
-        spline spline_;
+        RealVec cams_, pu_, pl_, fc_, roexTable_;
+        RealVecVec compLevel_, excitationLevel_;
+        vector<fixed_knot_spline> splines_;
+
+        /*
+         * Per filter: channels [0, centre) form the lower skirt and
+         * [centre, upperEnd) the upper skirt, of which the weights of
+         * [centre, upperClamp) are stored from upperOffset_ on. lowerG_ holds
+         * g for the lower skirt channels from lowerOffset_ on.
+         */
+        vector<int> centreChannel_, upperClamp_, upperEnd_;
+        vector<int> upperOffset_, lowerOffset_;
+        RealVec upperWeights_, lowerG_;
+
+        //per worker: contiguous input, running sum, lower skirt weights,
+        //excitation per filter, log10 of the ERB powers and the spline output
+        RealVecVec spectrum_, powerSum_, lowerWeights_, excitation_;
+        RealVecVec erbPower_, interpolated_;
+        LevelWeightCache lowerSkirtCache_;
     };
 }
 
@@ -18,6 +18,7 @@
  */
 
 #include "FrameGenerator.h"
+#include <algorithm>
 
 namespace loudness{
 
@@ -41,55 +42,32 @@ namespace loudness{
                     << ": Hop size cannot be greater than frame size");
             return 0;
         }
+        if(hopSize_ < 1)
+        {
+            LOUDNESS_ERROR(name_ << ": Hop size must be at least one sample");
+            return 0;
+        }
 
         //number of input samples per process call
         inputBufferSize_ = input.getNSamples();
-        
-        //Hop size checks
         LOUDNESS_DEBUG(name_ << ": Input buffer size in samples: " << inputBufferSize_);
-        if(inputBufferSize_ > hopSize_)
-        {
-            LOUDNESS_WARNING(name_ << 
-                    ": Hop size cannot be greater than input buffer size" 
-                    << "...automatically correcting.");
-        }
-        else if((hopSize_ % inputBufferSize_)>0)
-        {
-            LOUDNESS_WARNING(name_ << 
-                    ": Hop size is not an integer multiple of the input buffer size" 
-                    << "...automatically correcting.");
-        }
-        
-        hopSize_ = inputBufferSize_*ceil(hopSize_/(Real) inputBufferSize_);
         LOUDNESS_DEBUG(name_ << ": Hop size in samples: " << hopSize_);
-
         LOUDNESS_DEBUG(name_ << ": Frame size in samples: " << frameSize_);
     
-        //The audio buffer must also be an integer multiple of inputBufSize_
-        audioBufferSize_ = inputBufferSize_* ceil(frameSize_/(Real)inputBufferSize_);
-
-        //OK, allocate memory
+        //frames are extracted as soon as they are complete, so the audio
+        //buffer only needs to hold a single frame plus the samples written
+        //before the next one, during which the output still views the frame
         nTracks_ = input.getNTracks();
-        audioBuffer_.resize(nTracks_);
-        for (int track = 0; track < nTracks_; track++)
-            audioBuffer_[track].assign(audioBufferSize_, 0.0);
+        if(!audioBuffer_.initialize(nTracks_, frameSize_ + hopSize_))
+            return 0;
+        audioBufferSize_ = audioBuffer_.getSize();
 
         LOUDNESS_DEBUG(name_ << 
                 ": Audio buffer size in samples: " 
                 << audioBufferSize_);
         
-        //Number of frames until we reach the end of buffer
-        initNFramesFull_.assign(nTracks_, audioBufferSize_ / inputBufferSize_);
-        nFramesFull_.assign(nTracks_, hopSize_ / inputBufferSize_); //will be an int >= 1
-        LOUDNESS_DEBUG(name_
-                << ": Number of process calls until we can extract first frame: " 
-                << initNFramesFull_
-                << "\n Number of process calls until we can extract further frames: "
-                << nFramesFull_);
-
-        readIdx_.assign(nTracks_, 0);
-        writeIdx_.assign(nTracks_, 0);
-        count_.assign(nTracks_, 0);
+        writeIdx_ = 0;
+        nSamplesUntilFrame_ = frameSize_;
 
         //initialise the output signal
         output_.initialize(nTracks_, 1, frameSize_, input.getFs());
@@ -98,47 +76,82 @@ namespace loudness{
         return 1;
     }
 
-    void FrameGenerator::processInternal(const TrackBank &input)
+    void FrameGenerator::process(const TrackBank &input)
     {
+        if(initialized_ && input.getAndTrigs())
+        {
+#ifdef LOUDNESS_PROFILE
+            startProfile();
+            processInternal(input);
+            stopProfile();
+#else
+            processInternal(input);
+#endif
+        }
+    }
 
-        //fill internal buffer
-        for (int track=0; track < nTracks_; track++)
+    void FrameGenerator::processInternal(const TrackBank &input)
+    {
+        /*
+         * Frame k spans input samples [k * hopSize_, k * hopSize_ +
+         * frameSize_). The input is consumed in segments ending at the
+         * boundary of the next frame due, so any number of frames (including
+         * none) can be emitted from a single input buffer.
+         */
+        int nSamples = input.getNSamples();
+        int readPos = 0;
+        while(readPos < nSamples)
         {
-            for(int i=0; i<inputBufferSize_; i++)
-                audioBuffer_[track][writeIdx_[track]++] = input.getSample(track, 0, i);
-            //wrap write index
-            writeIdx_[track] = writeIdx_[track] % audioBufferSize_;
+            int segment = std::min(nSamples - readPos, nSamplesUntilFrame_);
+            int writeIdx = writeIdx_;
 
-            count_[track]++;
-            if(count_[track] == initNFramesFull_[track])
+            processTracks(nTracks_, [&](int track, int)
             {
-                LOUDNESS_DEBUG(name_ << ": readIdx_ : " << readIdx_[track]);
-
-                //output frame
-                for(int i=0; i<frameSize_; i++)
-                {
-                    output_.setSample(track, 0, i, audioBuffer_[track][readIdx_[track]++]);
-                    readIdx_[track] = readIdx_[track] % audioBufferSize_;
-                }
-                readIdx_[track] = (writeIdx_[track] + hopSize_) % audioBufferSize_;
+                audioBuffer_.write(track, writeIdx,
+                        input.getSignalReadPointer(track, 0, readPos), segment);
+            });
 
-                output_.setTrig(track, 1);
+            writeIdx_ = (writeIdx_ + segment) % audioBufferSize_;
+            readPos += segment;
+            nSamplesUntilFrame_ -= segment;
 
-                count_[track] = 0;
-                initNFramesFull_[track] = nFramesFull_[track];
+            if(nSamplesUntilFrame_ == 0)
+            {
+                emitFrame();
+                nSamplesUntilFrame_ = hopSize_;
             }
-            else
-                output_.setTrig(track, 0);
+        }
+    }
+
+    void FrameGenerator::emitFrame()
+    {
+        //the frame ends just before the write index and, thanks to the
+        //mirror, continues past the end of the ring without wrapping
+        int start = writeIdx_ - frameSize_;
+        if(start < 0)
+            start += audioBufferSize_;
+        output_.setView(audioBuffer_.getTrackPointer(0) + start,
+                audioBuffer_.getTrackStride());
+        for(int track=0; track<nTracks_; track++)
+            output_.setTrig(track, 1);
+
+        if(targetModule_)
+        {
+#ifdef LOUDNESS_PROFILE
+            pauseProfile();
+            targetModule_->process(output_);
+            resumeProfile();
+#else
+            targetModule_->process(output_);
+#endif
         }
     }
 
     void FrameGenerator::resetInternal()
     {
-        initNFramesFull_.assign(nTracks_, audioBufferSize_ / inputBufferSize_);
-        nFramesFull_.assign(nTracks_, hopSize_ / inputBufferSize_);
-        readIdx_.assign(nTracks_, 0);
-        writeIdx_.assign(nTracks_, 0);
-        count_.assign(nTracks_, 0);
+        audioBuffer_.clear();
+        writeIdx_ = 0;
+        nSamplesUntilFrame_ = frameSize_;
     }
 
     void FrameGenerator::setFrameSize(int frameSize)
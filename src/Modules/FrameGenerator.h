@@ -22,19 +22,28 @@
 
 #include "../Support/Module.h"
 #include "../Support/Common.h"
+#include "../Support/MirroredRing.h"
 
 namespace loudness{
 
     /**
      * @class FrameGenerator
      * 
-     * @brief Generates a frame of samples from an input TrackBank.
+     * @brief Generates frames of samples from an input TrackBank.
      *
-     * This algorithm was developed for use with PowerSpectrum. In the current
-     * (not so flexible) implementation, the number of samples in the input
-     * TrackBank cannot be greater than the hop size. If this happens, the hop
-     * size is automatically adjusted. Furthermore, the hop size must be less
-     * than or equal to the frame size. In general, stick to powers of two.
+     * This algorithm was developed for use with PowerSpectrum. Frame k spans
+     * input samples [k * hopSize, k * hopSize + frameSize) and is passed on to
+     * the target module as soon as its last sample arrives. The number of
+     * samples in the input TrackBank is independent of the hop size: a short
+     * input buffer may complete no frame at all, while a long one may
+     * complete several, each of which is processed by the target module
+     * before process() returns. The hop size must be less than or equal to
+     * the frame size.
+     *
+     * The input is buffered in a MirroredRing per track, so the samples of a
+     * frame are always contiguous in memory. The output TrackBank is a view
+     * of the current frame inside the ring (see TrackBank::setView()) rather
+     * than a copy of it, and remains valid until the next frame is emitted.
      *
      * @todo Check the implementation is read/write safe.
      *
@@ -73,17 +82,31 @@ namespace loudness{
          */
         int getHopSize() const;
 
+        /**
+         * @brief Returns the number of samples in the ring buffer of each
+         * track.
+         */
         int getAudioBufferSize() const;
 
+        /**
+         * @brief Buffers @a input and emits every frame completed by it.
+         *
+         * Overrides Module::process() because the output is passed to the
+         * target module once per frame rather than once per input buffer.
+         */
+        virtual void process(const TrackBank &input);
+
     private:
 
         virtual bool initializeInternal(const TrackBank &input);
         virtual void processInternal(const TrackBank &input);
         virtual void resetInternal();
 
+        void emitFrame();
+
         int frameSize_, hopSize_, audioBufferSize_, inputBufferSize_, nTracks_;
-        std::vector<int> count_, readIdx_, writeIdx_, initNFramesFull_, nFramesFull_;
-        RealVecVec audioBuffer_;
+        int writeIdx_, nSamplesUntilFrame_;
+        MirroredRing audioBuffer_;
     };
 }
 
@@ -1,7 +1,70 @@
 #include "GoertzelPS.h"
+#include <algorithm>
 
 namespace loudness{
-    
+
+    /*
+     * Applies nSamples of the comb filtered input to the resonators of a
+     * group. comb holds G samples (one per track) per time step and the
+     * states are interleaved [oscillator][track]. Two time steps are taken
+     * per pass so each state is loaded and stored once per pair of samples.
+     */
+    template<int G>
+    static void resonate(const double *coef, int nOscillators,
+            const double *comb, int nSamples, double *vPrev, double *vPrev2)
+    {
+        int s = 0;
+        for(; s + 1 < nSamples; s += 2)
+        {
+            const double *u0 = comb + s * G, *u1 = u0 + G;
+            for(int o=0; o<nOscillators; o++)
+            {
+                const double c = coef[o];
+                double *v1 = vPrev + o * G, *v2 = vPrev2 + o * G;
+                for(int l=0; l<G; l++)
+                {
+                    double v = u0[l] + c * v1[l] - v2[l];
+                    v2[l] = v;
+                    v1[l] = u1[l] + c * v - v1[l];
+                }
+            }
+        }
+        if(s < nSamples)
+        {
+            const double *u0 = comb + s * G;
+            for(int o=0; o<nOscillators; o++)
+            {
+                const double c = coef[o];
+                double *v1 = vPrev + o * G, *v2 = vPrev2 + o * G;
+                for(int l=0; l<G; l++)
+                {
+                    double v = u0[l] + c * v1[l] - v2[l];
+                    v2[l] = v1[l];
+                    v1[l] = v;
+                }
+            }
+        }
+    }
+
+    /*
+     * Approximate cost of a real FFT per point, relative to one resonator
+     * update. Measured with FFTW, sizes with prime factors beyond its
+     * codelets (> 16) are several times slower than log2(n) suggests.
+     */
+    static double fftCostPerPoint(int n)
+    {
+        double cost = 0.0;
+        for(int f=2; n>1; f++)
+        {
+            while(n % f == 0)
+            {
+                cost += f > 16 ? 5.5 * log2(f) : log2(f);
+                n /= f;
+            }
+        }
+        return cost;
+    }
+
     GoertzelPS::GoertzelPS(const RealVec& bandFreqsHz,
             const RealVec& windowSizeSecs,
             Real hopSizeSecs) :
@@ -9,18 +72,43 @@ namespace loudness{
             bandFreqsHz_(bandFreqsHz),
             windowSizeSecs_(windowSizeSecs),
             hopSizeSecs_(hopSizeSecs),
-            windowSpectrum_(true)
+            windowSpectrum_(true),
+            blockUpdate_(true)
     {}
 
-    GoertzelPS::~GoertzelPS() {}
+    GoertzelPS::~GoertzelPS()
+    {
+        destroyTransformBuffers();
+    }
+
+    void GoertzelPS::destroyTransformBuffers()
+    {
+        for(unsigned int i=0; i<transformInputBufs_.size(); i++)
+        {
+            LOUDNESS_FFTW(free)(transformInputBufs_[i]);
+            LOUDNESS_FFTW(free)(transformOutputBufs_[i]);
+        }
+        transformInputBufs_.clear();
+        transformOutputBufs_.clear();
+    }
 
     void GoertzelPS::setWindowSpectrum(bool windowSpectrum)
     {
         windowSpectrum_ = windowSpectrum;
     }
 
-    bool GoertzelPS::initializeInternal(const SignalBank &input)
-    {   
+    void GoertzelPS::setBlockUpdate(bool blockUpdate)
+    {
+        blockUpdate_ = blockUpdate;
+    }
+
+    int GoertzelPS::getHopSize() const
+    {
+        return hopSize_;
+    }
+
+    bool GoertzelPS::initializeInternal(const TrackBank &input)
+    {
         //number of windows
         nWindows_ = (int)windowSizeSecs_.size();
 
@@ -42,68 +130,45 @@ namespace loudness{
         {
             windowSizeSamps_[i] = round(fs*windowSizeSecs_[i]);
             LOUDNESS_DEBUG(name_
-                    << ": Window size in samples: " 
+                    << ": Window size in samples: "
                     << windowSizeSamps_[i]);
             if(windowSizeSamps_[i]>largestWindowSize_)
                 largestWindowSize_ = windowSizeSamps_[i];
         }
-        LOUDNESS_DEBUG(name_ 
-                << ": Largest window size: " 
+        LOUDNESS_DEBUG(name_
+                << ": Largest window size: "
                 << largestWindowSize_);
 
-        //for this implementation, input buffer size must be smaller than largest window
-        if(input.getNSamples() > largestWindowSize_)
-        {
-            LOUDNESS_ERROR(name_
-                    << ": Number of input samples is: " 
-                    << input.getNSamples() 
-                    << " but must be <= largest window size:" 
-                    << largestWindowSize_);
-            return 0;
-        }
-
-        //hop size must be integer multiple of audio block size
         hopSize_ = round(fs*hopSizeSecs_);
-        int blockSize = input.getNSamples();
-        if(hopSize_<blockSize)
-        {
-            LOUDNESS_DEBUG(name_
-                    << ": Hop size is less than "
-                    << "input buffer size, automatically correcting...");
-
-        }
-        else if(0!=(hopSize_%blockSize))
+        if(hopSize_ < 1)
         {
-            LOUDNESS_DEBUG(name_
-                    << ": Hop size is not a multiple of input "
-                    << "buffer size, automatically correcting...");
+            LOUDNESS_ERROR(name_ << ": Hop size must be at least one sample");
+            return 0;
         }
-        hopSize_ = blockSize*ceil(hopSize_/(Real)blockSize);
         LOUDNESS_DEBUG(name_
                 << ": Hop size in samples: " << hopSize_);
 
-        //initialize the delay line make integer multiple of blockSize
-        delayLineSize_ = blockSize*ceil(largestWindowSize_/(Real)blockSize) + hopSize_;
-        LOUDNESS_DEBUG(name_
-                << ": Delay line size: "
-                << delayLineSize_);
-        
-        //binLimits contains the desired bins indices (lo and hi) per band
-        vector<vector<int> > bandBinIndices(nWindows_);
-
         //appropriate delay for temporal alignment
-        temporalCentre_ = (largestWindowSize_-1)/2.0;
+        Real temporalCentre = (largestWindowSize_-1)/2.0;
 
         LOUDNESS_DEBUG(name_
-                << ": Temporal centre of largest window: " 
-                << temporalCentre_);
-
-        //delays for windows
-        configureDelays();
+                << ": Temporal centre of largest window: "
+                << temporalCentre);
 
-        norm_.resize(nWindows_);
+        //binLimits contains the desired bins indices (lo and hi) per band
+        vector<vector<int> > bandBinIndices(nWindows_);
+        lag_.resize(nWindows_);
         for(int i=0; i<nWindows_; i++)
         {
+            //the newest sample of each window lags the input by lag_ samples
+            Real tc2 = (windowSizeSamps_[i]-1)/2.0;
+            int delay = (int)round(temporalCentre - tc2);
+            lag_[i] = largestWindowSize_ - delay - windowSizeSamps_[i];
+
+            LOUDNESS_DEBUG(name_
+                    << ": Window size: " << windowSizeSamps_[i]
+                    << " lag: " << lag_[i]);
+
             //bin indices to use for compiled spectrum
             bandBinIndices[i].resize(2);
             //These are NOT the nearest components but satisfies f_k in [f_lo, f_hi)
@@ -126,40 +191,24 @@ namespace loudness{
                 LOUDNESS_WARNING(name_ << ": Bin is >= nyquist...excluding.");
                 bandBinIndices[i][1] = (ceil(windowSizeSamps_[i]/2.0)-1);
             }
-
-            //window normalisation
-            //8/3 for hann
-            //0.0625 for power gain of 16 due to freq domain windowing
-            //2 for one sided spectrum
-            norm_[i] = (2*0.0625*8)/(3.0*2e-5*2e-5*windowSizeSamps_[i]*windowSizeSamps_[i]);
         }
 
         //ensure no overlap
         int nBins = 0;
         for(int i=1; i<nWindows_; i++)
         {
-            Real f1 = (bandBinIndices[i][0]*fs/windowSizeSamps_[i]);
-            Real f2 = (bandBinIndices[i-1][1]*fs/windowSizeSamps_[i-1]);
-
-            while( f1 <= f2)
+            while((bandBinIndices[i][0]*fs/(Real)windowSizeSamps_[i]) <=
+                    (bandBinIndices[i-1][1]*fs/(Real)windowSizeSamps_[i-1]))
                 bandBinIndices[i][0] += 1;
 
-            //this line will alter the band frequencies slightly to ensure closely spaced bins
-            /*
-             while(((bandBinIndices[i-1][1]+1)*fs/windowSizeSamps_[i-1]) 
-                     < (bandBinIndices[i][0]*fs/windowSizeSamps_[i]))
-             {
-                bandBinIndices[i-1][1] += 1;   
-             }
-             */
             nBins += bandBinIndices[i-1][1]-bandBinIndices[i-1][0] + 1;
         }
 
         //total number of bins in the output spectrum
         nBins += bandBinIndices[nWindows_-1][1]-bandBinIndices[nWindows_-1][0] + 1;
 
-        LOUDNESS_DEBUG(name_ 
-                << ": Total number of bins comprising the spectrum: " 
+        LOUDNESS_DEBUG(name_
+                << ": Total number of bins comprising the spectrum: "
                 << nBins);
 
         #if defined(DEBUG)
@@ -167,237 +216,369 @@ namespace loudness{
         {
             Real edgeLo = bandBinIndices[i][0]*fs/(Real)windowSizeSamps_[i];
             Real edgeHi = bandBinIndices[i][1]*fs/(Real)windowSizeSamps_[i];
-            LOUDNESS_DEBUG(name_ 
-                    << ": Band interval (Hz) for Window of size: " 
+            LOUDNESS_DEBUG(name_
+                    << ": Band interval (Hz) for Window of size: "
                     << windowSizeSamps_[i]
-                    << " = [ " << edgeLo << ", " 
+                    << " = [ " << edgeLo << ", "
                     << edgeHi << " ].");
         }
         #endif
-        
-        //Goertzel filter variables
-        sine_.resize(nWindows_);
-        cosineTimes2_.resize(nWindows_);
-        vPrev_.resize(nWindows_);
-        vPrev2_.resize(nWindows_);
 
         //output bank
-        output_.initialize(nBins, 1, fs);
+        nTracks_ = input.getNTracks();
+        output_.initialize(nTracks_, nBins, 1, fs);
         output_.setFrameRate(fs/(Real)hopSize_);
 
-        //fill in variables and compute centre frequencies
+        //resonators, including 2 redundant bins per band for windowing
+        oscOffset_.assign(nWindows_ + 1, 0);
+        coef_.clear();
+        cosine_.clear();
+        sine_.clear();
+        binIndex_.clear();
+        hannCentre_.resize(nWindows_);
+        hannRe_.resize(nWindows_);
+        hannIm_.resize(nWindows_);
         int k=0;
         for(int i=0; i<nWindows_; i++)
         {
+            int windowSize = windowSizeSamps_[i];
             for(int j=bandBinIndices[i][0]; j<=bandBinIndices[i][1]; j++)
+                output_.setCentreFreq(k++, j*fs/(Real)windowSize);
+
+            for(int j=bandBinIndices[i][0]-1; j<=bandBinIndices[i][1]+1; j++)
             {
-                output_.setCentreFreq(k++, j*fs/(Real)windowSizeSamps_[i]);
+                double phi = 2*PI*j/(double)windowSize;
+                coef_.push_back(2*cos(phi));
+                cosine_.push_back(cos(phi));
+                sine_.push_back(sin(phi));
+                binIndex_.push_back(j);
             }
+            oscOffset_[i+1] = (int)coef_.size();
 
-            //2 redundant bins per band required for convolution
-            bandBinIndices[i][0] -= 1;
-            bandBinIndices[i][1] += 1;
-
-            //filter coefficients
-            for(int j=bandBinIndices[i][0]; j<=bandBinIndices[i][1]; j++)
+            /*
+             * Window normalisation as in PowerSpectrum::hannWindow, with a
+             * transform length equal to the window size. The centred Hann
+             * window is 0.5 + 0.25 exp(j t (n - c)) + 0.25 exp(-j t (n - c)),
+             * t = 2 pi / windowSize, c = (windowSize - 1) / 2.
+             */
+            if(windowSpectrum_)
             {
-                Real phi = 2*PI*j/(Real)windowSizeSamps_[i];
-                Real sinPhi = sin(phi);
-                Real cosPhi = cos(phi);
-		sine_[i].push_back(sinPhi);
-                cosineTimes2_[i].push_back(2*cosPhi); 
-                vPrev_[i].push_back(0.0);
-                vPrev2_[i].push_back(0.0);
-
-                LOUDNESS_DEBUG(name_ 
-                        << ": Freq: " << j*fs/(Real)windowSizeSamps_[i] 
-                        << " Re{z_coef}: " << cosPhi
-                        << " Im{z_coef}: " << sinPhi);
+                double norm = sqrt(2.0 / (windowSize * windowSize * 0.375 * 2e-5 * 2e-5));
+                double theta = 2 * PI / windowSize;
+                double centre = 0.5 * (windowSize - 1);
+                hannCentre_[i] = 0.5 * norm;
+                hannRe_[i] = 0.25 * norm * cos(theta * centre);
+                hannIm_[i] = -0.25 * norm * sin(theta * centre);
+            }
+            else
+            {
+                hannCentre_[i] = sqrt(2.0 / (windowSize * windowSize * 2e-5 * 2e-5));
+                hannRe_[i] = hannIm_[i] = 0.0;
             }
         }
-
-        //timing
-        initFrameReady_ = (delayLineSize_ - hopSize_) / blockSize;
-        frameReady_ = hopSize_ / blockSize;
-        maxCount_ = initFrameReady_;
-
-        LOUDNESS_DEBUG(name_
-                << ": Number of process calls until first frame: " 
-                << initFrameReady_
-                << "\n Number of process calls until subsequent frames: " 
-                << frameReady_);
-
-        delayWriteIdx_ = 0;
-        count_ = 0;
-
-        return 1;
-    }
-
-    void GoertzelPS::processInternal(const SignalBank &input)
-    {
-        //output trigger
-        output_.setTrig(0);
-
-        //fill delay line - array size is an integer multiple of the audio block size
-        int nSamples = input.getNSamples();
-        for(int i=0; i<nSamples; i++)
-            delayLine_[delayWriteIdx_++] = input.getSample(0, i);
-        delayWriteIdx_ = delayWriteIdx_ % delayLineSize_;
-        count_++;
-        
-        //the Goertzels
-        Real comb, v;
+        nOscillators_ = (int)coef_.size();
+
+        /*
+         * Pick the cheaper update per window, in units of one resonator
+         * update: a block update zeroes and folds the window, transforms it
+         * and has a fixed overhead of roughly 512 updates. Segments end at
+         * both input buffer and frame boundaries.
+         */
+        int blockSize = input.getNSamples();
+        double segment = std::min(hopSize_, blockSize);
+        if((hopSize_ % blockSize) && (blockSize % hopSize_))
+            segment = hopSize_ * blockSize / (double)(hopSize_ + blockSize);
+        blockWindow_.assign(nWindows_, false);
+        phase_.assign(nWindows_, 0);
+        twiddleOffset_.assign(nWindows_, 0);
+        twiddleRe_.clear();
+        twiddleIm_.clear();
+        int largestBlockWindow = 0;
         for(int i=0; i<nWindows_; i++)
         {
-            for(int k=0; k<nSamples; k++)
-            {
-                comb = delayLine_[startIdx_[i]++] - delayLine_[endIdx_[i]++];
+            int windowSize = windowSizeSamps_[i];
+            int n = oscOffset_[i+1] - oscOffset_[i];
+            double recursionCost = n * segment;
+            double blockCost = windowSize * fftCostPerPoint(windowSize)
+                + windowSize + segment + 512;
+            blockWindow_[i] = blockUpdate_ && (blockCost < recursionCost);
+            LOUDNESS_DEBUG(name_
+                    << ": Window of size " << windowSize
+                    << (blockWindow_[i] ? " uses block updates." : " uses the recursion."));
 
-                for(unsigned int j=0; j<vPrev_[i].size(); j++)
+            if(blockWindow_[i])
+            {
+                twiddleOffset_[i] = (int)twiddleRe_.size();
+                for(int q=0; q<windowSize; q++)
                 {
-                    v = comb + cosineTimes2_[i][j] * vPrev_[i][j] - vPrev2_[i][j];
-                    vPrev2_[i][j] = vPrev_[i][j];			
-                    vPrev_[i][j] = v;
+                    twiddleRe_.push_back(cos(2*PI*q/(double)windowSize));
+                    twiddleIm_.push_back(sin(2*PI*q/(double)windowSize));
                 }
-
-                startIdx_[i] = startIdx_[i] % delayLineSize_;
-                endIdx_[i] = endIdx_[i] % delayLineSize_;
+                largestBlockWindow = std::max(largestBlockWindow, windowSize);
             }
         }
 
-        if(count_ == maxCount_)
+        //FFT buffers per worker, plans shared through FFTWPlanCache
+        destroyTransformBuffers();
+        transformPlans_.assign(nWindows_, FFTWPlan());
+        if(largestBlockWindow > 0)
         {
-            
-            LOUDNESS_DEBUG(name_ << ": Computing new frame");
-            LOUDNESS_DEBUG(name_ << ": write index: " << delayWriteIdx_);
-            for(int i=0; i<nWindows_; i++)
-                LOUDNESS_DEBUG(name_
-                        << ": start index: " << startIdx_[i]
-                        << ": end index: " << endIdx_[i]);
-
-            /*
-            #if defined(DEBUG)
+            for(int w=0; w<getNWorkers(); w++)
+            {
+                transformInputBufs_.push_back((Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * largestBlockWindow));
+                transformOutputBufs_.push_back((Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * largestBlockWindow));
+            }
             for(int i=0; i<nWindows_; i++)
             {
-                for(unsigned int j=0; j<vPrev_[i].size(); j++)
-                    LOUDNESS_DEBUG(name_ << ", v[n]: " << vPrev_[i][j]);
+                if(blockWindow_[i])
+                    transformPlans_[i] = FFTWPlanCache::getR2RPlan(windowSizeSamps_[i], 1,
+                            windowSizeSamps_[i], FFTW_R2HC,
+                            transformInputBufs_[0], transformOutputBufs_[0]);
             }
-            #endif
-            */
-
-            //window the spectrum and compute PS
-            if(windowSpectrum_)
-                windowedPS();
-            else
-                computePS();
+        }
 
-            //output ready
-            output_.setTrig(1);
+        //tracks are grouped into SIMD lanes
+        groupSize_ = nTracks_ >= 4 ? 4 : (nTracks_ >= 2 ? 2 : 1);
+        nGroups_ = (nTracks_ + groupSize_ - 1) / groupSize_;
+        LOUDNESS_DEBUG(name_
+                << ": " << nGroups_ << " group(s) of "
+                << groupSize_ << " track(s), "
+                << nOscillators_ << " resonators per track.");
+
+        /*
+         * The history holds the largest window followed by room for new
+         * samples, and is shifted back only when full.
+         */
+        historySize_ = largestWindowSize_ + std::max(largestWindowSize_, input.getNSamples());
+        history_.assign(nGroups_ * groupSize_, RealVec(historySize_, 0.0));
+        vPrev_.assign(nGroups_ * nOscillators_ * groupSize_, 0.0);
+        vPrev2_.assign(nGroups_ * nOscillators_ * groupSize_, 0.0);
+        comb_.assign(getNWorkers(),
+                vector<double>(groupSize_ * input.getNSamples(), 0.0));
+
+        writeIdx_ = largestWindowSize_;
+        nSamplesUntilFrame_ = largestWindowSize_;
 
-            count_ = 0;
-            maxCount_ = frameReady_;
-        }
+        return 1;
     }
 
-    void GoertzelPS::computePS()
+    void GoertzelPS::process(const TrackBank &input)
     {
-        Real re, im;
-        int binWriteIdx=0;
-        for(int i=0; i<nWindows_; i++)
+        if(initialized_ && input.getAndTrigs())
         {
-            for(unsigned int j=1; j<(vPrev_[i].size()-1); j++)
-            { 
-                // r*cos(phi)*v[n]-v[n-1]
-		re = (0.5*cosineTimes2_[i][j]
-                        * vPrev_[i][j]) - vPrev2_[i][j];
-		im = sine_[i][j]*vPrev_[i][j];	
-
-                output_.setSample(binWriteIdx++, 0, norm_[i]*(re*re + im*im));
-            }
+#ifdef LOUDNESS_PROFILE
+            startProfile();
+            processInternal(input);
+            stopProfile();
+#else
+            processInternal(input);
+#endif
         }
     }
 
-
-    void GoertzelPS::windowedPS()
+    void GoertzelPS::processInternal(const TrackBank &input)
     {
-	Real re, im, rePrev, imPrev, rePrevTemp, 
-               imPrevTemp, rePrevTemp2, imPrevTemp2;
-        int binWriteIdx=0;
-        for(int i=0; i<nWindows_; i++)
+        /*
+         * As in FrameGenerator, the input is consumed in segments ending at
+         * the next frame boundary.
+         */
+        int nSamples = input.getNSamples();
+        int readPos = 0;
+        while(readPos < nSamples)
         {
-            for(unsigned int j=0; j<vPrev_[i].size(); j++)
-            { 
-                // r*cos(phi)*v[n]-v[n-1]
-		re = (0.5*cosineTimes2_[i][j]
-                        * vPrev_[i][j]) - vPrev2_[i][j];
-		im = sine_[i][j]*vPrev_[i][j];	
-
-                //checked out:17.7.14
-		rePrevTemp2 = re;
-		imPrevTemp2 = im;
-
-		if (j>0)
-		{
-                    //real
-                    rePrev -= re; //final bin not required
-                    re *= 2.0;
-                    re -= rePrevTemp;
-                    //imag
-                    imPrev -= im;
-                    im *= 2.0;
-                    im -= imPrevTemp;
-
-                    //excludes redundant bins
-                    if(j>1)
-                        output_.setSample(binWriteIdx++, 0, norm_[i]*(rePrev*rePrev + imPrev*imPrev));
-		}
-
-		rePrev = re;
-		imPrev = im;
-		rePrevTemp = rePrevTemp2;
-		imPrevTemp = imPrevTemp2;
+            int segment = std::min(nSamples - readPos, nSamplesUntilFrame_);
+            nSamplesUntilFrame_ -= segment;
+            bool emit = nSamplesUntilFrame_ == 0;
+
+            processTracks(nGroups_, [&](int group, int worker)
+            {
+                processGroup(input, group, worker, readPos, segment, emit);
+            });
+
+            if(writeIdx_ + segment > historySize_)
+                writeIdx_ = largestWindowSize_;
+            writeIdx_ += segment;
+            for(int i=0; i<nWindows_; i++)
+                phase_[i] = (phase_[i] + segment) % windowSizeSamps_[i];
+            readPos += segment;
+
+            if(emit)
+            {
+                LOUDNESS_DEBUG(name_ << ": Computing new frame");
+                nSamplesUntilFrame_ = hopSize_;
+                if(targetModule_)
+                {
+#ifdef LOUDNESS_PROFILE
+                    pauseProfile();
+                    targetModule_->process(output_);
+                    resumeProfile();
+#else
+                    targetModule_->process(output_);
+#endif
+                }
             }
         }
     }
 
-    void GoertzelPS::configureDelays()
+    void GoertzelPS::processGroup(const TrackBank &input, int group, int worker,
+            int start, int nSamples, bool emit)
     {
-        startIdx_.resize(nWindows_);
-        endIdx_.resize(nWindows_);
-        delayLine_.assign(delayLineSize_, 0.0);
-        delayWriteIdx_ = 0;
+        const int G = groupSize_;
+        const int firstTrack = group * G;
+
+        //append the new samples, shifting the history back if full
+        int writeIdx = writeIdx_;
+        bool shift = writeIdx + nSamples > historySize_;
+        const Real *history[4];
+        for(int l=0; l<G; l++)
+        {
+            Real *h = &history_[firstTrack + l][0];
+            if(shift)
+                std::copy(h + writeIdx - largestWindowSize_, h + writeIdx, h);
+            history[l] = h;
+        }
+        if(shift)
+            writeIdx = largestWindowSize_;
+        for(int l=0; l<G && firstTrack+l<nTracks_; l++)
+        {
+            const Real *x = input.getSignalReadPointer(firstTrack + l, 0, start);
+            std::copy(x, x + nSamples, &history_[firstTrack + l][writeIdx]);
+        }
 
+        double *vPrev = &vPrev_[group * nOscillators_ * G];
+        double *vPrev2 = &vPrev2_[group * nOscillators_ * G];
+        double *comb = &comb_[worker][0];
         for(int i=0; i<nWindows_; i++)
         {
-            //SignalBank offset for temporal alignment
-            Real tc2 = (windowSizeSamps_[i]-1)/2.0;
-            if(windowSizeSamps_[i] == largestWindowSize_)
-                startIdx_[i] = 0;
-            else
-                startIdx_[i] = delayLineSize_ - (int)round(temporalCentre_ - tc2);
+            const int windowSize = windowSizeSamps_[i];
+            const int newest = writeIdx - lag_[i];
+            const int oldest = newest - windowSize;
+            const int first = oscOffset_[i];
+            const int n = oscOffset_[i + 1] - first;
+            double *v1 = vPrev + first * G;
+            double *v2 = vPrev2 + first * G;
+
+            if(blockWindow_[i])
+            {
+                //P += FFT of the comb output folded at its sample positions
+                Real *fftIn = transformInputBufs_[worker];
+                Real *fftOut = transformOutputBufs_[worker];
+                for(int l=0; l<G && firstTrack+l<nTracks_; l++)
+                {
+                    const Real *xNew = history[l] + newest;
+                    const Real *xOld = history[l] + oldest;
+                    std::fill(fftIn, fftIn + windowSize, 0.0);
+                    int r = phase_[i];
+                    for(int s=0; s<nSamples; s++)
+                    {
+                        fftIn[r] += xNew[s] - xOld[s];
+                        if(++r == windowSize)
+                            r = 0;
+                    }
+                    LOUDNESS_FFTW(execute_r2r)(transformPlans_[i], fftIn, fftOut);
+
+                    //half complex output, X[N-k] = conj(X[k])
+                    for(int o=0; o<n; o++)
+                    {
+                        int k = binIndex_[first + o];
+                        int kMirror = windowSize - k;
+                        double re, im;
+                        if(2 * k > windowSize)
+                        {
+                            re = fftOut[kMirror];
+                            im = -fftOut[k];
+                        }
+                        else
+                        {
+                            re = fftOut[k];
+                            im = (k == 0 || 2 * k == windowSize) ? 0.0 : fftOut[kMirror];
+                        }
+                        v1[o * G + l] += re;
+                        v2[o * G + l] += im;
+                    }
+                }
+                continue;
+            }
 
-            //check this line
-            endIdx_[i] = (delayLineSize_ + startIdx_[i] - windowSizeSamps_[i]) % delayLineSize_;
+            //x[n] - x[n-N] for each track of the group
+            for(int l=0; l<G; l++)
+            {
+                const Real *xNew = history[l] + newest;
+                const Real *xOld = history[l] + oldest;
+                for(int s=0; s<nSamples; s++)
+                    comb[s * G + l] = (double)xNew[s] - xOld[s];
+            }
 
-            LOUDNESS_DEBUG(name_ 
-                    << ": Window size: " << windowSizeSamps_[i]
-                    << " centre point: " 
-                    << ((startIdx_[i] + largestWindowSize_ ) % delayLineSize_) - tc2 - 1
-                    << " start idx: " << startIdx_[i] 
-                    << " end idx: " << endIdx_[i]);
+            switch(G)
+            {
+                case 4:
+                    resonate<4>(&coef_[first], n, comb, nSamples, v1, v2);
+                    break;
+                case 2:
+                    resonate<2>(&coef_[first], n, comb, nSamples, v1, v2);
+                    break;
+                default:
+                    resonate<1>(&coef_[first], n, comb, nSamples, v1, v2);
+            }
         }
+
+        if(emit)
+            computePS(group, nSamples);
     }
 
-    void GoertzelPS::resetInternal()
+    void GoertzelPS::computePS(int group, int nSamples)
     {
-        count_ = 0;
-        maxCount_ = initFrameReady_;
-        configureDelays();
-
-        for(int i=0; i<nWindows_; i++)
+        const int G = groupSize_;
+        const int outStride = output_.getChannelStride();
+        const double *vPrev = &vPrev_[group * nOscillators_ * G];
+        const double *vPrev2 = &vPrev2_[group * nOscillators_ * G];
+        for(int l=0; l<G && group*G+l<nTracks_; l++)
         {
-            for(unsigned int j=0; j<vPrev_[i].size(); j++)
-                vPrev_[i][j] = vPrev2_[i][j] = 0.0;
+            Real *out = output_.getTrackWritePointer(group * G + l);
+            for(int i=0; i<nWindows_; i++)
+            {
+                const double c = hannCentre_[i], hRe = hannRe_[i], hIm = hannIm_[i];
+                const int windowSize = windowSizeSamps_[i];
+                const int nextPhase = (phase_[i] + nSamples) % windowSize;
+                const double *twRe = twiddleRe_.empty() ? 0 : &twiddleRe_[twiddleOffset_[i]];
+                const double *twIm = twiddleIm_.empty() ? 0 : &twiddleIm_[twiddleOffset_[i]];
+                for(int o=oscOffset_[i]+1; o<oscOffset_[i+1]-1; o++)
+                {
+                    double re[3], im[3];
+                    for(int j=0; j<3; j++)
+                    {
+                        int idx = (o + j - 1) * G + l;
+                        if(blockWindow_[i])
+                        {
+                            //X[k] = e^(j 2 pi k (n+1) / N) P[k]
+                            int q = (int)(((long)binIndex_[o + j - 1] * nextPhase) % windowSize);
+                            re[j] = twRe[q] * vPrev[idx] - twIm[q] * vPrev2[idx];
+                            im[j] = twRe[q] * vPrev2[idx] + twIm[q] * vPrev[idx];
+                        }
+                        else
+                        {
+                            //X[k] = e^(jw) v[n] - v[n-1]
+                            re[j] = cosine_[o + j - 1] * vPrev[idx] - vPrev2[idx];
+                            im[j] = sine_[o + j - 1] * vPrev[idx];
+                        }
+                    }
+                    double xRe = c * re[1] + hRe * (re[0] + re[2]) - hIm * (im[0] - im[2]);
+                    double xIm = c * im[1] + hRe * (im[0] + im[2]) + hIm * (re[0] - re[2]);
+                    *out = xRe * xRe + xIm * xIm;
+                    out += outStride;
+                }
+            }
         }
     }
+
+    void GoertzelPS::resetInternal()
+    {
+        for(unsigned int i=0; i<history_.size(); i++)
+            std::fill(history_[i].begin(), history_[i].end(), 0.0);
+        std::fill(vPrev_.begin(), vPrev_.end(), 0.0);
+        std::fill(vPrev2_.begin(), vPrev2_.end(), 0.0);
+        std::fill(phase_.begin(), phase_.end(), 0);
+        writeIdx_ = largestWindowSize_;
+        nSamplesUntilFrame_ = largestWindowSize_;
+    }
 }
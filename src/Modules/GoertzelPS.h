@@ -1,6 +1,7 @@
 #ifndef GOERTZELPS_H
 #define GOERTZELPS_H
 
+#include "../Support/FFTW.h"
 #include "../Support/Module.h"
 
 namespace loudness{
@@ -35,52 +36,133 @@ namespace loudness{
      * in the interval [100, 500). The windows are all time-aligned at their
      * centre points, and the composite spectrum is updated at 1~ms intervals.
      *
-     * Windowing is performed in the frequency domain according to:
-     *  X_windowed[b, k] = - X[b, k-1] + 2*X[b, k] - X[b, k+1]
+     * Unlike PowerSpectrum, the input is the audio signal itself (no
+     * FrameGenerator is required) and the transform length of each band is the
+     * window size, so bin k of band b lies at k * fs / windowSize[b]. Frames
+     * are timed as those of a FrameGenerator with a frame size equal to the
+     * largest window: the first spectrum is output once the largest window
+     * has been filled and then every hop, so any number of spectra (including
+     * none) can be passed to the target module per input buffer.
      *
-     * where b is the band number. This introduces a gain of four.
+     * Windowing is performed in the frequency domain by combining each bin
+     * with its two neighbours, which requires one redundant resonator on
+     * either side of each band. The window is the same centred Hann window
+     * used by PowerSpectrum, so with window sizes that are powers of two the
+     * output equals that of a non-uniform PowerSpectrum.
      *
      * Each spectrum is scaled such that the sum of component powers in a given
      * band equals the average power in that band (see,
      * http://www.dadisp.com/webhelp/dsphelp.htm#mergedprojects/refman2/SPLGROUP/POWSPEC.htm).
      * The spectra are also compensated for the gain introduced by hann windowing.
      *
+     * Tracks are processed in groups of up to four. The resonator states of a
+     * group are held contiguously in double precision, interleaved so that the
+     * states of one bin across the tracks of the group are adjacent
+     * ([bin][track]). The per-sample recursion therefore runs over unit-stride
+     * arrays, vectorising across bins for a single track and across tracks
+     * otherwise. Two samples are applied per pass over the states.
+     *
+     * When block updates are enabled (the default), a window whose
+     * resonators would cost more to run over the input between two frames
+     * than an FFT of the window length instead advances by the whole segment
+     * at once. Writing the comb filtered input as u[m], the window holds
+     *
+     *  P_k(n) = sum_{m <= n} u[m] e^(-j 2 pi k m / N),
+     *
+     * from which the DFT of the segment ending at n is e^(j 2 pi k (n+1) / N)
+     * P_k(n). Because e^(-j 2 pi k m / N) has period N, the increment of all
+     * P_k over a segment is a single N-point FFT of the segment's u[m],
+     * folded modulo N at its absolute sample positions. The cost per segment
+     * is then one FFT plus a complex addition per bin, independent of the
+     * number of samples, which pays off for short windows with many bins
+     * and for long hops.
+     *
      * In the current implementation, DC and nyquist are not computed.
      *
      * @author Dominic Ward
+     *
+     * @sa PowerSpectrum
      */
-
-    /*
-     * Have checked the resulting power spectrum and gives same result as
-     * PowerSpectrum when no windowing is used.  However, frequency domain
-     * windowing seems to give small deviations at low levels which I attribute to
-     * numerical differences. See the source for PowerSpectrum for further notes.
-    */
-
     class GoertzelPS : public Module
     {
 
     public:
         GoertzelPS(const RealVec& bandFreqsHz, const RealVec& windowSizeSecs, Real hopSizeSecs);
         virtual ~GoertzelPS();
+
+        /**
+         * @brief Set to false to output the power spectrum of the
+         * rectangular windowed segments (default is true).
+         */
         void setWindowSpectrum(bool windowSpectrum);
 
+        /**
+         * @brief Set to false to always run the resonators sample by sample
+         * (default is true, see class description).
+         */
+        void setBlockUpdate(bool blockUpdate);
+
+        /**
+         * @brief Returns the hop size in samples.
+         */
+        int getHopSize() const;
+
+        /**
+         * @brief Runs the resonators over @a input and emits every spectrum
+         * completed by it.
+         *
+         * Overrides Module::process() because the output is passed to the
+         * target module once per hop rather than once per input buffer.
+         */
+        virtual void process(const TrackBank &input);
+
     private:
-        virtual bool initializeInternal(const SignalBank &input);
-        virtual void processInternal(const SignalBank &input);
+        virtual bool initializeInternal(const TrackBank &input);
+        virtual void processInternal(const TrackBank &input);
         virtual void resetInternal();
-        void windowedPS();
-        void computePS();
-        void configureDelays();
+
+        /*
+         * Feeds samples [start, start + nSamples) of the input to the
+         * resonators of a group and, if @a emit is true, writes the spectra
+         * of its tracks to the output.
+         */
+        void processGroup(const TrackBank &input, int group, int worker,
+                int start, int nSamples, bool emit);
+
+        void computePS(int group, int nSamples);
+
+        void destroyTransformBuffers();
 
         RealVec bandFreqsHz_, windowSizeSecs_;
-        Real hopSizeSecs_, temporalCentre_;
-        RealVecVec sine_, cosineTimes2_, vPrev_, vPrev2_;
-        RealVec delayLine_, norm_;
-        vector<int> windowSizeSamps_, startIdx_, endIdx_;
-        int nWindows_, hopSize_, delayLineSize_, delayWriteIdx_;
-        int count_, maxCount_, initFrameReady_, frameReady_, largestWindowSize_;
-        bool windowSpectrum_;
+        Real hopSizeSecs_;
+        bool windowSpectrum_, blockUpdate_;
+        int nWindows_, hopSize_, largestWindowSize_, nTracks_;
+        int groupSize_, nGroups_, nOscillators_;
+        int historySize_, writeIdx_, nSamplesUntilFrame_;
+        vector<int> windowSizeSamps_, lag_, oscOffset_;
+
+        //per oscillator: 2cos(w), cos(w), sin(w) and bin index
+        vector<double> coef_, cosine_, sine_;
+        vector<int> binIndex_;
+
+        //block updated windows: input phase (n mod N) and exp(j 2 pi q / N)
+        vector<bool> blockWindow_;
+        vector<int> phase_, twiddleOffset_;
+        vector<double> twiddleRe_, twiddleIm_;
+        vector<Real*> transformInputBufs_, transformOutputBufs_;
+        vector<FFTWPlan> transformPlans_;
+
+        //per window: Hann weights of the centre and neighbouring bins
+        vector<double> hannCentre_, hannRe_, hannIm_;
+
+        /*
+         * per group: states [oscillator][track] and input history per track.
+         * Block updated windows hold Re(P) and Im(P) in place of v[n] and
+         * v[n-1].
+         */
+        vector<double> vPrev_, vPrev2_;
+        RealVecVec history_;
+        vector<vector<double> > comb_;
     };
 }
 
@@ -23,7 +23,7 @@ namespace loudness{
 
     IIR::IIR() : Module("IIR") {};
 
-    IIR::IIR(int nTracks, const RealVec &bCoefs, const RealVec &aCoefs) :
+    IIR::IIR(int nTracks, const vector<double> &bCoefs, const vector<double> &aCoefs) :
         Module("IIR")
     {
         setNTracks(nTracks);
@@ -77,28 +77,31 @@ namespace loudness{
 
     void IIR::processInternal(const TrackBank &input)
     {
-        int smp, j;
-        Real x,y;
-
-        for(int track = 0; track < input.getNTracks(); track++)
+        processTracks(input.getNTracks(), [&](int track, int)
         {
+            int smp, j;
+            double x,y;
+            const Real *inputSignal = input.getSignalReadPointer(track, 0);
+            Real *outputSignal = output_.getSignalWritePointer(track, 0);
+            vector<double> &z = z_[track];
+
             for(smp=0; smp<input.getNSamples(); smp++)
             {
                 //input sample
-                x = input.getSample(track, 0, smp) * gain_;
+                x = inputSignal[smp] * gain_;
 
                 //output sample
-                y = bCoefs_[0] * x + z_[track][0];
-                output_.setSample(track, 0, smp, y);
+                y = bCoefs_[0] * x + z[0];
+                outputSignal[smp] = y;
 
                 //fill delay
                 for (j=1; j<order_; j++)
-                    z_[track][j-1] = bCoefs_[j] * x + z_[track][j] - aCoefs_[j] * y;
+                    z[j-1] = bCoefs_[j] * x + z[j] - aCoefs_[j] * y;
 
                 //final sample
-                z_[track][orderMinus1_] = bCoefs_[order_] * x - aCoefs_[order_] * y;
+                z[orderMinus1_] = bCoefs_[order_] * x - aCoefs_[order_] * y;
             }
-        }
+        });
     }
 
     void IIR::resetInternal()
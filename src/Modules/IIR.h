@@ -43,7 +43,7 @@ namespace loudness{
             *  Parameters:  bCoefs:  Filter coefficients.
             *--------------------------------------------------------------------------------------
             */
-            IIR(int nTracks, const RealVec &bCoefs, const RealVec &aCoefs);
+            IIR(int nTracks, const vector<double> &bCoefs, const vector<double> &aCoefs);
             IIR();
 
             virtual ~IIR();
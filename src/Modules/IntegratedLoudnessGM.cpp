@@ -23,13 +23,12 @@
 namespace loudness{
 
     IntegratedLoudnessGM::IntegratedLoudnessGM(bool diotic, bool uniform, Real cParam) :
+        Module("IntegratedLoudness"),
         diotic_(diotic),
         uniform_(uniform),
+        nChannels_(0),
         cParam_(cParam)
-    {
-        LOUDNESS_DEBUG("IntegratedLoudness: Constructed.");
-        name_ = "IntegratedLoudness";
-    }
+    {}
 
     IntegratedLoudnessGM::~IntegratedLoudnessGM()
     {
@@ -67,11 +66,14 @@ namespace loudness{
             return 0;
         }
 
+        nChannels_ = input.getNChannels();
+
         //assumes uniformly spaced ERB filters
         camStep_ = FreqToCam(input.getCentreFreq(1))-FreqToCam(input.getCentreFreq(0));
         LOUDNESS_DEBUG("IntegratedLoudnessGM: Filter spacing (Cams): " << camStep_);
 
         //if excitation pattern is sampled non-uniformly, approximate integral
+        camDif_.clear();
         if(!uniform_)
         {
             for(int i=1; i<input.getNChannels(); i++)
@@ -109,8 +111,12 @@ namespace loudness{
         setAttackLTLCoef(-0.001/log(1-0.01));
         setReleaseLTLCoef(-0.001/log(1-0.0005));
 
+        int nTracks = input.getNTracks();
+        prevSTL_.assign(nTracks, 0);
+        prevLTL_.assign(nTracks, 0);
+
         //output TrackBank
-        output_.initialize(input.getNTracks(), 3, 1, input.getFs());
+        output_.initialize(nTracks, 3, 1, input.getFs());
         output_.setFrameRate(input.getFrameRate());
 
         return 1;
@@ -118,54 +124,74 @@ namespace loudness{
 
     void IntegratedLoudnessGM::processInternal(const TrackBank &input)
     {       
+        const int stride = input.getChannelStride();
+        processTracks(input.getNTracks(), [&](int track, int)
+        {
+            integrate(track, input.getTrackReadPointer(track), stride);
+        });
+    }
+
+    void IntegratedLoudnessGM::processFused(int track, const Real *x, Real*,
+            int)
+    {
+        integrate(track, x, 1);
+    }
+
+    Module::Fusion IntegratedLoudnessGM::getFusion() const
+    {
+        return REDUCTION;
+    }
+
+    void IntegratedLoudnessGM::integrate(int track, const Real *x, int stride)
+    {
         //instantaneous loudness
-        for (int track = 0; track < input.getNTracks(); track++)
+        Real il = 0;
+        if(uniform_)
         {
-            Real il = 0;
-            if(uniform_)
-            {
-                for(int chn=0; chn<input.getNChannels(); chn++)
-                    il += input.getSample(track, chn, 1);
-            }
-            else
+            for(int chn=0; chn<nChannels_; chn++)
+                il += x[stride * chn];
+        }
+        else
+        {
+            for(int chn=0; chn<nChannels_-1; chn++)
             {
-                for(int chn=0; chn<input.getNChannels()-1; chn++)
-                {
-                    il += input.getSample(track, chn, 1)*camDif_[chn] + 0.5*camDif_[chn]*
-                        (input.getSample(track, chn+1, 1)-input.getSample(track, chn, 1));
-                }
+                il += x[stride * chn]*camDif_[chn] + 0.5*camDif_[chn]*
+                    (x[stride * (chn+1)]-x[stride * chn]);
             }
-
-            //apply scaling factor
-            il *= cParam_;
-
-            //short-term loudness
-            Real prevSTL = output_.getSample(track, 1, 0);
-            Real stl = 0.0;
-
-            if(il>prevSTL)
-                stl = attackSTLCoef_*(il-prevSTL) + prevSTL;
-            else
-                stl = releaseSTLCoef_*(il-prevSTL) + prevSTL;
-
-            //long-term loudness
-            Real prevLTL = output_.getSample(track, 2, 0);
-            Real ltl = 0.0;
-            if(stl>prevLTL)
-                ltl = attackLTLCoef_*(stl-prevLTL) + prevLTL;
-            else
-                ltl = releaseLTLCoef_*(stl-prevLTL) + prevLTL;
-            
-            //fill output TrackBank
-            output_.setSample(track, 0, 0, il);
-            output_.setSample(track, 1, 0, stl);
-            output_.setSample(track, 2, 0, ltl);
         }
+
+        //apply scaling factor
+        il *= cParam_;
+
+        //short-term loudness
+        Real prevSTL = prevSTL_[track];
+        Real stl = 0.0;
+
+        if(il>prevSTL)
+            stl = attackSTLCoef_*(il-prevSTL) + prevSTL;
+        else
+            stl = releaseSTLCoef_*(il-prevSTL) + prevSTL;
+
+        //long-term loudness
+        Real prevLTL = prevLTL_[track];
+        Real ltl = 0.0;
+        if(stl>prevLTL)
+            ltl = attackLTLCoef_*(stl-prevLTL) + prevLTL;
+        else
+            ltl = releaseLTLCoef_*(stl-prevLTL) + prevLTL;
+        
+        prevSTL_[track] = stl;
+        prevLTL_[track] = ltl;
+
+        //fill output TrackBank
+        output_.setSample(track, 0, 0, il);
+        output_.setSample(track, 1, 0, stl);
+        output_.setSample(track, 2, 0, ltl);
     }
 
-    //output TrackBanks are cleared so not to worry about filter state
     void IntegratedLoudnessGM::resetInternal()
     {
+        prevSTL_.assign(prevSTL_.size(), 0);
+        prevLTL_.assign(prevLTL_.size(), 0);
     }
 }
-
@@ -53,17 +53,25 @@ namespace loudness{
         void setAttackLTLCoef(Real tau);
         void setReleaseLTLCoef(Real tau);
 
+        virtual Fusion getFusion() const;
+
     private:
         virtual bool initializeInternal(const TrackBank &input);
         virtual void processInternal(const TrackBank &input);
         virtual void resetInternal();
+        virtual void processFused(int track, const Real *x, Real *y,
+                int worker);
+
+        //loudness of one track from its specific loudness
+        void integrate(int track, const Real *x, int stride);
 
         bool diotic_, uniform_;
+        int nChannels_;
         Real cParam_;
         Real attackSTLCoef_, releaseSTLCoef_;
         Real attackLTLCoef_, releaseLTLCoef_;
         Real camStep_, timeStep_;
-        RealVec camDif_;
+        RealVec camDif_, prevSTL_, prevLTL_;
     };
 }
 #endif
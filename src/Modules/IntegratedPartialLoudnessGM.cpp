@@ -124,10 +124,11 @@ namespace loudness{
 
     void IntegratedPartialLoudnessGM::processInternal(const TrackBank &input)
     {       
-        Real il, stl, ltl, ilChn, stlChn, ltlChn, prevSTLChn, prevLTLChn;
-        Real ipl, stpl, ltpl, iplChn, stplChn, ltplChn, prevSTPLChn, prevLTPLChn;
-        for (int track = 0; track < input.getNTracks(); track++)
+        processTracks(input.getNTracks(), [&](int track, int)
         {
+            Real il, stl, ltl, ilChn, stlChn, ltlChn, prevSTLChn, prevLTLChn;
+            Real ipl, stpl, ltpl, iplChn, stplChn, ltplChn, prevSTPLChn, prevLTPLChn;
+
             // first get overall loudnesses
             // in order to calculate if sound is in attack or release phase
             //
@@ -244,7 +245,7 @@ namespace loudness{
             prevLTL_[track] = ltl;
             prevSTPL_[track] = stpl;
             prevLTPL_[track] = ltpl;
-        }
+        });
     }
 
     //output TrackBanks are cleared so not to worry about filter state
@@ -18,6 +18,7 @@
  */
 
 #include "PowerSpectrum.h"
+#include <algorithm>
 
 namespace loudness{
 
@@ -33,19 +34,117 @@ namespace loudness{
 
     PowerSpectrum::~PowerSpectrum()
     { 
-        if(initialized_)
-        {
-            fftw_free(fftInputBuf_);
-            fftw_free(fftOutputBuf_);
-            LOUDNESS_DEBUG(name_ << ": Buffers destroyed.");
+        destroyBuffers();
+    }
 
-            for(vector<fftw_plan>::iterator i = fftPlans_.begin(); i != fftPlans_.end(); i++)
-                fftw_destroy_plan(*i);
-            LOUDNESS_DEBUG(name_ << ": Plan(s) destroyed.");
+    void PowerSpectrum::destroyBuffers()
+    {
+        for(unsigned int i=0; i<fftInputBufs_.size(); i++)
+        {
+            LOUDNESS_FFTW(free)(fftInputBufs_[i]);
+            LOUDNESS_FFTW(free)(fftOutputBufs_[i]);
         }
+        fftInputBufs_.clear();
+        fftOutputBufs_.clear();
+        LOUDNESS_DEBUG(name_ << ": Buffers destroyed.");
+
+        //plans are owned by FFTWPlanCache
+        fftPlans_.clear();
+        remainderPlans_.clear();
     }
 
     bool PowerSpectrum::initializeInternal(const TrackBank &input)
+    {
+        if(!initializeBands(input))
+            return 0;
+
+        /*
+         * Tracks are transformed in batches with a single FFTW call per
+         * batch. The batch size is capped so that the input and output
+         * buffers of a batch (about 1 MiB) stay in cache, and does not
+         * depend on the number of workers: serial and threaded processing
+         * then use the same plans on the same partition of tracks, and give
+         * bit-identical output. Every (track, window) segment of a batch has
+         * its own slot in a contiguous buffer:
+         *
+         * uniform: slot (t, i) starts at (t * nWindows + i) * fftSize, so
+         * all windows of all tracks form one batch of equal sized
+         * transforms.
+         *
+         * non-uniform: the slots of window i are consecutive and start at
+         * batchSize * (fftSize_0 + ... + fftSize_i-1), so each window needs
+         * one batched transform.
+         */
+        destroyBuffers();
+        int nTracks = input.getNTracks();
+        int nWorkers = getNWorkers();
+        int trackBytes = 0;
+        for(int i=0; i<nWindows_; i++)
+            trackBytes += 2 * sizeof(Real) * fftSize_[i];
+        batchSize_ = std::min(nTracks, std::max(1, (1 << 20) / trackBytes));
+        nBatches_ = (nTracks + batchSize_ - 1) / batchSize_;
+        int remainder = nTracks - (nBatches_ - 1) * batchSize_;
+
+        slotOffset_.resize(nWindows_);
+        slotDist_.resize(nWindows_);
+        int bufferSize = 0;
+        for(int i=0; i<nWindows_; i++)
+        {
+            if(uniform_)
+            {
+                slotOffset_[i] = i * fftSize_[i];
+                slotDist_[i] = nWindows_ * fftSize_[i];
+            }
+            else
+            {
+                slotOffset_[i] = bufferSize;
+                slotDist_[i] = fftSize_[i];
+            }
+            bufferSize += batchSize_ * fftSize_[i];
+        }
+
+        fftInputBufs_.resize(nWorkers);
+        fftOutputBufs_.resize(nWorkers);
+        for(int i=0; i<nWorkers; i++)
+        {
+            fftInputBufs_[i] = (Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * bufferSize);
+            fftOutputBufs_[i] = (Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * bufferSize);
+        }
+        LOUDNESS_DEBUG(name_
+                << ": " << nBatches_ << " batch(es) of up to "
+                << batchSize_ << " tracks, FFT buffer sizes: "
+                << bufferSize << ", memory allocated.");
+
+        if(uniform_)
+        {
+            fftPlans_.push_back(createPlan(fftSize_[0], batchSize_ * nWindows_, 0));
+            if(remainder < batchSize_)
+                remainderPlans_.push_back(createPlan(fftSize_[0], remainder * nWindows_, 0));
+            LOUDNESS_DEBUG(name_ <<
+                    ": Created a batched " 
+                    << fftSize_[0] 
+                    << "-point FFT plan for uniform spectral sampling.");
+        }
+        else
+        {
+            for(int i=0; i<nWindows_; i++)
+            {
+                fftPlans_.push_back(createPlan(fftSize_[i], batchSize_, slotOffset_[i]));
+                if(remainder < batchSize_)
+                    remainderPlans_.push_back(createPlan(fftSize_[i], remainder, slotOffset_[i]));
+            }
+            LOUDNESS_DEBUG(name_ << ": Created a batched FFT plan per window.");
+        }
+
+        //zero padding relies on the buffers being clear
+        for(int i=0; i<nWorkers; i++)
+            for(int j=0; j<bufferSize; j++)
+                fftInputBufs_[i][j] = 0.0;
+
+        return 1;
+    }
+
+    bool PowerSpectrum::initializeBands(const TrackBank &input)
     {
         
         //number of windows
@@ -90,47 +189,17 @@ namespace loudness{
             return 0;
         }
 
-        //create N windows and associated fft plans
+        //FFT sizes and windows
         windows_.resize(nWindows_);
-        fftSize_.resize(nWindows_, 0);
-    
-        //allocate memory for FFT input buffers...all FFT inputs can make use of a single buffer
-        //since we are not doing zero phase insersion
-        fftSize_[0] = pow(2, ceil(log2(largestWindowSize)));
-        fftInputBuf_ = (Real*) fftw_malloc(sizeof(Real) * fftSize_[0]);
-        fftOutputBuf_ = (Real*) fftw_malloc(sizeof(Real) * fftSize_[0]);
-        
-        //only 1 plan required if uniform spectral sampling 
-        LOUDNESS_DEBUG(name_
-                << ": FFT buffer sizes: " 
-                << fftSize_[0] 
-                << ", memory allocated.");
-
-        if(uniform_)
-        {
-            fftPlans_.push_back(fftw_plan_r2r_1d(fftSize_[0],
-                        fftInputBuf_, fftOutputBuf_, FFTW_R2HC, FFTW_PATIENT));
-            LOUDNESS_DEBUG(name_ <<
-                    ": Created a single " 
-                    << fftSize_[0] 
-                    << "-point FFT plan for uniform spectral sampling.");
-        }
-        else
-            LOUDNESS_DEBUG(name_ << ": Creating multiple plans...");
-
-        //create windows and multiple plans (if needed)
+        fftSize_.assign(nWindows_, 0);
+        int largestFFTSize = pow(2, ceil(log2(largestWindowSize)));
         for(int i=0; i<nWindows_; i++)
         {
-            if(!uniform_)
-            {
-                fftSize_[i] = pow(2,ceil(log2(windowSizeSamps_[i])));
-                fftPlans_.push_back(fftw_plan_r2r_1d(fftSize_[i],
-                            fftInputBuf_, fftOutputBuf_, FFTW_R2HC, FFTW_PATIENT));
-            }
+            if(uniform_)
+                fftSize_[i] = largestFFTSize;
             else
-                fftSize_[i] = fftSize_[0];
+                fftSize_[i] = pow(2,ceil(log2(windowSizeSamps_[i])));
 
-            //windows
             windows_[i].assign(windowSizeSamps_[i], 0.0);
             hannWindow(windows_[i], fftSize_[i]);
             LOUDNESS_DEBUG(name_ <<
@@ -240,38 +309,65 @@ namespace loudness{
         return 1;
     }
 
+    FFTWPlan PowerSpectrum::createPlan(int fftSize, int howMany, int offset)
+    {
+        return FFTWPlanCache::getR2RPlan(fftSize, howMany, fftSize, FFTW_R2HC,
+                fftInputBufs_[0] + offset, fftOutputBufs_[0] + offset);
+    }
+
     void PowerSpectrum::processInternal(const TrackBank &input)
     {
-        for (int track=0; track < input.getNTracks(); track++)
+        const int nTracks = input.getNTracks();
+        const int outStride = output_.getChannelStride();
+        processTracks(nBatches_, [&](int batch, int worker)
         {
-            //for each window
-            int binWriteIdx = 0;
-            for(int i=0; i<nWindows_; i++)
+            int firstTrack = batch * batchSize_;
+            int nBatchTracks = std::min(batchSize_, nTracks - firstTrack);
+            Real *fftInputBuf = fftInputBufs_[worker];
+            Real *fftOutputBuf = fftOutputBufs_[worker];
+            const vector<FFTWPlan> &plans = 
+                nBatchTracks < batchSize_ ? remainderPlans_ : fftPlans_;
+
+            //window each segment straight into its slot
+            for(int t=0; t<nBatchTracks; t++)
             {
-                //fill the buffer
-                for(int j=0; j<windowSizeSamps_[i]; j++)
-                    fftInputBuf_[j] = input.getSample(track, 0, windowDelay_[i]+j)*windows_[i][j];
-
-                //compute fft
-                if(uniform_)
-                    fftw_execute(fftPlans_[0]);
-                else
-                    fftw_execute(fftPlans_[i]);
-
-                //clear windowed data
-                for(int j=0; j<windowSizeSamps_[i]; j++)
-                    fftInputBuf_[j] = 0.0;
-
-                //Extract components from band and compute powers
-                Real re, im;
-                for(int j=bandBinIndices_[i][0]; j<=bandBinIndices_[i][1]; j++)
+                const Real *inputSignal = input.getSignalReadPointer(firstTrack + t, 0);
+                for(int i=0; i<nWindows_; i++)
                 {
-                    re = fftOutputBuf_[j];
-                    im = fftOutputBuf_[fftSize_[i]-j];
-                    output_.setSample(track, binWriteIdx++, 0, re*re + im*im);
+                    const Real *x = inputSignal + windowDelay_[i];
+                    const Real *w = &windows_[i][0];
+                    Real *slot = fftInputBuf + slotOffset_[i] + t * slotDist_[i];
+                    for(int j=0; j<windowSizeSamps_[i]; j++)
+                        slot[j] = x[j]*w[j];
                 }
             }
-        }
+
+            //compute ffts, reusing the plans on this worker's buffers
+            for(unsigned int p=0; p<plans.size(); p++)
+            {
+                int offset = uniform_ ? 0 : slotOffset_[p];
+                LOUDNESS_FFTW(execute_r2r)(plans[p], 
+                        fftInputBuf + offset, fftOutputBuf + offset);
+            }
+
+            //Extract components from band and compute powers
+            for(int t=0; t<nBatchTracks; t++)
+            {
+                Real *outputSignal = output_.getTrackWritePointer(firstTrack + t);
+                int binWriteIdx = 0;
+                for(int i=0; i<nWindows_; i++)
+                {
+                    const Real *spectrum = fftOutputBuf + slotOffset_[i] + t * slotDist_[i];
+                    Real re, im;
+                    for(int j=bandBinIndices_[i][0]; j<=bandBinIndices_[i][1]; j++)
+                    {
+                        re = spectrum[j];
+                        im = spectrum[fftSize_[i]-j];
+                        outputSignal[outStride * binWriteIdx++] = re*re + im*im;
+                    }
+                }
+            }
+        });
     }
 
     void PowerSpectrum::hannWindow(RealVec &w, int fftSize)
@@ -283,6 +379,11 @@ namespace loudness{
             w[i] = norm*(0.5+0.5*cos(2*PI*(i-0.5*(windowSize-1))/windowSize));
     }
 
+    bool PowerSpectrum::isStateless() const
+    {
+        return 1;
+    }
+
     void PowerSpectrum::resetInternal()
     {
         for(int i=0; i<nWindows_; i++)
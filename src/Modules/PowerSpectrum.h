@@ -20,7 +20,7 @@
 #ifndef POWERSPECTRUM_H
 #define POWERSPECTRUM_H
 
-#include <fftw3.h>
+#include "../Support/FFTW.h"
 #include "../Support/Module.h"
 
 namespace loudness{
@@ -53,6 +53,13 @@ namespace loudness{
      * In the current implementation, a Hann window is applied to all segments
      * and both DC and Nyquist are not computed.
      *
+     * Tracks are split into cache-sized batches, and each batch is
+     * transformed by FFTW's advanced (plan_many) interface. With uniform
+     * spectral sampling, all windows of all tracks in a batch are computed
+     * by a single FFTW call; otherwise one call is made per window. The
+     * batches do not depend on the number of threads, so neither does the
+     * output.
+     *
      * Each spectrum is scaled such that the sum of component powers in a given
      * band equals the average power in that band (see
      * http://www.dadisp.com/webhelp/dsphelp.htm#mergedprojects/refman2/SPLGROUP/POWSPEC.htm).
@@ -78,7 +85,9 @@ namespace loudness{
 
         virtual ~PowerSpectrum();
 
-    private:
+        virtual bool isStateless() const;
+
+    protected:
 
         virtual bool initializeInternal(const TrackBank &input);
 
@@ -86,17 +95,33 @@ namespace loudness{
 
         virtual void resetInternal();
 
+        /*
+         * Sets up everything but the transforms: window sizes, delays and
+         * functions, FFT sizes, the bins selected per band and the output
+         * TrackBank.
+         */
+        bool initializeBands(const TrackBank &input);
+
         void hannWindow(RealVec &w, int fftSize);
 
         RealVec bandFreqsHz_, windowSizeSecs_;
         bool uniform_;
         int nWindows_;
         Real temporalCentre_;
-        Real *fftInputBuf_, *fftOutputBuf_;
         vector<int> windowSizeSamps_, fftSize_, windowDelay_;
-        vector<fftw_plan> fftPlans_;
         RealVecVec windows_;
         vector<vector<int> > bandBinIndices_; 
+
+    private:
+
+        FFTWPlan createPlan(int fftSize, int howMany, int offset);
+
+        void destroyBuffers();
+
+        int batchSize_, nBatches_;
+        vector<Real*> fftInputBufs_, fftOutputBufs_;
+        vector<int> slotOffset_, slotDist_;
+        vector<FFTWPlan> fftPlans_, remainderPlans_;
     };
 }
 
@@ -19,9 +19,183 @@
 
 #include "PowerSpectrumAndSpatialDetection.h"
 #include "../Support/AuditoryTools.h"
+#include "../Support/SIMD.h"
+#include <algorithm>
+#include <limits>
 
 namespace loudness{
 
+    //bins per block of the masker product, held in registers for a tile
+    static const int MASKER_BLOCK_SIZE = 8;
+
+    /*
+     * Computes entries [start, start + B) of the masker rows of T targets:
+     * maskers[t][b] = sum_m weights[m][t] * spectra[m][b]. Spectrum and
+     * masker rows are rowSize apart and weight rows nInputs apart. The T x B
+     * accumulators stay in registers while the spectra are streamed once.
+     */
+    template<int T, int B>
+    static LOUDNESS_ALWAYS_INLINE void accumulateMaskerBlock(const Real *weights,
+            int nInputs, const Real *spectra, int rowSize, int start, Real *maskers)
+    {
+        Real acc[T][B];
+        for(int t=0; t<T; t++)
+            for(int b=0; b<B; b++)
+                acc[t][b] = 0.0;
+
+        for(int m=0; m<nInputs; m++)
+        {
+            const Real *spectrum = spectra + m * rowSize + start;
+            const Real *w = weights + m * nInputs;
+            for(int t=0; t<T; t++)
+                for(int b=0; b<B; b++)
+                    acc[t][b] += w[t] * spectrum[b];
+        }
+
+        for(int t=0; t<T; t++)
+            for(int b=0; b<B; b++)
+                maskers[t * rowSize + start + b] = acc[t][b];
+    }
+
+    template<int T>
+    static LOUDNESS_ALWAYS_INLINE void accumulateMaskers(const Real *weights,
+            int nInputs, const Real *spectra, int rowSize, Real *maskers)
+    {
+        int start = 0;
+        for(; start + MASKER_BLOCK_SIZE <= rowSize; start += MASKER_BLOCK_SIZE)
+            accumulateMaskerBlock<T, MASKER_BLOCK_SIZE>(weights, nInputs,
+                    spectra, rowSize, start, maskers);
+        for(; start < rowSize; start++)
+            accumulateMaskerBlock<T, 1>(weights, nInputs,
+                    spectra, rowSize, start, maskers);
+    }
+
+    template<int T>
+    static void accumulateMaskersDefault(const Real *weights, int nInputs,
+            const Real *spectra, int rowSize, Real *maskers)
+    {
+        accumulateMaskers<T>(weights, nInputs, spectra, rowSize, maskers);
+    }
+
+#if LOUDNESS_X86_DISPATCH
+    template<int T>
+    LOUDNESS_TARGET_AVX2 static void accumulateMaskersAVX2(const Real *weights,
+            int nInputs, const Real *spectra, int rowSize, Real *maskers)
+    {
+        accumulateMaskers<T>(weights, nInputs, spectra, rowSize, maskers);
+    }
+#endif
+
+    /*
+     * Masker rows of a tile of up to four targets. weights points to the
+     * column of the first target; the pair weights are symmetric, so the
+     * tile's weights for masker m are contiguous in row m.
+     */
+    static void accumulateMaskerTile(int nTargets, const Real *weights,
+            int nInputs, const Real *spectra, int rowSize, Real *maskers)
+    {
+        typedef void (*Kernel)(const Real*, int, const Real*, int, Real*);
+        static const Kernel defaultKernels[4] = {accumulateMaskersDefault<1>,
+            accumulateMaskersDefault<2>, accumulateMaskersDefault<3>,
+            accumulateMaskersDefault<4>};
+#if LOUDNESS_X86_DISPATCH
+        static const Kernel avx2Kernels[4] = {accumulateMaskersAVX2<1>,
+            accumulateMaskersAVX2<2>, accumulateMaskersAVX2<3>,
+            accumulateMaskersAVX2<4>};
+        if(cpuHasAVX2())
+        {
+            avx2Kernels[nTargets - 1](weights, nInputs, spectra, rowSize, maskers);
+            return;
+        }
+#endif
+        defaultKernels[nTargets - 1](weights, nInputs, spectra, rowSize, maskers);
+    }
+
+LOUDNESS_SIMD_BEGIN
+    /*
+     * Binaural analysis of bins [start, n) of a band, given the real and
+     * imaginary parts of the left and right spectra. Writes the summed real
+     * and imaginary parts, the power of the mean magnitude and the spatial
+     * position (0 to 180 degrees), and accumulates the power and the power
+     * weighted position. The position is the ratio of the quieter to the
+     * louder magnitude, scaled to [0, 90] when the left is louder and to
+     * [90, 180] otherwise, with a zero magnitude in the left (right) channel
+     * giving 0 (180). Selects replace the branches, so the lanes of a vector
+     * are computed together. Returns the number of bins processed, which is
+     * a multiple of the vector size.
+     */
+    template<class Ops>
+    static LOUDNESS_ALWAYS_INLINE int binauralBins(const Real *reL,
+            const Real *imL, const Real *reR, const Real *imR, int start,
+            int n, Real *re, Real *im, Real *power, Real *position,
+            Real &intensitySum, Real &positionSum)
+    {
+        typedef typename Ops::Vec Vec;
+        const Vec zero = Ops::set1(0.0), half = Ops::set1(0.5);
+        const Vec ninety = Ops::set1(90.0), oneEighty = Ops::set1(180.0);
+        Vec intensity = zero, weightedPosition = zero;
+
+        int j = start;
+        for(; j + Ops::size <= n; j += Ops::size)
+        {
+            const Vec rL = Ops::load(reL + j), iL = Ops::load(imL + j);
+            const Vec rR = Ops::load(reR + j), iR = Ops::load(imR + j);
+            const Vec magL = Ops::sqrt(Ops::add(Ops::mul(rL, rL), Ops::mul(iL, iL)));
+            const Vec magR = Ops::sqrt(Ops::add(Ops::mul(rR, rR), Ops::mul(iR, iR)));
+
+            const Vec offset = Ops::mul(ninety, Ops::div(Ops::min(magL, magR),
+                        Ops::max(magL, magR)));
+            Vec pos = Ops::select(Ops::gt(magL, magR), offset,
+                    Ops::sub(oneEighty, offset));
+            pos = Ops::select(Ops::eq(magR, zero), oneEighty, pos);
+            pos = Ops::select(Ops::eq(magL, zero), zero, pos);
+
+            const Vec mean = Ops::mul(Ops::add(magL, magR), half);
+            const Vec meanPower = Ops::mul(mean, mean);
+
+            Ops::store(re + j, Ops::add(rL, rR));
+            Ops::store(im + j, Ops::add(iL, iR));
+            Ops::store(power + j, meanPower);
+            Ops::store(position + j, pos);
+            intensity = Ops::add(intensity, meanPower);
+            weightedPosition = Ops::add(weightedPosition, Ops::mul(pos, meanPower));
+        }
+
+        intensitySum += Ops::sum(intensity);
+        positionSum += Ops::sum(weightedPosition);
+        return j;
+    }
+
+#if LOUDNESS_X86_DISPATCH
+    LOUDNESS_TARGET_AVX2 static int binauralBinsAVX2(const Real *reL,
+            const Real *imL, const Real *reR, const Real *imR, int n,
+            Real *re, Real *im, Real *power, Real *position,
+            Real &intensitySum, Real &positionSum)
+    {
+        return binauralBins<simd::AVX2<Real> >(reL, imL, reR, imR, 0, n,
+                re, im, power, position, intensitySum, positionSum);
+    }
+#endif
+LOUDNESS_SIMD_END
+
+    static void analyseBinaural(const Real *reL, const Real *imL,
+            const Real *reR, const Real *imR, int n, Real *re, Real *im,
+            Real *power, Real *position, Real &intensitySum, Real &positionSum)
+    {
+        int start = 0;
+#if LOUDNESS_X86_DISPATCH
+        if(cpuHasAVX2())
+            start = binauralBinsAVX2(reL, imL, reR, imR, n,
+                    re, im, power, position, intensitySum, positionSum);
+#endif
+#ifdef __SSE2__
+        start = binauralBins<simd::SSE2<Real> >(reL, imL, reR, imR, start, n,
+                re, im, power, position, intensitySum, positionSum);
+#endif
+        binauralBins<simd::Scalar<Real> >(reL, imL, reR, imR, start, n,
+                re, im, power, position, intensitySum, positionSum);
+    }
+
     PowerSpectrumAndSpatialDetection::PowerSpectrumAndSpatialDetection(
             const RealVec& bandFreqsHz, 
             const RealVec& windowSizeSecs, 
@@ -29,27 +203,35 @@ namespace loudness{
         Module("PowerSpectrumAndSpatialDetection"),
         bandFreqsHz_(bandFreqsHz),
         windowSizeSecs_(windowSizeSecs),
-        uniform_(uniform)
+        uniform_(uniform),
+        positionTolerance_(0.0)
     {}
 
     PowerSpectrumAndSpatialDetection::~PowerSpectrumAndSpatialDetection()
     { 
         if(initialized_)
         {
-            fftw_free(fftInputBufR_);
-            fftw_free(fftOutputBufR_);
-            fftw_free(fftInputBufL_);
-            fftw_free(fftOutputBufL_);
+            for(unsigned int i=0; i<fftInputBufsL_.size(); i++)
+            {
+                LOUDNESS_FFTW(free)(fftInputBufsR_[i]);
+                LOUDNESS_FFTW(free)(fftOutputBufsR_[i]);
+                LOUDNESS_FFTW(free)(fftInputBufsL_[i]);
+                LOUDNESS_FFTW(free)(fftOutputBufsL_[i]);
+            }
             LOUDNESS_DEBUG(name_ << ": Buffers destroyed.");
-
-            for(vector<fftw_plan>::iterator i = fftPlansR_.begin(); i != fftPlansR_.end(); i++)
-                fftw_destroy_plan(*i);
-            for(vector<fftw_plan>::iterator i = fftPlansL_.begin(); i != fftPlansL_.end(); i++)
-                fftw_destroy_plan(*i);
-            LOUDNESS_DEBUG(name_ << ": Plan(s) destroyed.");
         }
     }
 
+    void PowerSpectrumAndSpatialDetection::setPositionTolerance(Real positionTolerance)
+    {
+        positionTolerance_ = positionTolerance;
+    }
+
+    Real PowerSpectrumAndSpatialDetection::getPositionTolerance() const
+    {
+        return positionTolerance_;
+    }
+
     bool PowerSpectrumAndSpatialDetection::initializeInternal(const TrackBank &input)
     {
         LOUDNESS_WARNING(name_ 
@@ -104,11 +286,20 @@ namespace loudness{
         
             //allocate memory for FFT input buffers...all FFT inputs can make use of a single buffer
             //since we are not doing zero phase insersion
+            //one set of buffers per worker so tracks can be transformed concurrently
             fftSize_[0] = pow(2, ceil(log2(largestWindowSize)));
-            fftInputBufR_ = (Real*) fftw_malloc(sizeof(Real) * fftSize_[0]);
-            fftOutputBufR_ = (Real*) fftw_malloc(sizeof(Real) * fftSize_[0]);
-            fftInputBufL_ = (Real*) fftw_malloc(sizeof(Real) * fftSize_[0]);
-            fftOutputBufL_ = (Real*) fftw_malloc(sizeof(Real) * fftSize_[0]);
+            int nWorkers = getNWorkers();
+            fftInputBufsR_.resize(nWorkers);
+            fftOutputBufsR_.resize(nWorkers);
+            fftInputBufsL_.resize(nWorkers);
+            fftOutputBufsL_.resize(nWorkers);
+            for(int i=0; i<nWorkers; i++)
+            {
+                fftInputBufsR_[i] = (Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * fftSize_[0]);
+                fftOutputBufsR_[i] = (Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * fftSize_[0]);
+                fftInputBufsL_[i] = (Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * fftSize_[0]);
+                fftOutputBufsL_[i] = (Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * fftSize_[0]);
+            }
             
             //only 1 plan required if uniform spectral sampling 
             LOUDNESS_DEBUG(name_
@@ -118,10 +309,10 @@ namespace loudness{
 
             if(uniform_)
             {
-                fftPlansR_.push_back(fftw_plan_r2r_1d(fftSize_[0],
-                            fftInputBufR_, fftOutputBufR_, FFTW_R2HC, FFTW_PATIENT));
-                fftPlansL_.push_back(fftw_plan_r2r_1d(fftSize_[0],
-                            fftInputBufL_, fftOutputBufL_, FFTW_R2HC, FFTW_PATIENT));
+                fftPlansR_.push_back(FFTWPlanCache::getR2RPlan(fftSize_[0], 1, fftSize_[0], FFTW_R2HC,
+                            fftInputBufsR_[0], fftOutputBufsR_[0]));
+                fftPlansL_.push_back(FFTWPlanCache::getR2RPlan(fftSize_[0], 1, fftSize_[0], FFTW_R2HC,
+                            fftInputBufsL_[0], fftOutputBufsL_[0]));
                 LOUDNESS_DEBUG(name_ <<
                         ": Created a single " 
                         << fftSize_[0] 
@@ -136,10 +327,10 @@ namespace loudness{
                 if(!uniform_)
                 {
                     fftSize_[i] = pow(2,ceil(log2(windowSizeSamps_[i])));
-                    fftPlansR_.push_back(fftw_plan_r2r_1d(fftSize_[i],
-                                fftInputBufR_, fftOutputBufR_, FFTW_R2HC, FFTW_PATIENT));
-                    fftPlansL_.push_back(fftw_plan_r2r_1d(fftSize_[i],
-                                fftInputBufL_, fftOutputBufL_, FFTW_R2HC, FFTW_PATIENT));
+                    fftPlansR_.push_back(FFTWPlanCache::getR2RPlan(fftSize_[i], 1, fftSize_[i], FFTW_R2HC,
+                                fftInputBufsR_[0], fftOutputBufsR_[0]));
+                    fftPlansL_.push_back(FFTWPlanCache::getR2RPlan(fftSize_[i], 1, fftSize_[i], FFTW_R2HC,
+                                fftInputBufsL_[0], fftOutputBufsL_[0]));
                 }
                 else
                     fftSize_[i] = fftSize_[0];
@@ -152,6 +343,16 @@ namespace loudness{
                         << ", for "  <<  fftSize_[i] << "-point FFT");
             }
 
+            //zero padding relies on the buffers being clear
+            for(int i=0; i<nWorkers; i++)
+            {
+                for(int j=0; j<fftSize_[0]; j++)
+                {
+                    fftInputBufsR_[i][j] = 0.0;
+                    fftInputBufsL_[i][j] = 0.0;
+                }
+            }
+
             //desired bins indices (lo and hi) per band
             bandBinIndices_.resize(nWindows_);
 
@@ -254,16 +455,21 @@ namespace loudness{
 
             // also initialize real and imaginary buffers
             // we only need one for each pair of tracks
-            maskerReal_.resize(nBins_);
-            maskerImag_.resize(nBins_);
-            avgPositions_.resize(nInputs_);
-            real_.resize(nInputs_);
-            imag_.resize(nInputs_);
-            for (int i = 0; i < nInputs_; i++)
-            {
-                real_[i].resize(nBins_);
-                imag_[i].resize(nBins_);
-            }
+            spectra_.assign(nInputs_ * 2 * nBins_, 0.0);
+            maskerBufs_.assign(getNWorkers(), RealVec(4 * 2 * nBins_, 0.0));
+
+            // imaginary parts of the left and right band in ascending order
+            maxBandBins_ = 0;
+            for(int i=0; i<nWindows_; i++)
+                maxBandBins_ = std::max(maxBandBins_,
+                        bandBinIndices_[i][1] - bandBinIndices_[i][0] + 1);
+            binauralBufs_.assign(getNWorkers(), RealVec(2 * maxBandBins_, 0.0));
+            avgPositions_.assign(nInputs_, 0.0);
+
+            // no weights until the first positions are known
+            pairWeights_.assign(nInputs_ * nInputs_, 0.0);
+            weightPositions_.assign(nInputs_,
+                    std::numeric_limits<Real>::quiet_NaN());
 
             //output frequencies in Hz
             int j = 0, k = 0;
@@ -287,122 +493,131 @@ namespace loudness{
     void PowerSpectrumAndSpatialDetection::processInternal(const TrackBank &input)
     {
         // first perform ffts on every track
-        for (int track=0; track < nInputs_; track++)
+        processTracks(nInputs_, [&](int track, int worker)
         {
+            Real *fftInputBufL = fftInputBufsL_[worker];
+            Real *fftInputBufR = fftInputBufsR_[worker];
+            Real *fftOutputBufL = fftOutputBufsL_[worker];
+            Real *fftOutputBufR = fftOutputBufsR_[worker];
+
             //for each window
             int binWriteIdx = 0;
             const int lIdx = track * 2;
             const int rIdx = track * 2 + 1;
             Real positionSum = 0;
             Real intensitySum = 0;
+            Real *spectrum = &spectra_[track * 2 * nBins_];
+            Real *imagL = &binauralBufs_[worker][0];
+            Real *imagR = imagL + maxBandBins_;
+
+            //one sample per channel, so the channels are contiguous
+            Real *power = output_.getTrackWritePointer(track);
+            Real *positions = output_.getSpatialPositionWritePointer(track);
             for(int i=0; i<nWindows_; i++)
             {
                 //fill the buffers
                 for(int j=0; j<windowSizeSamps_[i]; j++)
                 {
-                    fftInputBufL_[j] = input.getSample(lIdx, 0, windowDelay_[i]+j)*windows_[i][j];
-                    fftInputBufR_[j] = input.getSample(rIdx, 0, windowDelay_[i]+j)*windows_[i][j];
+                    fftInputBufL[j] = input.getSample(lIdx, 0, windowDelay_[i]+j)*windows_[i][j];
+                    fftInputBufR[j] = input.getSample(rIdx, 0, windowDelay_[i]+j)*windows_[i][j];
                 }
 
                 //compute ffts
                 if(uniform_)
                 {
-                    fftw_execute(fftPlansL_[0]);
-                    fftw_execute(fftPlansR_[0]);
+                    LOUDNESS_FFTW(execute_r2r)(fftPlansL_[0], fftInputBufL, fftOutputBufL);
+                    LOUDNESS_FFTW(execute_r2r)(fftPlansR_[0], fftInputBufR, fftOutputBufR);
                 }
                 else
                 {
-                    fftw_execute(fftPlansL_[i]);
-                    fftw_execute(fftPlansR_[i]);
+                    LOUDNESS_FFTW(execute_r2r)(fftPlansL_[i], fftInputBufL, fftOutputBufL);
+                    LOUDNESS_FFTW(execute_r2r)(fftPlansR_[i], fftInputBufR, fftOutputBufR);
                 }
 
                 //clear windowed data
                 for(int j=0; j<windowSizeSamps_[i]; j++)
                 {
-                    fftInputBufL_[j] = 0.0;
-                    fftInputBufR_[j] = 0.0;
+                    fftInputBufL[j] = 0.0;
+                    fftInputBufR[j] = 0.0;
                 }
 
                 //Extract components from band and compute powers
-                Real reR, reL, imR, imL, magR, magL, pos;
-                for(int j=bandBinIndices_[i][0]; j<=bandBinIndices_[i][1]; j++)
+                const int lo = bandBinIndices_[i][0];
+                const int nBandBins = bandBinIndices_[i][1] - lo + 1;
+                for(int j=0; j<nBandBins; j++)
                 {
-                    // left channel
-                    reL = fftOutputBufL_[j];
-                    imL = fftOutputBufL_[fftSize_[i]-j];
-                    magL = sqrt(pow(reL,2) + pow(imL, 2));
-
-                    // right channel
-                    reR = fftOutputBufR_[j];
-                    imR = fftOutputBufR_[fftSize_[i]-j];
-                    magR = sqrt(pow(reR,2) + pow(imR, 2));
-
-                    // calculate spatial position
-                    // 0 is all the way left
-                    // 180 is all the way right
-                    if (magL == 0) // signal all the way left
-                    {
-                        pos = 0;
-                    }
-                    else if  (magR == 0) // signal all the way right
-                    {
-                        pos = 180.0;
-                    }
-                    else if (magL > magR) // signal partially left
-                    {
-                        pos = (magR / magL) * 90.0;
-                    }
-                    else // signal partially right
-                    {
-                        pos = (1.0 - (magL / magR)) * 90.0 + 90.0;
-                    }
-                    output_.setSpatialPosition(track, binWriteIdx, pos);
-
-                    // calculate magnitude of output bin
-                    real_[track][binWriteIdx] = reL + reR;
-                    imag_[track][binWriteIdx] = imL + imR;
-                    const Real mag = pow((magL + magR) / 2, 2);
-
-                    // update weighted position sum
-                    intensitySum += mag;
-                    positionSum += pos * mag;
-
-                    output_.setSample(track, binWriteIdx, 0, mag); 
-                    binWriteIdx++;
+                    imagL[j] = fftOutputBufL[fftSize_[i] - lo - j];
+                    imagR[j] = fftOutputBufR[fftSize_[i] - lo - j];
                 }
+                analyseBinaural(fftOutputBufL + lo, imagL,
+                        fftOutputBufR + lo, imagR, nBandBins,
+                        spectrum + binWriteIdx, spectrum + nBins_ + binWriteIdx,
+                        power + binWriteIdx, positions + binWriteIdx,
+                        intensitySum, positionSum);
+                binWriteIdx += nBandBins;
             }
 
             // calculate average position of track
             avgPositions_[track] = positionSum / intensitySum;
+        });
+
+        updatePairWeights();
+
+        // next sum tracks to create background masker tracks, four
+        // targets at a time
+        const int rowSize = 2 * nBins_;
+        const int nTiles = (nInputs_ + 3) / 4;
+        processTracks(nTiles, [&](int tile, int worker)
+        {
+            const int first = tile * 4;
+            const int nTargets = std::min(4, nInputs_ - first);
+            Real *maskers = &maskerBufs_[worker][0];
+            accumulateMaskerTile(nTargets, &pairWeights_[first], nInputs_,
+                    &spectra_[0], rowSize, maskers);
+
+            // set output
+            const int channelStride = output_.getChannelStride();
+            for(int t=0; t<nTargets; t++)
+            {
+                const Real *maskerReal = maskers + t * rowSize;
+                const Real *maskerImag = maskerReal + nBins_;
+                Real *out = output_.getTrackWritePointer(first + t + nInputs_);
+                for(int bin=0; bin<nBins_; bin++)
+                    out[bin * channelStride] = maskerReal[bin] * maskerReal[bin]
+                        + maskerImag[bin] * maskerImag[bin];
+            }
+        });
+    }
+
+    void PowerSpectrumAndSpatialDetection::updatePairWeights()
+    {
+        // NaN positions (silent sources) always count as moved
+        vector<int> moved;
+        for(int i=0; i<nInputs_; i++)
+        {
+            if(!(fabs(avgPositions_[i] - weightPositions_[i]) <= positionTolerance_))
+            {
+                weightPositions_[i] = avgPositions_[i];
+                moved.push_back(i);
+            }
         }
 
-        // next sum tracks to create background masker tracks
-        Real separation, multiplier;
-        for (int target = 0; target < nInputs_; target++)
+        // weights are symmetric in the pair, and zero on the diagonal so a
+        // target does not mask itself
+        for(unsigned int k=0; k<moved.size(); k++)
         {
-            // initialize masker track with 0's in real and imag components
-            const int maskerWriteIdx = target + nInputs_;
-            maskerReal_.assign(nBins_, 0.0);
-            maskerImag_.assign(nBins_, 0.0);
-            
-            // reduce and sum the components for each bin
-            for (int masker = 0; masker < nInputs_; masker++)
+            const int i = moved[k];
+            for(int j=0; j<nInputs_; j++)
             {
-                if (target != masker)
+                Real multiplier = 0.0;
+                if(i != j)
                 {
-                    separation = abs(avgPositions_[target] - avgPositions_[masker]);
+                    Real separation = fabs(weightPositions_[i] - weightPositions_[j]);
                     multiplier = pow(10, separationTodBReduction(separation) / 20);
-                    for (int bin = 0; bin < nBins_; bin++)
-                    {
-                        maskerReal_[bin] += real_[masker][bin] * multiplier;
-                        maskerImag_[bin] += imag_[masker][bin] * multiplier;
-                    }
                 }
+                pairWeights_[i * nInputs_ + j] = multiplier;
+                pairWeights_[j * nInputs_ + i] = multiplier;
             }
-
-            // set output
-            for (int bin = 0; bin < nBins_; bin++)
-                output_.setSample(maskerWriteIdx, bin, 0, pow(maskerReal_[bin], 2) + pow(maskerImag_[bin], 2));
         }
     }
 
@@ -419,6 +634,7 @@ namespace loudness{
     {
         for(int i=0; i<nWindows_; i++)
             windowDelay_[i] = (int)round(temporalCentre_ - (windowSizeSamps_[i]-1)/2.0);
+        weightPositions_.assign(nInputs_, std::numeric_limits<Real>::quiet_NaN());
     }
 }
 
@@ -20,7 +20,7 @@
 #ifndef POWERSPECTRUMANDSPATIALDETECTION_H
 #define POWERSPECTRUMANDSPATIALDETECTION_H
 
-#include <fftw3.h>
+#include "../Support/FFTW.h"
 #include "../Support/Module.h"
 
 namespace loudness{
@@ -57,6 +57,23 @@ namespace loudness{
      * band equals the average power in that band (see
      * http://www.dadisp.com/webhelp/dsphelp.htm#mergedprojects/refman2/SPLGROUP/POWSPEC.htm).
      *
+     * The input holds a left and right track per source. The first half of
+     * the output holds the spectrum of each source, with the spatial position
+     * of each bin derived from the left and right magnitudes. The second half
+     * holds its background masker. The masker is the complex sum of the
+     * spectra of all other sources, each attenuated according to its spatial
+     * separation from the target (see separationTodBReduction()). The maskers are the
+     * product of a pair-weight matrix and the stacked real and imaginary
+     * spectra. This product is computed in tiles of targets and blocks of bins
+     * so that each spectrum is read once per tile. A source's weights are only
+     * recomputed when its average position has moved by more than the
+     * position tolerance since they were last computed (see
+     * setPositionTolerance()).
+     *
+     * The binaural analysis of each band (magnitudes, positions and powers)
+     * and the masker product are vectorised, using AVX2 when the processor
+     * supports it.
+     *
      * @todo Develop window class to allow for more functions.
      *
      * @author Dominic Ward
@@ -78,6 +95,19 @@ namespace loudness{
 
         virtual ~PowerSpectrumAndSpatialDetection();
 
+        /**
+         * @brief Sets the change in average position (degrees) a source
+         * needs before its masker weights are recomputed.
+         *
+         * The default of 0 recomputes the weights of a source whenever its
+         * position changes. The attenuation changes by at most 0.82 dB per
+         * degree of separation, so e.g. 0.01 degrees keeps the weights within
+         * 0.01 dB. The error in the complex masker sums can be larger.
+         */
+        void setPositionTolerance(Real positionTolerance);
+
+        Real getPositionTolerance() const;
+
     private:
 
         virtual bool initializeInternal(const TrackBank &input);
@@ -88,20 +118,33 @@ namespace loudness{
 
         void hannWindow(RealVec &w, int fftSize);
 
-        
-        RealVecVec real_;
-        RealVecVec imag_;
+        /*
+         * Recomputes the pair weights of every source whose average position
+         * has moved beyond the tolerance.
+         */
+        void updatePairWeights();
+
         RealVec bandFreqsHz_, windowSizeSecs_, avgPositions_;
         bool uniform_;
-        int nWindows_, nBins_, nTracks_, nInputs_;
-        Real temporalCentre_;
-        Real *fftInputBufR_, *fftOutputBufR_, *fftInputBufL_, *fftOutputBufL_;
+        int nWindows_, nBins_, nTracks_, nInputs_, maxBandBins_;
+        Real temporalCentre_, positionTolerance_;
+        vector<Real*> fftInputBufsR_, fftOutputBufsR_, fftInputBufsL_, fftOutputBufsL_;
         vector<int> windowSizeSamps_, fftSize_, windowDelay_;
-        vector<fftw_plan> fftPlansR_;
-        vector<fftw_plan> fftPlansL_;
-        RealVec maskerReal_;
-        RealVec maskerImag_;
+        vector<FFTWPlan> fftPlansR_;
+        vector<FFTWPlan> fftPlansL_;
         RealVecVec windows_;
+
+        //per source: real then imaginary part of each bin
+        RealVec spectra_;
+
+        //[target][masker] amplitude weights and the positions they were computed at
+        RealVec pairWeights_, weightPositions_;
+
+        //per worker: real and imaginary masker rows of a tile of targets
+        RealVecVec maskerBufs_;
+
+        //per worker: imaginary parts of the left and right band
+        RealVecVec binauralBufs_;
         vector<vector<int> > bandBinIndices_; 
     };
 }
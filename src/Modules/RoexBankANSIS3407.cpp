@@ -19,20 +19,103 @@
 
 #include "RoexBankANSIS3407.h"
 #include "../Support/AuditoryTools.h"
+#include "../Support/SIMDMath.h"
 
 namespace loudness{
 
+    /*
+     * The simd:: functions called by the kernels below are instantiated at
+     * the end of this file, where the ABI warning for them is reported, so
+     * the region is left open to the end of the file.
+     */
+LOUDNESS_SIMD_BEGIN
+    /*
+     * Excitation of one filter: the level dependent lower skirt over nLower
+     * channels, given g and the level per ERB (minus 51 dB) of each, plus the
+     * stored upper skirt weights over nUpper channels.
+     */
+    template<class Ops>
+    static LOUDNESS_ALWAYS_INLINE Real filterExcitation(const Real *lowerG,
+            const Real *level, const Real *lowerInput, int nLower, Real pu,
+            Real pl, const Real *upperWeights, const Real *upperInput,
+            int nUpper)
+    {
+        typedef typename Ops::Vec Vec;
+        typedef simd::Scalar<Real> S;
+        const Vec zero = Ops::set1(0.0), one = Ops::set1(1.0);
+        const Vec pMin = Ops::set1(0.1), vpu = Ops::set1(pu), vpl = Ops::set1(pl);
+        Vec acc = zero;
+        int j = 0;
+        for(; j + Ops::size <= nLower; j += Ops::size)
+        {
+            //p can go negative for very high levels
+            Vec p = Ops::max(Ops::sub(vpu, Ops::mul(vpl, Ops::load(level + j))), pMin);
+            Vec pg = Ops::sub(zero, Ops::mul(p, Ops::load(lowerG + j)));
+            Vec w = Ops::mul(Ops::add(one, pg), simd::vexp<Ops>(Ops::sub(zero, pg)));
+            acc = Ops::add(acc, Ops::mul(w, Ops::load(lowerInput + j)));
+        }
+        Real excitationLin = Ops::sum(acc);
+        for(; j < nLower; j++)
+        {
+            Real p = S::max(pu - (pl * level[j]), 0.1);
+            Real pg = -p * lowerG[j];
+            excitationLin += (1 + pg) * simd::vexp<S>(-pg) * lowerInput[j];
+        }
+
+        return excitationLin + simd::dot<Ops>(upperWeights, upperInput, nUpper);
+    }
+
+    static Real dotDefault(const Real *a, const Real *b, int n)
+    {
+        return simd::dot<simd::Baseline<Real> >(a, b, n);
+    }
+
+    static Real filterExcitationDefault(const Real *lowerG, const Real *level,
+            const Real *lowerInput, int nLower, Real pu, Real pl,
+            const Real *upperWeights, const Real *upperInput, int nUpper)
+    {
+        return filterExcitation<simd::Baseline<Real> >(lowerG, level,
+                lowerInput, nLower, pu, pl, upperWeights, upperInput, nUpper);
+    }
+
+#if LOUDNESS_X86_DISPATCH
+    LOUDNESS_TARGET_AVX2 static Real dotAVX2(const Real *a, const Real *b, int n)
+    {
+        return simd::dot<simd::AVX2<Real> >(a, b, n);
+    }
+
+    LOUDNESS_TARGET_AVX2 static Real filterExcitationAVX2(const Real *lowerG,
+            const Real *level, const Real *lowerInput, int nLower, Real pu,
+            Real pl, const Real *upperWeights, const Real *upperInput,
+            int nUpper)
+    {
+        return filterExcitation<simd::AVX2<Real> >(lowerG, level,
+                lowerInput, nLower, pu, pl, upperWeights, upperInput, nUpper);
+    }
+#endif
+
     RoexBankANSIS3407::RoexBankANSIS3407(Real camLo, Real camHi, Real camStep) : 
         Module("RoexBankANSIS3407"),
         camLo_(camLo), 
         camHi_(camHi),
-        camStep_(camStep)
+        camStep_(camStep),
+        levelResolution_(0)
     {}
 
     RoexBankANSIS3407::~RoexBankANSIS3407()
     {
     }
 
+    void RoexBankANSIS3407::setLevelResolution(Real levelResolution)
+    {
+        levelResolution_ = levelResolution;
+    }
+
+    Real RoexBankANSIS3407::getLevelResolution() const
+    {
+        return levelResolution_;
+    }
+
     bool RoexBankANSIS3407::initializeInternal(const TrackBank &input)
     {
         //number of input components
@@ -51,7 +134,8 @@ namespace loudness{
         pcomp_.assign(nChannels, 0.0);
 
         //comp_level holds level per ERB on each component
-        compLevel_.assign(nChannels, 0.0);
+        //level per ERB scratch, one per worker
+        compLevel_.assign(getNWorkers(), RealVec(nChannels, 0.0));
 
         //p upper is level invariant
         pu_.assign(nFilters_, 0.0);
@@ -77,82 +161,188 @@ namespace loudness{
             output_.setCentreFreq(i,fc);
         }
 
+        /*
+         * Level independent weights. Input centre frequencies are in
+         * ascending order, so each row covers channels from the first up to
+         * the last with g <= 2.
+         */
+        Real g, pg;
+        levelEnd_.assign(nChannels, 0);
+        levelOffset_.assign(nChannels, 0);
+        levelWeights_.clear();
+        for(int i=0; i<nChannels; i++)
+        {
+            levelOffset_[i] = levelWeights_.size();
+            fc = input.getCentreFreq(i);
+            int j = 0;
+            while(j<nChannels)
+            {
+                g = (input.getCentreFreq(j)-fc)/fc;
+                if(g>2)
+                    break;
+                pg = g<0 ? -pcomp_[i]*g : pcomp_[i]*g;
+                levelWeights_.push_back((1+pg)*exp(-pg));
+                j++;
+            }
+            levelEnd_[i] = j;
+        }
+
+        centreChannel_.assign(nFilters_, 0);
+        upperEnd_.assign(nFilters_, 0);
+        upperOffset_.assign(nFilters_, 0);
+        lowerOffset_.assign(nFilters_, 0);
+        upperWeights_.clear();
+        lowerG_.clear();
+        for(int i=0; i<nFilters_; i++)
+        {
+            lowerOffset_[i] = lowerG_.size();
+            upperOffset_[i] = upperWeights_.size();
+            fc = output_.getCentreFreq(i);
+            int j = 0;
+            while(j<nChannels)
+            {
+                g = (input.getCentreFreq(j)-fc)/fc;
+                if(g>=0)
+                    break;
+                lowerG_.push_back(g);
+                j++;
+            }
+            centreChannel_[i] = j;
+            while(j<nChannels)
+            {
+                g = (input.getCentreFreq(j)-fc)/fc;
+                if(g>2)
+                    break;
+                pg = pu_[i]*g;
+                upperWeights_.push_back((1+pg)*exp(-pg));
+                j++;
+            }
+            upperEnd_[i] = j;
+        }
+
+        LOUDNESS_DEBUG(name_ << ": Stored " << levelWeights_.size()
+                << " level weights, " << upperWeights_.size()
+                << " upper skirt weights and " << lowerG_.size()
+                << " lower skirt deviations.");
+
+        spectrum_.assign(getNWorkers(), RealVec(nChannels, 0.0));
+        excitation_.assign(getNWorkers(), RealVec(nFilters_, 0.0));
+
+        /*
+         * Level quantised lower skirt weights, as in FastRoexBank: levels
+         * from the floor of -151 up to where p reaches its minimum in every
+         * filter.
+         */
+        lowerSkirtCache_.clear();
+        if(levelResolution_ > 0)
+        {
+            vector<int> firstFilter(nChannels, nFilters_);
+            Real levelHi = -151.0;
+            for(int i=nFilters_-1; i>=0; i--)
+            {
+                for(int j=0; j<centreChannel_[i]; j++)
+                    firstFilter[j] = i;
+                Real level = (pu_[i] - 0.1) / pl_[i];
+                levelHi = level > levelHi ? level : levelHi;
+            }
+
+            if(lowerSkirtCache_.initialize(firstFilter, nFilters_, -151.0,
+                        levelHi, levelResolution_))
+            {
+                lowerSkirtCache_.fill([&](int j, int i, Real level)
+                {
+                    Real p = pu_[i] - (pl_[i] * level);
+                    p = p < 0.1 ? 0.1 : p;
+                    Real pg = -p * lowerG_[lowerOffset_[i] + j];
+                    return (1 + pg) * exp(-pg);
+                });
+            }
+            else
+            {
+                LOUDNESS_WARNING(name_
+                        << ": Evaluating lower skirts without the level cache.");
+            }
+        }
+
         return 1;
     }
 
 
     void RoexBankANSIS3407::processInternal(const TrackBank &input)
     {
-        Real excitationLin, fc, g, p, pg;
-
-        //ANSI 2007 style: calculate level per ERB
-        //using level independent roex filters centred on every component
-        int j;
         int nChannels = input.getNChannels();
-        for (int track = 0; track < input.getNTracks(); track++)
+        const int inStride = input.getChannelStride();
+        const bool avx2 = cpuHasAVX2();
+        processTracks(input.getNTracks(), [&](int track, int worker)
         {
-            for(int i=0; i<nChannels; i++)
+            Real excitationLin;
+            RealVec &compLevel = compLevel_[worker];
+
+            //contiguous input
+            const Real *x = input.getTrackReadPointer(track);
+            if(inStride != 1)
             {
-                excitationLin = 0;
-                j=0;
-                fc = input.getCentreFreq(i);
+                for(int j=0; j<nChannels; j++)
+                    spectrum_[worker][j] = x[inStride * j];
+                x = &spectrum_[worker][0];
+            }
 
-                while(j<nChannels)
-                {
-                    //normalised deviation
-                    g = (input.getCentreFreq(j)-fc)/fc;
-
-                    if(g>2)
-                        break;
-                    if(g<0) //lower value 
-                        pg = -pcomp_[i]*g; //p*abs(g)
-                    else //upper value
-                        pg = pcomp_[i]*g;
-                    //excitation per erb
-                    excitationLin += (1+pg)*exp(-pg)*input.getSample(track, j++, 0); 
-                }
+            //ANSI 2007 style: calculate level per ERB
+            //using level independent roex filters centred on every component
+            for(int i=0; i<nChannels; i++)
+            {
+                const Real *weights = &levelWeights_[levelOffset_[i]];
+#if LOUDNESS_X86_DISPATCH
+                if(avx2)
+                    excitationLin = dotAVX2(weights, x, levelEnd_[i]);
+                else
+#endif
+                    excitationLin = dotDefault(weights, x, levelEnd_[i]);
 
                 //convert to dB, subtract 51 here to save operations later
                 if (excitationLin < 1e-10)
-                    compLevel_[i] = -151.0;
+                    compLevel[i] = -151.0;
                 else
-                    compLevel_[i] = 10*log10(excitationLin)-51;
+                    compLevel[i] = 10*log10(excitationLin)-51;
 
-                LOUDNESS_DEBUG("RoexBankGM: ERB/dB : " << compLevel_[i]);
+                LOUDNESS_DEBUG("RoexBankGM: ERB/dB : " << compLevel[i]);
             }
             
             //now the excitation pattern
+            const bool cached = lowerSkirtCache_.isInitialized();
+            Real *excitation = &excitation_[worker][0];
             for(int i=0; i<nFilters_; i++)
             {
-                excitationLin = 0;
-                j=0;
-                fc = output_.getCentreFreq(i);
+                const int centre = centreChannel_[i];
+                const int nLower = cached ? 0 : centre;
+                const Real *lowerG = &lowerG_[0] + lowerOffset_[i];
+                const Real *upperWeights = &upperWeights_[0] + upperOffset_[i];
+#if LOUDNESS_X86_DISPATCH
+                if(avx2)
+                    excitationLin = filterExcitationAVX2(lowerG, &compLevel[0],
+                            x, nLower, pu_[i], pl_[i], upperWeights, x + centre,
+                            upperEnd_[i] - centre);
+                else
+#endif
+                    excitationLin = filterExcitationDefault(lowerG, &compLevel[0],
+                            x, nLower, pu_[i], pl_[i], upperWeights, x + centre,
+                            upperEnd_[i] - centre);
 
-                while(j<nChannels)
-                {
-                    //normalised deviation
-                    g = (input.getCentreFreq(j)-fc)/fc;
-
-                    if (g>2)
-                        break;
-                    if(g<0) //lower value 
-                    {
-                        //checked out 2.4.14
-                        p = pu_[i]-(pl_[i]*compLevel_[j]); //51dB subtracted above
-                        p = p < 0.1 ? 0.1 : p; //p can go negative for very high levels
-                        pg = -p*g; //p*abs(g)
-                    }
-                    else //upper value
-                    {
-                        pg = pu_[i]*g;
-                    }
-
-                    excitationLin += (1+pg)*exp(-pg)*input.getSample(track, j++, 0); //excitation per erb
-                }
-
-                output_.setSample(track, i, 0, excitationLin);
+                excitation[i] = excitationLin;
             }
-        }
+
+            //lower skirts from the level cache
+            if(cached)
+                lowerSkirtCache_.accumulate(x, &compLevel[0], excitation);
+
+            for(int i=0; i<nFilters_; i++)
+                output_.setSample(track, i, 0, excitation[i]);
+        });
+    }
+
+    bool RoexBankANSIS3407::isStateless() const
+    {
+        return 1;
     }
 
     void RoexBankANSIS3407::resetInternal(){};
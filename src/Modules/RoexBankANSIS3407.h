@@ -21,6 +21,7 @@
 #define ROEXBANKANSIS3407_H
 
 #include "../Support/Module.h"
+#include "../Support/LevelWeightCache.h"
 
 namespace loudness{
 
@@ -33,6 +34,22 @@ namespace loudness{
      *
      * ANSI S3.4-2007. (2007).  Procedure for the Computation of Loudness of
      * Steady Sounds.
+     *
+     * The level per ERB on each component uses level independent filters,
+     * so their weights are computed at initialisation and stored as a sparse
+     * banded matrix (each row spans the channels from the lowest up to g = 2).
+     * The upper skirts of the level dependent filters are stored in the same
+     * way. Per frame, only the lower skirt weights are evaluated, with a
+     * vectorised exponential (see SIMDMath.h) and AVX2 when the processor
+     * supports it. The stored weights are exact. The vectorised exponential
+     * has a relative error below 5e-16 (2e-7 with single precision), so
+     * outputs agree with a direct evaluation to about 1e-14 relative.
+     *
+     * With setLevelResolution(), the lower skirt weights are read from a
+     * LevelWeightCache instead, holding them for every filter and channel at
+     * levels per ERB spaced by the resolution, interpolated linearly between
+     * levels. If the cache would exceed its memory limit, the lower skirts
+     * are evaluated directly.
      */
     class RoexBankANSIS3407 : public Module
     {
@@ -43,6 +60,16 @@ namespace loudness{
 
         virtual ~RoexBankANSIS3407();
 
+        /**
+         * @brief Sets the level resolution in dB of cached lower skirt
+         * weights, or 0 (default) to evaluate them per frame.
+         */
+        void setLevelResolution(Real levelResolution);
+
+        Real getLevelResolution() const;
+
+        virtual bool isStateless() const;
+
     private:
 
         virtual bool initializeInternal(const TrackBank &input);
@@ -52,8 +79,23 @@ namespace loudness{
         virtual void resetInternal();
 
         int nFilters_;
-        Real camLo_, camHi_, camStep_;
-        RealVec pu_, pl_, pcomp_, compLevel_;
+        Real camLo_, camHi_, camStep_, levelResolution_;
+        RealVec pu_, pl_, pcomp_;
+        RealVecVec compLevel_;
+
+        /*
+         * Per component: weights of channels [0, levelEnd) from
+         * levelOffset_. Per filter: channels [0, centre) form the lower
+         * skirt, with g stored from lowerOffset_, and [centre, upperEnd) the
+         * upper skirt, with weights stored from upperOffset_.
+         */
+        vector<int> levelEnd_, levelOffset_;
+        vector<int> centreChannel_, upperEnd_, upperOffset_, lowerOffset_;
+        RealVec levelWeights_, upperWeights_, lowerG_;
+
+        //contiguous input and excitation per filter, one per worker
+        RealVecVec spectrum_, excitation_;
+        LevelWeightCache lowerSkirtCache_;
     };
 }
 
@@ -0,0 +1,475 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SlidingPowerSpectrum.h"
+#include <algorithm>
+
+namespace loudness{
+
+    SlidingPowerSpectrum::SlidingPowerSpectrum(
+            const RealVec& bandFreqsHz,
+            const RealVec& windowSizeSecs,
+            bool uniform,
+            int anchorInterval) :
+        PowerSpectrum(bandFreqsHz, windowSizeSecs, uniform),
+        anchorInterval_(anchorInterval),
+        autotune_(false),
+        timeWindows_(false)
+    {
+        name_ = "SlidingPowerSpectrum";
+    }
+
+    SlidingPowerSpectrum::~SlidingPowerSpectrum()
+    {
+        destroyTransformBuffers();
+    }
+
+    void SlidingPowerSpectrum::destroyTransformBuffers()
+    {
+        for(unsigned int i=0; i<transformInputBufs_.size(); i++)
+        {
+            LOUDNESS_FFTW(free)(transformInputBufs_[i]);
+            LOUDNESS_FFTW(free)(transformOutputBufs_[i]);
+        }
+        transformInputBufs_.clear();
+        transformOutputBufs_.clear();
+    }
+
+    void SlidingPowerSpectrum::setAnchorInterval(int anchorInterval)
+    {
+        anchorInterval_ = anchorInterval;
+    }
+
+    int SlidingPowerSpectrum::getAnchorInterval() const
+    {
+        return anchorInterval_;
+    }
+
+    void SlidingPowerSpectrum::setAutotune(bool autotune)
+    {
+        autotune_ = autotune;
+    }
+
+    bool SlidingPowerSpectrum::getAutotune() const
+    {
+        return autotune_;
+    }
+
+    bool SlidingPowerSpectrum::initializeInternal(const TrackBank &input)
+    {
+        if(!initializeBands(input))
+            return 0;
+
+        //hop size of the incoming frames
+        hopSize_ = (int)round(input.getFs() / input.getFrameRate());
+        LOUDNESS_DEBUG(name_ << ": Hop size in samples: " << hopSize_);
+
+        /*
+         * Pick the cheapest method per window, in approximate flops:
+         * sliding a bin costs two Goertzel recursions over the hop for each
+         * of its three sums, a direct Goertzel costs one over the window and
+         * an FFT evaluates all bins at once.
+         */
+        methods_.assign(nWindows_, GOERTZEL);
+        for(int i=0; i<nWindows_; i++)
+        {
+            int nBins = bandBinIndices_[i][1] - bandBinIndices_[i][0] + 1;
+            double goertzelCost = 3.0 * windowSizeSamps_[i] * nBins;
+            double slideCost = 18.0 * hopSize_ * nBins;
+            double fftCost = 2.5 * fftSize_[i] * log2(fftSize_[i]);
+            if((hopSize_ < windowSizeSamps_[i]) && (slideCost < goertzelCost)
+                    && (slideCost < fftCost))
+                methods_[i] = SLIDE;
+            else if(fftCost < goertzelCost)
+                methods_[i] = FFT;
+        }
+
+        if(autotune_)
+            autotune(input);
+
+        configureMethods(input);
+
+        return 1;
+    }
+
+    void SlidingPowerSpectrum::configureMethods(const TrackBank &input)
+    {
+        oscOffset_.assign(nWindows_ + 1, 0);
+        binOffset_.assign(nWindows_ + 1, 0);
+        int maxOscillators = 0, largestWindowSize = 0, largestFFTSize = 0;
+        for(int i=0; i<nWindows_; i++)
+        {
+            int nBins = bandBinIndices_[i][1] - bandBinIndices_[i][0] + 1;
+            int nOscillators = methods_[i] == SLIDE ? 3 * nBins : nBins;
+            binOffset_[i + 1] = binOffset_[i] + nBins;
+            oscOffset_[i + 1] = oscOffset_[i] + nOscillators;
+            maxOscillators = std::max(maxOscillators, nOscillators);
+            largestWindowSize = std::max(largestWindowSize, windowSizeSamps_[i]);
+            if(methods_[i] == FFT)
+                largestFFTSize = std::max(largestFFTSize, fftSize_[i]);
+            LOUDNESS_DEBUG(name_ << ": Window of size " << windowSizeSamps_[i]
+                    << " uses method " << methods_[i]
+                    << " over " << nBins << " bins.");
+        }
+
+        //oscillator frequencies and phasors
+        int nOscillators = oscOffset_[nWindows_];
+        coef_.resize(nOscillators);
+        phaseRe_.resize(nOscillators);
+        phaseIm_.resize(nOscillators);
+        rotRe_.resize(nOscillators);
+        rotIm_.resize(nOscillators);
+        tailRe_.resize(nOscillators);
+        tailIm_.resize(nOscillators);
+        endRe_.resize(nOscillators);
+        endIm_.resize(nOscillators);
+        hannCentre_.resize(nWindows_);
+        hannRe_.resize(nWindows_);
+        hannIm_.resize(nWindows_);
+        for(int i=0; i<nWindows_; i++)
+        {
+            int windowSize = windowSizeSamps_[i];
+            int nBins = binOffset_[i + 1] - binOffset_[i];
+            double theta = 2 * PI / windowSize;
+            int nSums = methods_[i] == SLIDE ? 3 : 1;
+            for(int k=0; k<nSums; k++)
+            {
+                //centre, lower and upper sums (see class description)
+                double shift = k == 0 ? 0.0 : (k == 1 ? -theta : theta);
+                for(int b=0; b<nBins; b++)
+                {
+                    int o = oscOffset_[i] + k * nBins + b;
+                    double w = 2 * PI * (bandBinIndices_[i][0] + b) / fftSize_[i] + shift;
+                    coef_[o] = 2 * cos(w);
+                    phaseRe_[o] = cos(w);
+                    phaseIm_[o] = sin(w);
+                    rotRe_[o] = cos(w * hopSize_);
+                    rotIm_[o] = sin(w * hopSize_);
+                    tailRe_[o] = cos(w * (windowSize - 1));
+                    tailIm_[o] = -sin(w * (windowSize - 1));
+                    endRe_[o] = cos(w * windowSize);
+                    endIm_[o] = -sin(w * windowSize);
+                }
+            }
+
+            //same scaling as PowerSpectrum::hannWindow
+            double norm = sqrt(2.0 / (fftSize_[i] * windowSize * 0.375 * 2e-5 * 2e-5));
+            double centre = 0.5 * (windowSize - 1);
+            hannCentre_[i] = 0.5 * norm;
+            hannRe_[i] = 0.25 * norm * cos(theta * centre);
+            hannIm_[i] = -0.25 * norm * sin(theta * centre);
+        }
+
+        //state per track, scratch per worker
+        int nTracks = input.getNTracks();
+        stateRe_.assign(nTracks, vector<double>(nOscillators, 0.0));
+        stateIm_.assign(nTracks, vector<double>(nOscillators, 0.0));
+        outgoing_.assign(nTracks, RealVec(nWindows_ * hopSize_, 0.0));
+        scratch_.assign(getNWorkers(),
+                vector<double>(4 * maxOscillators + largestWindowSize, 0.0));
+        nFramesSinceAnchor_ = -1;
+
+        //FFT buffers per worker, plans shared through FFTWPlanCache
+        destroyTransformBuffers();
+        transformPlans_.assign(nWindows_, FFTWPlan());
+        if(largestFFTSize > 0)
+        {
+            for(int w=0; w<getNWorkers(); w++)
+            {
+                transformInputBufs_.push_back((Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * largestFFTSize));
+                transformOutputBufs_.push_back((Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * largestFFTSize));
+                for(int j=0; j<largestFFTSize; j++)
+                    transformInputBufs_[w][j] = 0.0;
+            }
+            for(int i=0; i<nWindows_; i++)
+            {
+                if(methods_[i] == FFT)
+                    transformPlans_[i] = FFTWPlanCache::getR2RPlan(fftSize_[i], 1,
+                            fftSize_[i], FFTW_R2HC,
+                            transformInputBufs_[0], transformOutputBufs_[0]);
+            }
+        }
+    }
+
+    void SlidingPowerSpectrum::autotune(const TrackBank &input)
+    {
+        //noise frames shaped like the input
+        TrackBank trial;
+        trial.initialize(input);
+        unsigned int seed = 1;
+        for(int track=0; track<trial.getNTracks(); track++)
+        {
+            Real *x = trial.getSignalWritePointer(track, 0);
+            for(int j=0; j<trial.getNSamples(); j++)
+            {
+                seed = seed * 1103515245u + 12345u;
+                x[j] = ((seed >> 8) & 0xffff) / 65536.0 - 0.5;
+            }
+        }
+
+        /*
+         * Run every window with each method in turn, timing each window
+         * over all tracks after two warm-up frames (the first anchors).
+         */
+        const int nTrialFrames = 8;
+        const Method candidates[3] = {SLIDE, GOERTZEL, FFT};
+        vector<vector<double> > times(nWindows_, vector<double>(3, -1.0));
+        windowTimers_.assign(getNWorkers(), Timer("WALL"));
+        for(int m=0; m<3; m++)
+        {
+            for(int i=0; i<nWindows_; i++)
+            {
+                methods_[i] = candidates[m];
+                if((candidates[m] == SLIDE) && (hopSize_ >= windowSizeSamps_[i]))
+                    methods_[i] = GOERTZEL;
+            }
+            configureMethods(input);
+            for(int f=0; f<2; f++)
+                processInternal(trial);
+
+            windowTimes_.assign(getNWorkers(), vector<double>(nWindows_, 0.0));
+            timeWindows_ = true;
+            for(int f=0; f<nTrialFrames; f++)
+                processInternal(trial);
+            timeWindows_ = false;
+
+            for(int i=0; i<nWindows_; i++)
+            {
+                if(methods_[i] != candidates[m])
+                    continue;
+                times[i][m] = 0.0;
+                for(int w=0; w<getNWorkers(); w++)
+                    times[i][m] += windowTimes_[w][i];
+            }
+        }
+
+        for(int i=0; i<nWindows_; i++)
+        {
+            int fastest = 1;
+            for(int m=0; m<3; m++)
+            {
+                if((times[i][m] >= 0.0) && (times[i][m] < times[i][fastest]))
+                    fastest = m;
+            }
+            methods_[i] = candidates[fastest];
+            LOUDNESS_DEBUG(name_ << ": Autotuned window of size " << windowSizeSamps_[i]
+                    << ": slide " << times[i][0] << " s, goertzel " << times[i][1]
+                    << " s, FFT " << times[i][2] << " s.");
+        }
+
+        //discard the trial spectra
+        const int outStride = output_.getChannelStride();
+        for(int track=0; track<output_.getNTracks(); track++)
+        {
+            Real *out = output_.getTrackWritePointer(track);
+            for(int c=0; c<output_.getNChannels(); c++)
+                out[outStride * c] = 0.0;
+        }
+    }
+
+    void SlidingPowerSpectrum::lapWindowTimer(int worker, int window)
+    {
+        Timer &timer = windowTimers_[worker];
+        if(window > 0)
+        {
+            timer.toc();
+            windowTimes_[worker][window - 1] += timer.getElapsedTime();
+        }
+        timer.tic();
+    }
+
+    void SlidingPowerSpectrum::processInternal(const TrackBank &input)
+    {
+        const int outStride = output_.getChannelStride();
+        const int hop = hopSize_;
+        const bool anchor = (nFramesSinceAnchor_ < 0) ||
+            (anchorInterval_ > 0 && nFramesSinceAnchor_ >= anchorInterval_);
+
+        processTracks(input.getNTracks(), [&](int track, int worker)
+        {
+            const Real *inputSignal = input.getSignalReadPointer(track, 0);
+            Real *outgoing = &outgoing_[track][0];
+            Real *outputSignal = output_.getTrackWritePointer(track);
+            double *sRe = &stateRe_[track][0];
+            double *sIm = &stateIm_[track][0];
+
+            for(int i=0; i<nWindows_; i++)
+            {
+                if(timeWindows_)
+                    lapWindowTimer(worker, i);
+
+                const int windowSize = windowSizeSamps_[i];
+                const int first = oscOffset_[i];
+                const int n = oscOffset_[i + 1] - first;
+                const double *coef = &coef_[first];
+                double *a1 = &scratch_[worker][0];
+                double *a2 = a1 + n;
+                double *b1 = a2 + n;
+                double *b2 = b1 + n;
+                double *x = b2 + n;
+                for(int o=0; o<4*n; o++)
+                    a1[o] = 0.0;
+
+                const Real *segment = inputSignal + windowDelay_[i];
+                Real *out = outputSignal + outStride * binOffset_[i];
+
+                //FFT of the windowed segment
+                if(methods_[i] == FFT)
+                {
+                    Real *fftIn = transformInputBufs_[worker];
+                    Real *fftOut = transformOutputBufs_[worker];
+                    const Real *w = &windows_[i][0];
+                    for(int j=0; j<windowSize; j++)
+                        fftIn[j] = segment[j] * w[j];
+                    LOUDNESS_FFTW(execute_r2r)(transformPlans_[i], fftIn, fftOut);
+                    for(int j=0; j<windowSize; j++)
+                        fftIn[j] = 0.0;
+
+                    const int fftSize = fftSize_[i];
+                    const int lo = bandBinIndices_[i][0];
+                    for(int b=0; b<n; b++)
+                    {
+                        Real re = fftOut[lo + b];
+                        Real im = fftOut[fftSize - lo - b];
+                        out[outStride * b] = re * re + im * im;
+                    }
+                    continue;
+                }
+
+                //Goertzel over the windowed segment
+                if(methods_[i] == GOERTZEL)
+                {
+                    const Real *w = &windows_[i][0];
+                    for(int j=0; j<windowSize; j++)
+                        x[j] = segment[j] * w[j];
+                    for(int j=0; j<windowSize; j++)
+                    {
+                        double xj = x[j];
+                        for(int o=0; o<n; o++)
+                        {
+                            double s0 = xj + coef[o] * a1[o] - a2[o];
+                            a2[o] = a1[o];
+                            a1[o] = s0;
+                        }
+                    }
+                    for(int o=0; o<n; o++)
+                        out[outStride * o] = a1[o] * a1[o] + a2[o] * a2[o]
+                            - coef[o] * a1[o] * a2[o];
+                    continue;
+                }
+
+                double *re = sRe + first;
+                double *im = sIm + first;
+                const double *tailRe = &tailRe_[first], *tailIm = &tailIm_[first];
+                const double *endRe = &endRe_[first], *endIm = &endIm_[first];
+                if(anchor)
+                {
+                    //sums over the whole segment
+                    for(int j=0; j<windowSize; j++)
+                    {
+                        double xj = segment[j];
+                        for(int o=0; o<n; o++)
+                        {
+                            double s0 = xj + coef[o] * a1[o] - a2[o];
+                            a2[o] = a1[o];
+                            a1[o] = s0;
+                        }
+                    }
+                    for(int o=0; o<n; o++)
+                    {
+                        re[o] = tailRe[o] * a1[o] - endRe[o] * a2[o];
+                        im[o] = tailIm[o] * a1[o] - endIm[o] * a2[o];
+                    }
+                }
+                else
+                {
+                    //samples leaving (a) and entering (b) the segment
+                    const Real *xOld = outgoing + hop * i;
+                    const Real *xNew = segment + windowSize - hop;
+                    for(int j=0; j<hop; j++)
+                    {
+                        double xo = xOld[j], xn = xNew[j];
+                        for(int o=0; o<n; o++)
+                        {
+                            double s0 = xo + coef[o] * a1[o] - a2[o];
+                            a2[o] = a1[o];
+                            a1[o] = s0;
+                            s0 = xn + coef[o] * b1[o] - b2[o];
+                            b2[o] = b1[o];
+                            b1[o] = s0;
+                        }
+                    }
+
+                    //S' = exp(jwh) S - (exp(jw) a1 - a2) + exp(-jw(W-1)) b1 - exp(-jwW) b2
+                    const double *rotRe = &rotRe_[first], *rotIm = &rotIm_[first];
+                    const double *phaseRe = &phaseRe_[first], *phaseIm = &phaseIm_[first];
+                    for(int o=0; o<n; o++)
+                    {
+                        double r = rotRe[o] * re[o] - rotIm[o] * im[o]
+                            - phaseRe[o] * a1[o] + a2[o]
+                            + tailRe[o] * b1[o] - endRe[o] * b2[o];
+                        double m = rotRe[o] * im[o] + rotIm[o] * re[o]
+                            - phaseIm[o] * a1[o]
+                            + tailIm[o] * b1[o] - endIm[o] * b2[o];
+                        re[o] = r;
+                        im[o] = m;
+                    }
+                }
+
+                //Hann window applied in the frequency domain
+                const int nBins = n / 3;
+                const double c = hannCentre_[i], hRe = hannRe_[i], hIm = hannIm_[i];
+                for(int b=0; b<nBins; b++)
+                {
+                    int lo = b + nBins, hi = b + 2 * nBins;
+                    double xRe = c * re[b] + hRe * (re[lo] + re[hi]) - hIm * (im[lo] - im[hi]);
+                    double xIm = c * im[b] + hRe * (im[lo] + im[hi]) + hIm * (re[lo] - re[hi]);
+                    out[outStride * b] = xRe * xRe + xIm * xIm;
+                }
+            }
+
+            if(timeWindows_)
+                lapWindowTimer(worker, nWindows_);
+
+            //keep only the samples leaving the sliding windows next time
+            for(int i=0; i<nWindows_; i++)
+            {
+                if(methods_[i] != SLIDE)
+                    continue;
+                const Real *leaving = inputSignal + windowDelay_[i];
+                Real *kept = outgoing + hop * i;
+                for(int j=0; j<hop; j++)
+                    kept[j] = leaving[j];
+            }
+        });
+
+        nFramesSinceAnchor_ = anchor ? 1 : nFramesSinceAnchor_ + 1;
+    }
+
+    bool SlidingPowerSpectrum::isStateless() const
+    {
+        return 0;
+    }
+
+    void SlidingPowerSpectrum::resetInternal()
+    {
+        PowerSpectrum::resetInternal();
+        nFramesSinceAnchor_ = -1;
+    }
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SLIDINGPOWERSPECTRUM_H
+#define SLIDINGPOWERSPECTRUM_H
+
+#include "PowerSpectrum.h"
+#include "../Support/Timer.h"
+
+namespace loudness{
+
+    /**
+     * @class SlidingPowerSpectrum
+     *
+     * @brief Computes the same multi-resolution power spectrum as
+     * PowerSpectrum by updating only the selected bins from frame to frame.
+     *
+     * Construction, windows, bin selection and the output TrackBank
+     * (channels and centre frequencies) are identical to PowerSpectrum, so
+     * the two modules are interchangeable. Instead of transforming every
+     * window, each output bin is computed directly from its Hann-windowed
+     * DFT:
+     *
+     * X(w) = 0.5 S(w) + 0.25 exp(-j t c) S(w - t) + 0.25 exp(j t c) S(w + t)
+     *
+     * where S is the unwindowed DFT of the segment at a single frequency,
+     * t = 2 pi / windowSize and c = (windowSize - 1) / 2 (scaling omitted).
+     * When the input frames overlap, the three sums per bin are slid along
+     * by the hop size: the samples leaving and entering the window are
+     * accumulated with two Goertzel recursions and the old sums are rotated,
+     * at a cost proportional to the hop size rather than the window size.
+     * The hop size is derived from the frame rate of the input (see
+     * FrameGenerator).
+     *
+     * A window is only slid when that is estimated to be cheaper than
+     * evaluating its bins directly. Otherwise, e.g. for short windows or
+     * non-overlapping frames, either the Goertzel algorithm or, when many
+     * bins are needed, an FFT is applied to the windowed segment each frame.
+     * To bound the drift of the recursive update, slid sums are recomputed
+     * from the current frame every @a anchorInterval frames. The state is
+     * held in double precision regardless of Real.
+     *
+     * The method per window is chosen from an approximate operation count.
+     * In autotune mode (see setAutotune()), the three methods are instead
+     * timed on every window at initialisation, with the actual number of
+     * tracks and worker threads, and the fastest is used. The choice only
+     * affects speed: all methods output the same bins. Uniform or
+     * non-uniform sampling is left to the caller, as it changes the bins.
+     *
+     * The output matches PowerSpectrum to within rounding error. It is
+     * fastest when few bins are output per window, i.e. with non-uniform
+     * spectral sampling.
+     *
+     * @author Dominic Ward
+     *
+     * @sa PowerSpectrum, FrameGenerator
+     */
+    class SlidingPowerSpectrum: public PowerSpectrum
+    {
+    public:
+
+        /**
+         * @brief Constructs a SlidingPowerSpectrum object.
+         *
+         * @param bandFreqsHz A vector of consecutive band edges in Hz.
+         * @param windowSizeSecs A vector of window lengths for each band in ms.
+         * @param uniform true for uniform spectral sampling, false otherwise.
+         * @param anchorInterval Number of frames between recomputations of
+         * the slid sums (0 to never recompute).
+         */
+        SlidingPowerSpectrum(const RealVec& bandFreqsHz,
+                const RealVec& windowSizeSecs,
+                bool uniform,
+                int anchorInterval = 128);
+
+        virtual ~SlidingPowerSpectrum();
+
+        void setAnchorInterval(int anchorInterval);
+
+        int getAnchorInterval() const;
+
+        /**
+         * @brief Set to true to time the methods per window at initialisation
+         * and use the fastest (default is false).
+         */
+        void setAutotune(bool autotune);
+
+        bool getAutotune() const;
+
+        //the sliding sums carry state from frame to frame
+        virtual bool isStateless() const;
+
+    private:
+
+        virtual bool initializeInternal(const TrackBank &input);
+
+        virtual void processInternal(const TrackBank &input);
+
+        virtual void resetInternal();
+
+        void destroyTransformBuffers();
+
+        /*
+         * Sets up the oscillators, state and transforms for the methods in
+         * methods_.
+         */
+        void configureMethods(const TrackBank &input);
+
+        void autotune(const TrackBank &input);
+
+        /*
+         * Adds the time since the last lap to the previous window and
+         * restarts the worker's timer.
+         */
+        void lapWindowTimer(int worker, int window);
+
+        enum Method {SLIDE, GOERTZEL, FFT};
+
+        int anchorInterval_, hopSize_, nFramesSinceAnchor_;
+        bool autotune_, timeWindows_;
+        vector<Timer> windowTimers_;
+        vector<vector<double> > windowTimes_;
+        vector<Method> methods_;
+        vector<int> oscOffset_, binOffset_;
+
+        //per oscillator: 2cos(w), exp(jw), exp(jwh), exp(-jw(W-1)), exp(-jwW)
+        vector<double> coef_, phaseRe_, phaseIm_, rotRe_, rotIm_;
+        vector<double> tailRe_, tailIm_, endRe_, endIm_;
+
+        //per window: Hann weights of the three sums
+        vector<double> hannCentre_, hannRe_, hannIm_;
+
+        vector<vector<double> > stateRe_, stateIm_, scratch_;
+        //per track and window: the hop samples leaving the window next frame
+        RealVecVec outgoing_;
+        vector<Real*> transformInputBufs_, transformOutputBufs_;
+        vector<FFTWPlan> transformPlans_;
+    };
+}
+
+#endif
@@ -19,16 +19,38 @@
 
 #include "SpecificLoudnessGM.h"
 #include "../Support/AuditoryTools.h"
+#include "../Support/SIMDMath.h"
 
 namespace loudness{
 
     SpecificLoudnessGM::SpecificLoudnessGM(bool ansiS3407) :
         Module("SpecificLoudnessGM"),
-        ansiS3407_(ansiS3407)
+        ansiS3407_(ansiS3407),
+        tableTolerance_(0)
     {}
 
     SpecificLoudnessGM::~SpecificLoudnessGM() {}
 
+    void SpecificLoudnessGM::setTableTolerance(Real tableTolerance)
+    {
+        tableTolerance_ = tableTolerance;
+    }
+
+    Real SpecificLoudnessGM::getTableTolerance() const
+    {
+        return tableTolerance_;
+    }
+
+    Real SpecificLoudnessGM::compressiveLoudness(int i, Real excLin) const
+    {
+        //(g*E+A)^alpha - A^alpha without cancellation at low levels
+        Real sl = aAlphaParam_[i] * expm1(alphaParam_[i]
+                * log1p(gParam_[i]*excLin/aParam_[i]));
+        if(excLin <= eThrqParam_[i]) //low level
+            sl *= pow((2*excLin)/(excLin+eThrqParam_[i]), 1.5);
+        return cParam_*sl;
+    }
+
     bool SpecificLoudnessGM::initializeInternal(const TrackBank &input)
     {
         //c value from ANSI 2007
@@ -36,6 +58,11 @@ namespace loudness{
 
         //Number of filters below 500Hz
         nFiltersLT500_ = 0;
+        eThrqParam_.clear();
+        gParam_.clear();
+        aParam_.clear();
+        alphaParam_.clear();
+        aAlphaParam_.clear();
 
         Real eThrqdB500Hz = IntExc(500);
         //fill loudness parameter vectors
@@ -56,6 +83,7 @@ namespace loudness{
                 gParam_.push_back(pow(10, gdB/10.0));
                 aParam_.push_back(GdBToA(gdB));
                 alphaParam_.push_back(GdBToAlpha(gdB));
+                aAlphaParam_.push_back(pow(aParam_[i], alphaParam_[i]));
                 /* 
                 LOUDNESS_DEBUG("SpecificLoudnessGM: eThrq: " <<
                         eThrqParam_[nFiltersLT500_] << ", gdB: " << gdB << ", A: "
@@ -64,9 +92,73 @@ namespace loudness{
                 */
                 nFiltersLT500_++;
             }
+            else //variables are constant >= 500 Hz
+            {
+                eThrqParam_.push_back(2.3604782331805771);
+                gParam_.push_back(1.0);
+                aParam_.push_back(4.72096);
+                alphaParam_.push_back(0.2);
+                aAlphaParam_.push_back(1.3639739128330546);
+            }
         }
         LOUDNESS_DEBUG("SpecificLoudnessGM: number of filters <500 Hz: " << nFiltersLT500_);
 
+        /*
+         * Optional lookup tables in E/eThrq, which puts the change from low
+         * to medium level on a segment boundary. Channels from 500 Hz share a
+         * table. The tables span 2^-40 (about -120 dB re threshold) to the
+         * high level limit of 1e10, and the number of segments per octave
+         * is doubled until the tolerance is met.
+         */
+        table_.clear();
+        if(tableTolerance_ > 0)
+        {
+            int nChannels = input.getNChannels();
+            int nFunctions = nFiltersLT500_ + (nChannels > nFiltersLT500_);
+            tableFunction_.assign(nChannels, 0);
+            tableScale_.assign(nChannels, 0.0);
+            vector<int> channel(nFunctions, 0);
+            Real eThrqMin = eThrqParam_[0];
+            for(int i=0; i<nChannels; i++)
+            {
+                tableFunction_[i] = i < nFiltersLT500_ ? i : nFiltersLT500_;
+                channel[tableFunction_[i]] = i;
+                tableScale_[i] = 1.0 / eThrqParam_[i];
+                eThrqMin = eThrqParam_[i] < eThrqMin ? eThrqParam_[i] : eThrqMin;
+            }
+            int highOctave = (int)floor(log2(1e10 / eThrqMin)) + 1;
+
+            auto function = [&](int k, Real x)
+            {
+                return compressiveLoudness(channel[k], x * eThrqParam_[channel[k]]);
+            };
+
+            Real maxError = 0;
+            for(int n=4; n<=256; n*=2)
+            {
+                if(!table_.initialize(nFunctions, -40, highOctave, n))
+                    break;
+                table_.fill(function);
+                maxError = table_.getMaxError(function);
+                if(maxError <= tableTolerance_)
+                    break;
+                table_.clear();
+            }
+
+            if(table_.isInitialized())
+                LOUDNESS_DEBUG(name_ << ": " << nFunctions << " tables of "
+                        << table_.getSegmentsPerOctave()
+                        << " segments per octave, " << table_.getNBytes() / 1024
+                        << " KiB, maximum relative error " << maxError << ".");
+            else
+                LOUDNESS_WARNING(name_ << ": Tables cannot meet the tolerance of "
+                        << tableTolerance_ << ", evaluating exactly.");
+        }
+
+        //per worker: the power law terms of every channel
+        compressed_.assign(getNWorkers(), RealVec(input.getNChannels(), 0.0));
+        lowLevel_.assign(getNWorkers(), RealVec(input.getNChannels(), 0.0));
+
         //output TrackBank
         output_.initialize(input);
 
@@ -75,52 +167,109 @@ namespace loudness{
 
     void SpecificLoudnessGM::processInternal(const TrackBank &input)
     {
-        Real excLin, sl=0.0;
-        for (track = 0; track < input.getNTracks(); track++)
+        const int inStride = input.getChannelStride();
+        const int outStride = output_.getChannelStride();
+
+        processTracks(input.getNTracks(), [&](int track, int worker)
         {
-            for(int i=0; i<input.getNChannels(); i++)
+            processChannels(input.getTrackReadPointer(track), inStride,
+                    output_.getTrackWritePointer(track), outStride, worker);
+        });
+    }
+
+    void SpecificLoudnessGM::processFused(int, const Real *x, Real *y,
+            int worker)
+    {
+        processChannels(x, 1, y, 1, worker);
+    }
+
+    Module::Fusion SpecificLoudnessGM::getFusion() const
+    {
+        return ELEMENT_WISE;
+    }
+
+    void SpecificLoudnessGM::processChannels(const Real *excitation,
+            int inStride, Real *specificLoudness, int outStride, int worker)
+    {
+        const int nChannels = (int)eThrqParam_.size();
+        Real *compressed = &compressed_[worker][0];
+        Real *lowLevel = &lowLevel_[worker][0];
+
+        if(table_.isInitialized())
+        {
+            const Real *x = excitation;
+            if(inStride != 1)
             {
-                excLin = input.getSample(track, i, 0);
+                for(int i=0; i<nChannels; i++)
+                    compressed[i] = excitation[inStride * i];
+                x = compressed;
+            }
+            //the excitation is still needed below, so never look up in place
+            Real *y = ((outStride == 1) && (specificLoudness != x)) ?
+                specificLoudness : lowLevel;
+            table_.lookup(x, &tableScale_[0], &tableFunction_[0], y,
+                    nChannels);
+
+            for(int i=0; i<nChannels; i++)
+            {
+                Real excLin = x[i];
+                if(y != specificLoudness)
+                    specificLoudness[outStride * i] = y[i];
 
-                //checked out 2.4.14
                 //high level
-                if (excLin > 1e10)
+                if(excLin > 1e10)
                 {
                     if(ansiS3407_)
-                        sl = pow((excLin/1.0707),0.2);
+                        specificLoudness[outStride * i] =
+                            cParam_*pow((excLin/1.0707),0.2);
                     else
-                        sl = pow((excLin/1.04e6),0.5);
-                }
-                else if(i<nFiltersLT500_) //low freqs
-                { 
-                    if(excLin>eThrqParam_[i]) //medium level
-                    {
-                        sl = (pow(gParam_[i]*excLin+aParam_[i], alphaParam_[i])-
-                                pow(aParam_[i],alphaParam_[i]));
-                    }
-                    else //low level
-                    {
-                        sl = pow((2*excLin)/(excLin+eThrqParam_[i]), 1.5)*
-                            (pow(gParam_[i]*excLin+aParam_[i],alphaParam_[i])
-                                -pow(aParam_[i],alphaParam_[i]));
-                    }
+                        specificLoudness[outStride * i] =
+                            cParam_*sqrt(excLin/1.04e6);
                 }
-                else //high freqs (variables are constant >= 500 Hz)
-                { 
-                    if(excLin>2.3604782331805771) //medium level
-                    {
-                        sl = pow(excLin+4.72096, 0.2)-1.3639739128330546;
-                    } 
-                    else //low level
-                    {
-                        sl = pow((2*excLin)/(excLin+2.3604782331805771), 1.5)*
-                            (pow(excLin+4.72096, 0.2)-1.3639739128330546);
-                    }
-                }
-                
-                output_.setSample(track, i, 0, cParam_*sl);
             }
+            return;
         }
+
+        //(g*E+A)^alpha and (2E/(E+eThrq))^1.5 over all channels
+        for(int i=0; i<nChannels; i++)
+        {
+            Real excLin = excitation[inStride * i];
+            compressed[i] = gParam_[i]*excLin+aParam_[i];
+            lowLevel[i] = (2*excLin)/(excLin+eThrqParam_[i]);
+        }
+        PowArray(compressed, &alphaParam_[0], compressed, nChannels);
+        PowArray(lowLevel, 1.5, lowLevel, nChannels);
+
+        Real excLin, sl=0.0;
+        for(int i=0; i<nChannels; i++)
+        {
+            excLin = excitation[inStride * i];
+
+            //checked out 2.4.14
+            //high level
+            if (excLin > 1e10)
+            {
+                if(ansiS3407_)
+                    sl = pow((excLin/1.0707),0.2);
+                else
+                    sl = sqrt(excLin/1.04e6);
+            }
+            else if(excLin>eThrqParam_[i]) //medium level
+            {
+                sl = compressed[i]-aAlphaParam_[i];
+            }
+            else //low level
+            {
+                sl = lowLevel[i]*(compressed[i]-aAlphaParam_[i]);
+            }
+            
+            specificLoudness[outStride * i] = cParam_*sl;
+        }
+    }
+
+    bool SpecificLoudnessGM::isStateless() const
+    {
+        return 1;
     }
 
     void SpecificLoudnessGM::resetInternal(){};
@@ -21,6 +21,7 @@
 #define SPECIFICLOUDNESSGM_H
 
 #include "../Support/Module.h"
+#include "../Support/LogLookupTable.h"
 
 /*
  * =====================================================================================
@@ -59,18 +60,53 @@ namespace loudness{
 
         virtual ~SpecificLoudnessGM();
 
+        /**
+         * @brief Sets the largest relative error of a tabulated mapping from
+         * excitation to specific loudness, or 0 (default) to evaluate the
+         * formulas exactly.
+         *
+         * The tables are built at initialisation with as few segments as
+         * meet the tolerance (see LogLookupTable). Excitations more than
+         * 120 dB below threshold then give 0 and those above the high level
+         * limit are evaluated exactly. If no table meets the tolerance, the
+         * formulas are evaluated exactly.
+         */
+        void setTableTolerance(Real tableTolerance);
+
+        Real getTableTolerance() const;
+
+        virtual Fusion getFusion() const;
+
+        virtual bool isStateless() const;
+
     private:
 
-        virtual bool initializeInternal(const SignalBank &input);
+        virtual bool initializeInternal(const TrackBank &input);
 
-        virtual void processInternal(const SignalBank &input);
+        virtual void processInternal(const TrackBank &input);
 
         virtual void resetInternal();
 
+        virtual void processFused(int track, const Real *x, Real *y,
+                int worker);
+
+        //specific loudness of one track, in place if the arrays are equal
+        void processChannels(const Real *excitation, int inStride,
+                Real *specificLoudness, int outStride, int worker);
+
+        //c * specific loudness below the high level limit, accurate to
+        //rounding at any level
+        Real compressiveLoudness(int i, Real excLin) const;
+
         bool ansiS3407_;
         int nFiltersLT500_;
         Real cParam_;
-        RealVec eThrqParam_, gParam_, aParam_, alphaParam_;
+        RealVec eThrqParam_, gParam_, aParam_, alphaParam_, aAlphaParam_;
+        RealVecVec compressed_, lowLevel_;
+        Real tableTolerance_;
+        LogLookupTable table_;
+        vector<int> tableFunction_;
+        RealVec tableScale_;
     };
 }
 
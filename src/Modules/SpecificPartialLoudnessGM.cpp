@@ -19,9 +19,140 @@
 
 #include "SpecificPartialLoudnessGM.h"
 #include "../Support/AuditoryTools.h"
+#include "../Support/SIMD.h"
+#include "../Support/SIMDMath.h"
 
 namespace loudness{
 
+    //per channel parameters, see SpecificPartialLoudnessGM::initializeInternal
+    struct PartialLoudnessTables
+    {
+        const Real *eThrq, *k, *g, *a, *alpha, *aAlpha, *thrqCompressed;
+    };
+
+    /*
+     * The simd:: functions called by the kernels below are instantiated at
+     * the end of this file, where the ABI warning for them is reported, so
+     * the region is left open to the end of the file.
+     */
+LOUDNESS_SIMD_BEGIN
+    /*
+     * Specific loudness and specific partial loudness of channels
+     * [i, i + Ops::size). All four equations of Glasberg and Moore (1997) are
+     * evaluated and the valid one selected per channel. Eqs. 17 and 19 need
+     * the ratio of the threshold to the signal in mutually exclusive cases,
+     * so one power serves both, as does the power for the loudness at high
+     * levels under ANSI S3.4-2007.
+     */
+    template<class Ops>
+    static LOUDNESS_ALWAYS_INLINE void evaluateChannels(
+            const PartialLoudnessTables &t, const Real *signal,
+            const Real *noise, Real *loudness, Real *partialLoudness, int i,
+            Real c, Real c2, bool ansiS3407)
+    {
+        typedef typename Ops::Vec Vec;
+        typedef typename Ops::Mask Mask;
+        const Vec one = Ops::set1(1.0);
+
+        const Vec eSig = Ops::load(signal + i), eNoise = Ops::load(noise + i);
+        const Vec eThrq = Ops::load(t.eThrq + i), k = Ops::load(t.k + i);
+        const Vec g = Ops::load(t.g + i), a = Ops::load(t.a + i);
+        const Vec alpha = Ops::load(t.alpha + i);
+        const Vec aAlpha = Ops::load(t.aAlpha + i);
+        const Vec thrqCompressed = Ops::load(t.thrqCompressed + i);
+        const Vec vc = Ops::set1(c), vc2 = Ops::set1(c2);
+
+        const Vec sum = Ops::add(eSig, eNoise);
+        const Vec eThrn = Ops::add(Ops::mul(k, eNoise), eThrq);
+        const Vec noiseThr = Ops::add(Ops::mul(Ops::add(one, k), eNoise), eThrq);
+        const Vec sqrtSum = Ops::sqrt(sum);
+        const Vec sqrtNoise = Ops::sqrt(eNoise);
+        const Vec sqrtNoiseThr = Ops::sqrt(noiseThr);
+
+        //(2*eSig/(eSig+eThrq))^1.5
+        const Vec r = Ops::div(Ops::add(eSig, eSig), Ops::add(eSig, eThrq));
+        const Vec lowLevel = Ops::mul(r, Ops::sqrt(r));
+
+        //(eThrq/eSig)^0.3 at high levels, (eThrn/eSig)^0.3 otherwise
+        const Mask high = Ops::gt(sum, Ops::set1(1e10));
+        const Vec ratio = simd::vpow<Ops>(Ops::select(high,
+                    Ops::div(eSig, eThrq), Ops::div(eSig, eThrn)),
+                Ops::set1(-0.3));
+
+        const Vec sumCompressed = simd::vpow<Ops>(
+                Ops::add(Ops::mul(sum, g), a), alpha);
+        const Vec noiseCompressed = simd::vpow<Ops>(
+                Ops::add(Ops::mul(noiseThr, g), a), alpha);
+        const Vec range = Ops::sub(thrqCompressed, aAlpha);
+
+        //equations 17 to 20
+        const Vec pl17 = Ops::sub(Ops::mul(vc, Ops::sub(sumCompressed, aAlpha)),
+                Ops::mul(Ops::mul(vc, Ops::sub(noiseCompressed, thrqCompressed)),
+                    ratio));
+        const Vec pl18 = Ops::mul(Ops::mul(vc, lowLevel),
+                Ops::div(range, Ops::sub(sqrtNoiseThr, sqrtNoise)));
+        const Vec pl19 = Ops::sub(Ops::mul(vc2, sqrtSum),
+                Ops::mul(Ops::mul(vc2, Ops::sub(sqrtNoiseThr, range)), ratio));
+        const Vec pl20 = Ops::mul(pl18, Ops::sub(sqrtSum, sqrtNoise));
+
+        Ops::store(partialLoudness + i, Ops::select(high,
+                    Ops::select(Ops::gt(eThrq, eSig), pl20, pl19),
+                    Ops::select(Ops::gt(eThrn, eSig), pl18, pl17)));
+
+        //specific loudness of the target alone
+        const Mask sigHigh = Ops::gt(eSig, Ops::set1(1e10));
+        Vec base = Ops::add(Ops::mul(g, eSig), a);
+        Vec exponent = alpha;
+        if(ansiS3407)
+        {
+            base = Ops::select(sigHigh, Ops::div(eSig, Ops::set1(1.0707)), base);
+            exponent = Ops::select(sigHigh, Ops::set1(0.2), exponent);
+        }
+        const Vec compressed = simd::vpow<Ops>(base, exponent);
+        const Vec highLevel = ansiS3407 ? compressed :
+            Ops::sqrt(Ops::div(eSig, Ops::set1(1.04e6)));
+        const Vec medium = Ops::sub(compressed, aAlpha);
+        const Vec sl = Ops::select(sigHigh, highLevel,
+                Ops::select(Ops::gt(eSig, eThrq), medium,
+                    Ops::mul(lowLevel, medium)));
+        Ops::store(loudness + i, Ops::mul(vc, sl));
+    }
+
+    template<class Ops>
+    static LOUDNESS_ALWAYS_INLINE void evaluatePartialLoudness(
+            const PartialLoudnessTables &t, const Real *signal,
+            const Real *noise, Real *loudness, Real *partialLoudness,
+            int nChannels, Real c, Real c2, bool ansiS3407)
+    {
+        int i = 0;
+        for(; i + Ops::size <= nChannels; i += Ops::size)
+            evaluateChannels<Ops>(t, signal, noise, loudness,
+                    partialLoudness, i, c, c2, ansiS3407);
+        for(; i < nChannels; i++)
+            evaluateChannels<simd::Scalar<Real> >(t, signal, noise,
+                    loudness, partialLoudness, i, c, c2, ansiS3407);
+    }
+
+    static void evaluatePartialLoudnessDefault(const PartialLoudnessTables &t,
+            const Real *signal, const Real *noise, Real *loudness,
+            Real *partialLoudness, int nChannels, Real c, Real c2,
+            bool ansiS3407)
+    {
+        evaluatePartialLoudness<simd::Baseline<Real> >(t, signal, noise, loudness,
+                partialLoudness, nChannels, c, c2, ansiS3407);
+    }
+
+#if LOUDNESS_X86_DISPATCH
+    LOUDNESS_TARGET_AVX2 static void evaluatePartialLoudnessAVX2(
+            const PartialLoudnessTables &t, const Real *signal,
+            const Real *noise, Real *loudness, Real *partialLoudness,
+            int nChannels, Real c, Real c2, bool ansiS3407)
+    {
+        evaluatePartialLoudness<simd::AVX2<Real> >(t, signal, noise, loudness,
+                partialLoudness, nChannels, c, c2, ansiS3407);
+    }
+#endif
+
     SpecificPartialLoudnessGM::SpecificPartialLoudnessGM(bool ansiS3407) :
         Module("SpecificPartialLoudnessGM"),
         ansiS3407_(ansiS3407)
@@ -43,6 +174,13 @@ namespace loudness{
 
         //Number of filters below 500Hz
         nFiltersLT500_ = 0;
+        eThrqParam_.clear();
+        k_.clear();
+        gParam_.clear();
+        aParam_.clear();
+        alphaParam_.clear();
+        aAlphaParam_.clear();
+        thrqCompressedParam_.clear();
 
         //fill loudness parameter vectors
         Real fcPrev = input.getCentreFreq(0);
@@ -70,11 +208,24 @@ namespace loudness{
             gParam_.push_back(pow(10, gdB/10.0));
             aParam_.push_back(GdBToA(gdB));
             alphaParam_.push_back(GdBToAlpha(gdB));
+
+            //signal independent terms: A^alpha and (eThrq*G+A)^alpha
+            aAlphaParam_.push_back(pow(aParam_[i], alphaParam_[i]));
+            thrqCompressedParam_.push_back(pow(eThrqParam_[i] * gParam_[i]
+                        + aParam_[i], alphaParam_[i]));
         }
         LOUDNESS_DEBUG("SpecificPartialLoudnessGM: number of filters <500 Hz: " << nFiltersLT500_);
 
+        //per worker: contiguous excitations and outputs
+        int nChannels = input.getNChannels();
+        signal_.assign(getNWorkers(), RealVec(nChannels, 0.0));
+        noise_.assign(getNWorkers(), RealVec(nChannels, 0.0));
+        loudness_.assign(getNWorkers(), RealVec(nChannels, 0.0));
+        partialLoudness_.assign(getNWorkers(), RealVec(nChannels, 0.0));
+
         //output TrackBank
-        output_.initialize(input.getNTracks() / 2, input.getNChannels(), input.getNSamples(), input.getFs());
+        //sample 0: specific loudness, sample 1: specific partial loudness
+        output_.initialize(input.getNTracks() / 2, input.getNChannels(), 2, input.getFs());
         output_.setCentreFreqs(input.getCentreFreqs());
 
         return 1;
@@ -82,111 +233,62 @@ namespace loudness{
 
     void SpecificPartialLoudnessGM::processInternal(const TrackBank &input)
     {
-        Real eSig, eNoise, eThrn, sl, slSum, plSum, pl=0.0;
-        int masker, nTracks;
+        int nTracks = input.getNTracks() / 2;
+        const int nChannels = input.getNChannels();
+        const int inStride = input.getChannelStride();
+        const int outStride = output_.getChannelStride();
 
-        nTracks = input.getNTracks() / 2;
+        PartialLoudnessTables tables;
+        tables.eThrq = &eThrqParam_[0];
+        tables.k = &k_[0];
+        tables.g = &gParam_[0];
+        tables.a = &aParam_[0];
+        tables.alpha = &alphaParam_[0];
+        tables.aAlpha = &aAlphaParam_[0];
+        tables.thrqCompressed = &thrqCompressedParam_[0];
 
-        for (int target = 0; target < nTracks; target++)
+        processTracks(nTracks, [&](int target, int worker)
         {
-            slSum = 0;
-            plSum = 0;
-            masker = target + nTracks;
-            for(int freq = 0; freq < input.getNChannels(); freq++)
+            int masker = target + nTracks;
+            const Real *signal = input.getTrackReadPointer(target);
+            const Real *noise = input.getTrackReadPointer(masker);
+            if(inStride != 1)
             {
-                eSig = input.getSample(target, freq, 0);
-                eNoise = input.getSample(masker, freq, 0);
-                eThrn = k_[freq] * eNoise + eThrqParam_[freq];
-
-                // partial loudness calculation (the target signal in noise)
-                if (eSig + eNoise > 1e10)
-                {
-                    if (eSig >= eThrqParam_[freq]) // equation 19 from Glasberg and Moore 1997
-                    {
-                        pl = c2Param_ * pow(eSig + eNoise, 0.5)
-                                - c2Param_ * (pow((1 + k_[freq]) * eNoise + eThrqParam_[freq], 0.5)
-                                                - pow(eThrqParam_[freq] * gParam_[freq] + aParam_[freq], alphaParam_[freq])
-                                                + pow(aParam_[freq], alphaParam_[freq]))
-                                            * pow(eThrqParam_[freq] / eSig, 0.3);
-                    }
-                    else // equation 20 from Glasberg and Moore 1997
-                    {
-                        pl = cParam_
-                            * pow(2 * eSig / (eSig + eThrqParam_[freq]), 1.5)
-                            * ((pow(eThrqParam_[freq] * gParam_[freq] + aParam_[freq], alphaParam_[freq])
-                                    - pow(aParam_[freq], alphaParam_[freq]))
-                                / (pow(eNoise * (1 + k_[freq]) + eThrqParam_[freq], 0.5) - pow(eNoise, 0.5)))
-                            * (pow(eSig + eNoise, 0.5) - pow(eNoise, 0.5));
-                    }
-                }
-                else // eSig + eNoise <= 1e10
+                for(int freq = 0; freq < nChannels; freq++)
                 {
-                    if (eSig >= eThrn) // // equation 17 from Glasberg and Moore 1997
-                    {
-                        pl = cParam_ * (pow((eSig + eNoise) * gParam_[freq] + aParam_[freq], alphaParam_[freq])
-                                        - pow(aParam_[freq], alphaParam_[freq]))
-                            - cParam_
-                                * (pow((eNoise * (1 + k_[freq]) + eThrqParam_[freq]) * gParam_[freq] + aParam_[freq], alphaParam_[freq])
-                                    - pow(eThrqParam_[freq] * gParam_[freq] + aParam_[freq], alphaParam_[freq]))
-                                * pow(eThrn / eSig, 0.3);
-                    }
-                    else // equation 18 from Glasberg and Moore 1997
-                    {
-                        pl = cParam_
-                            * pow(2 * eSig / (eSig + eThrqParam_[freq]), 1.5)
-                            * ((pow(eThrqParam_[freq] * gParam_[freq] + aParam_[freq], alphaParam_[freq])
-                                    - pow(aParam_[freq], alphaParam_[freq]))
-                                / (pow(eNoise * (1 + k_[freq]) + eThrqParam_[freq], 0.5) - pow(eNoise, 0.5)));
-                    }
+                    signal_[worker][freq] = signal[inStride * freq];
+                    noise_[worker][freq] = noise[inStride * freq];
                 }
+                signal = &signal_[worker][0];
+                noise = &noise_[worker][0];
+            }
 
-                // set partial loudness at output channel 1
-                output_.setSample(target, freq, 1, pl);
-                //plSum += pl;
+            Real *loudness = &loudness_[worker][0];
+            Real *partialLoudness = &partialLoudness_[worker][0];
+#if LOUDNESS_X86_DISPATCH
+            if(cpuHasAVX2())
+                evaluatePartialLoudnessAVX2(tables, signal, noise, loudness,
+                        partialLoudness, nChannels, cParam_, c2Param_,
+                        ansiS3407_);
+            else
+#endif
+                evaluatePartialLoudnessDefault(tables, signal, noise, loudness,
+                        partialLoudness, nChannels, cParam_, c2Param_,
+                        ansiS3407_);
 
-                // loudness calculation (the isolated target signal)
-                //high level
-                if (eSig > 1e10)
-                {
-                    if(ansiS3407_)
-                        sl = pow((eSig/1.0707),0.2);
-                    else
-                        sl = pow((eSig/1.04e6),0.5);
-                }
-                else if(freq<nFiltersLT500_) //low freqs
-                { 
-                    if(eSig>eThrqParam_[freq]) //medium level
-                    {
-                        sl = (pow(gParam_[freq]*eSig+aParam_[freq], alphaParam_[freq])-
-                                pow(aParam_[freq],alphaParam_[freq]));
-                    }
-                    else //low level
-                    {
-                        sl = pow((2*eSig)/(eSig+eThrqParam_[freq]), 1.5)*
-                            (pow(gParam_[freq]*eSig+aParam_[freq],alphaParam_[freq])
-                                -pow(aParam_[freq],alphaParam_[freq]));
-                    }
-                }
-                else //high freqs (variables are constant >= 500 Hz)
-                { 
-                    if(eSig>2.3604782331805771) //medium level
-                    {
-                        sl = pow(eSig+4.72096, 0.2)-1.3639739128330546;
-                    }
-                    else //low level
-                    {
-                        sl = pow((2*eSig)/(eSig+2.3604782331805771), 1.5)*
-                            (pow(eSig+4.72096, 0.2)-1.3639739128330546);
-                    }
-                }
-                
-                // set loudness at output channel 0
-                output_.setSample(target, freq, 0, cParam_*sl);
-                //slSum += sl;
+            //sample 0: specific loudness, sample 1: specific partial loudness
+            Real *out = output_.getTrackWritePointer(target);
+            for(int freq = 0; freq < nChannels; freq++)
+            {
+                out[outStride * freq] = loudness[freq];
+                out[outStride * freq + 1] = partialLoudness[freq];
             }
-            //output_.setSample(0, 0, 0, cParam_*slSum);
-            //output_.setSample(0, 0, 1, plSum);
-        }
+        });
+    }
+
+    bool SpecificPartialLoudnessGM::isStateless() const
+    {
+        return 1;
     }
 
     void SpecificPartialLoudnessGM::resetInternal(){};
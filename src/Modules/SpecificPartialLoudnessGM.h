@@ -44,6 +44,10 @@ namespace loudness{
      * Only for use within DynamicPartialLoudnessGM model.
      * Input is a TrackBank of size 2
      *
+     * Terms that depend only on the channel are computed at initialisation.
+     * Each frame evaluates all four partial loudness equations over whole
+     * vectors of channels and selects the valid one per channel.
+     *
      * Models the compressive behaviour of the active cochlea mechanism
      * according to:
      * 
@@ -62,6 +66,8 @@ namespace loudness{
 
         virtual ~SpecificPartialLoudnessGM();
 
+        virtual bool isStateless() const;
+
     private:
 
         virtual bool initializeInternal(const TrackBank &input);
@@ -74,6 +80,8 @@ namespace loudness{
         int nFiltersLT500_;
         Real cParam_, c2Param_;
         RealVec eThrqParam_, eThrnParam_, gParam_, aParam_, alphaParam_, k_;
+        RealVec aAlphaParam_, thrqCompressedParam_;
+        RealVecVec signal_, noise_, loudness_, partialLoudness_;
     };
 }
 
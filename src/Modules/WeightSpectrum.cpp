@@ -64,11 +64,26 @@ namespace loudness{
 
     void WeightSpectrum::processInternal(const TrackBank &input)
     {
-        for (int track = 0; track < input.getNTracks(); track++)
+        const int inStride = input.getChannelStride();
+        const int outStride = output_.getChannelStride();
+        processTracks(input.getNTracks(), [&](int track, int)
         {
+            const Real *x = input.getTrackReadPointer(track);
+            Real *y = output_.getTrackWritePointer(track);
             for(int i=0; i<input.getNChannels(); i++)
-                output_.setSample(track, i, 0, input.getSample(track, i, 0)*weights_[i]);
-        }
+                y[outStride * i] = x[inStride * i] * weights_[i];
+        });
+    }
+
+    void WeightSpectrum::processFused(int, const Real *x, Real *y, int)
+    {
+        for(int i=0; i<(int)weights_.size(); i++)
+            y[i] = x[i] * weights_[i];
+    }
+
+    Module::Fusion WeightSpectrum::getFusion() const
+    {
+        return output_.getNSamples() == 1 ? ELEMENT_WISE : NO_FUSION;
     }
 
     void WeightSpectrum::setWeights(const RealVec &weights)
@@ -76,6 +91,11 @@ namespace loudness{
         weights_ = weights;
     }
 
+    bool WeightSpectrum::isStateless() const
+    {
+        return 1;
+    }
+
     void WeightSpectrum::resetInternal(){};
 }
 
@@ -66,6 +66,10 @@ namespace loudness{
          */
         void setWeights(const RealVec &weights);
 
+        virtual Fusion getFusion() const;
+
+        virtual bool isStateless() const;
+
     private:
         virtual bool initializeInternal(const TrackBank &input);
 
@@ -73,6 +77,9 @@ namespace loudness{
 
         virtual void resetInternal();
 
+        virtual void processFused(int track, const Real *x, Real *y,
+                int worker);
+
         RealVec weights_;
         OME ome_;
         bool usingOME_;
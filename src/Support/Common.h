@@ -32,6 +32,7 @@
 #define PI 3.14159265358979323846264338327
 #define LOW_LIMIT_POWER 1e-10
 #define LOW_LIMIT_DB -100
+#define LOUDNESS_ALIGNMENT 64
 
 /*
  * Expose objects
@@ -44,8 +45,15 @@ namespace loudness{
 
 /*
  * Types
+ *
+ * Define LOUDNESS_SINGLE_PRECISION (make SINGLE=1) to build the library with
+ * single-precision samples and FFTs.
  */
+#ifdef LOUDNESS_SINGLE_PRECISION
+typedef float Real;
+#else
 typedef double Real;
+#endif
 typedef std::vector<bool> BoolVec;
 typedef std::vector<Real> RealVec;
 typedef std::vector<std::vector<Real> > RealVecVec;
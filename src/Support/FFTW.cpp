@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "FFTW.h"
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace loudness{
+
+    namespace{
+
+        //size, howMany, dist, kind, rigor, input alignment, output alignment, in-place
+        typedef std::tuple<int, int, int, int, unsigned int, int, int, bool> PlanKey;
+
+        struct PlanCacheState
+        {
+            std::mutex mutex;
+            std::map<PlanKey, FFTWPlan> plans;
+            unsigned int rigor = FFTW_PATIENT;
+            string wisdomFile;
+        };
+
+        PlanCacheState& state()
+        {
+            static PlanCacheState cacheState;
+            return cacheState;
+        }
+
+        /*
+         * Exports to a temporary file renamed over path, so that readers and
+         * crashes never see a partially written file.
+         */
+        bool writeWisdom(const string &path)
+        {
+            string tmpPath = path + ".tmp";
+            if(!LOUDNESS_FFTW(export_wisdom_to_filename)(tmpPath.c_str()))
+                return 0;
+            if(std::rename(tmpPath.c_str(), path.c_str()))
+            {
+                std::remove(tmpPath.c_str());
+                return 0;
+            }
+            return 1;
+        }
+    }
+
+    FFTWPlan FFTWPlanCache::getR2RPlan(int fftSize, int howMany, int dist,
+            LOUDNESS_FFTW(r2r_kind) kind, const Real *in, const Real *out)
+    {
+        PlanCacheState &cache = state();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+
+        int inAlignment = LOUDNESS_FFTW(alignment_of)((Real*)in);
+        int outAlignment = LOUDNESS_FFTW(alignment_of)((Real*)out);
+        PlanKey key(fftSize, howMany, dist, kind, cache.rigor,
+                inAlignment, outAlignment, in == out);
+
+        std::map<PlanKey, FFTWPlan>::iterator it = cache.plans.find(key);
+        if(it != cache.plans.end())
+            return it->second;
+
+        /*
+         * Plan on scratch arrays with the same alignment as the caller's, so
+         * measuring planners do not overwrite their contents.
+         */
+        int size = (howMany - 1) * dist + fftSize;
+        int pad = LOUDNESS_ALIGNMENT / sizeof(Real);
+        Real *scratchIn = (Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * (size + pad));
+        Real *scratchOut = scratchIn;
+        if(in != out)
+            scratchOut = (Real*) LOUDNESS_FFTW(malloc)(sizeof(Real) * (size + pad));
+
+        FFTWPlan plan = LOUDNESS_FFTW(plan_many_r2r)(1, &fftSize, howMany,
+                scratchIn + inAlignment / sizeof(Real), NULL, 1, dist,
+                scratchOut + outAlignment / sizeof(Real), NULL, 1, dist,
+                &kind, cache.rigor);
+
+        if(scratchOut != scratchIn)
+            LOUDNESS_FFTW(free)(scratchOut);
+        LOUDNESS_FFTW(free)(scratchIn);
+
+        cache.plans[key] = plan;
+        LOUDNESS_DEBUG("FFTWPlanCache: Created plan for "
+                << howMany << " x " << fftSize << "-point transforms.");
+
+        if(!cache.wisdomFile.empty())
+        {
+            if(!writeWisdom(cache.wisdomFile))
+                LOUDNESS_WARNING("FFTWPlanCache: Could not write wisdom to "
+                        << cache.wisdomFile);
+        }
+
+        return plan;
+    }
+
+    void FFTWPlanCache::setPlannerRigor(unsigned int rigor)
+    {
+        PlanCacheState &cache = state();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.rigor = rigor;
+    }
+
+    unsigned int FFTWPlanCache::getPlannerRigor()
+    {
+        PlanCacheState &cache = state();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return cache.rigor;
+    }
+
+    bool FFTWPlanCache::setWisdomFile(const string &path)
+    {
+        PlanCacheState &cache = state();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.wisdomFile = path;
+        if(path.empty())
+            return 1;
+
+        if(!LOUDNESS_FFTW(import_wisdom_from_filename)(path.c_str()))
+        {
+            LOUDNESS_DEBUG("FFTWPlanCache: No wisdom imported from " << path);
+            return 0;
+        }
+        LOUDNESS_DEBUG("FFTWPlanCache: Wisdom imported from " << path);
+        return 1;
+    }
+
+    string FFTWPlanCache::getWisdomFile()
+    {
+        PlanCacheState &cache = state();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return cache.wisdomFile;
+    }
+
+    bool FFTWPlanCache::exportWisdom(const string &path)
+    {
+        PlanCacheState &cache = state();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        if(!writeWisdom(path))
+        {
+            LOUDNESS_ERROR("FFTWPlanCache: Could not write wisdom to " << path);
+            return 0;
+        }
+        return 1;
+    }
+
+    int FFTWPlanCache::getNPlans()
+    {
+        PlanCacheState &cache = state();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return (int)cache.plans.size();
+    }
+
+    void FFTWPlanCache::clear()
+    {
+        PlanCacheState &cache = state();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        for(std::map<PlanKey, FFTWPlan>::iterator it = cache.plans.begin();
+                it != cache.plans.end(); it++)
+            LOUDNESS_FFTW(destroy_plan)(it->second);
+        cache.plans.clear();
+    }
+}
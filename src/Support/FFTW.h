@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOUDNESS_FFTW_H
+#define LOUDNESS_FFTW_H
+
+#include <fftw3.h>
+#include "Common.h"
+
+/*
+ * FFTW provides a separate API per precision (fftw_ for double, fftwf_ for
+ * float). LOUDNESS_FFTW(name) selects the one matching Real, e.g.
+ * LOUDNESS_FFTW(execute_r2r)(plan, in, out). fftw_r2r_kind and
+ * fftwf_r2r_kind name the same enum.
+ */
+#ifdef LOUDNESS_SINGLE_PRECISION
+#define LOUDNESS_FFTW(name) fftwf_ ## name
+#else
+#define LOUDNESS_FFTW(name) fftw_ ## name
+#endif
+
+namespace loudness{
+    typedef LOUDNESS_FFTW(plan) FFTWPlan;
+
+    /**
+     * @class FFTWPlanCache
+     *
+     * @brief A process-wide cache of FFTW plans with optional wisdom
+     * persistence.
+     *
+     * Plans are keyed by transform size, batch layout, kind, planner rigor
+     * and the SIMD alignment of the arrays they will be executed on, so
+     * every module instance (and every worker buffer) requesting the same
+     * transform shares a single plan. Plans are created on scratch arrays,
+     * leaving the caller's buffers untouched, and must be executed with the
+     * new-array interface (LOUDNESS_FFTW(execute_r2r)) on arrays of the same
+     * alignment, e.g. obtained from LOUDNESS_FFTW(malloc). Cached plans are
+     * owned by the cache and must not be destroyed by the caller.
+     *
+     * If a wisdom file is set, its wisdom is imported immediately and the
+     * accumulated wisdom is written back whenever a new plan is created, so
+     * that later processes can plan with FFTW_PATIENT (or stronger) almost
+     * instantly. Files are written to <path>.tmp and renamed over <path>, so
+     * they are never seen partially written.
+     *
+     * All functions are thread-safe.
+     *
+     * @author Dominic Ward
+     */
+    class FFTWPlanCache
+    {
+    public:
+
+        /**
+         * @brief Returns a plan computing @a howMany real-to-real transforms
+         * of size @a fftSize, spaced @a dist samples apart, from @a in to
+         * @a out.
+         */
+        static FFTWPlan getR2RPlan(int fftSize, int howMany, int dist,
+                LOUDNESS_FFTW(r2r_kind) kind, const Real *in, const Real *out);
+
+        /**
+         * @brief Sets the planner rigor used for new plans (FFTW_ESTIMATE,
+         * FFTW_MEASURE, FFTW_PATIENT or FFTW_EXHAUSTIVE).
+         *
+         * The default is FFTW_PATIENT.
+         */
+        static void setPlannerRigor(unsigned int rigor);
+
+        static unsigned int getPlannerRigor();
+
+        /**
+         * @brief Sets the file used to persist FFTW wisdom and imports it.
+         *
+         * Returns false if the file could not be imported (e.g. it does not
+         * exist yet); it will still be written when new plans are created.
+         * An empty path disables persistence.
+         */
+        static bool setWisdomFile(const string &path);
+
+        static string getWisdomFile();
+
+        /**
+         * @brief Writes the accumulated wisdom to @a path.
+         */
+        static bool exportWisdom(const string &path);
+
+        /**
+         * @brief Returns the number of cached plans.
+         */
+        static int getNPlans();
+
+        /**
+         * @brief Destroys all cached plans.
+         *
+         * Must only be called when no module uses a plan from the cache.
+         */
+        static void clear();
+    };
+}
+
+#endif
@@ -45,7 +45,7 @@ namespace loudness{
             //load numpy array holding the filter coefficients
             //npy_load will abort if fopen fails
             cnpy::NpyArray arr = cnpy::npy_load(pathToFilterCoefs);
-            Real *data = reinterpret_cast<Real*> (arr.data);
+            RealVec data = cnpy::npy_data_as<Real>(arr);
 
             //check if filter is IIR or FIR
             bool iir = false;
@@ -69,7 +69,7 @@ namespace loudness{
             }
             
             //clean up
-            delete [] data;
+            arr.destruct();
         }
 
         return 1;
@@ -44,7 +44,7 @@ namespace loudness{
             //load numpy array holding the filter coefficients
             //npy_load will abort if fopen fails
             cnpy::NpyArray arr = cnpy::npy_load(pathToFilterCoefs);
-            Real *data = reinterpret_cast<Real*> (arr.data);
+            vector<double> data = cnpy::npy_data_as<double>(arr);
 
             //check if FilterBank is IIR or FIR
             bool iir = false;
@@ -68,7 +68,7 @@ namespace loudness{
             }
             
             //clean up
-            delete [] data;
+            arr.destruct();
         }
 
         return 1;
@@ -80,12 +80,12 @@ namespace loudness{
         z_.resize(nTracks);
     }
 
-    void FilterBank::setBCoefs(const RealVec &bCoefs)
+    void FilterBank::setBCoefs(const vector<double> &bCoefs)
     {
         bCoefs_ = bCoefs;
     }
 
-    void FilterBank::setACoefs(const RealVec &aCoefs)
+    void FilterBank::setACoefs(const vector<double> &aCoefs)
     {
         aCoefs_ = aCoefs;
     }
@@ -114,7 +114,7 @@ namespace loudness{
     {
         //zero delay line
         for (int track = 0; track < nTracks_; track++)
-            z_[track].assign(z_.size(),0.0);
+            z_[track].assign(z_[track].size(),0.0);
     }
 
     Real FilterBank::getGain() const
@@ -75,12 +75,12 @@ namespace loudness{
         /**
          * @brief Sets the feedforward coefficients.
          */
-        void setBCoefs(const RealVec &bCoefs);
+        void setBCoefs(const vector<double> &bCoefs);
 
         /**
          * @brief Sets the feedback coefficients.
          */
-        void setACoefs(const RealVec &aCoefs);
+        void setACoefs(const vector<double> &aCoefs);
 
         /**
          * @brief Normalises the FilterBank coefficients by the first feedback
@@ -114,8 +114,10 @@ namespace loudness{
     protected:
         Real gain_;
         int order_, orderMinus1_, nTracks_;
-        RealVec bCoefs_, aCoefs_;
-        RealVecVec z_;
+        //Coefficients and delay lines are always double precision: high order
+        //direct form filters are unstable when Real is float.
+        vector<double> bCoefs_, aCoefs_;
+        vector<vector<double> > z_;
     };
 }
 
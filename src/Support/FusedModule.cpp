@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "FusedModule.h"
+
+namespace loudness{
+
+    FusedModule::FusedModule(const vector<Module*> &stages) :
+        Module("FusedModule"),
+        stages_(stages),
+        requested_(stages.size(), 0)
+    {
+        for(unsigned int s=0; s<stages_.size(); s++)
+            name_ += (s ? "+" : ": ") + stages_[s]->getName();
+    }
+
+    FusedModule::~FusedModule() {}
+
+    bool FusedModule::canFuse(const vector<Module*> &stages, int nChannels)
+    {
+        if(stages.size() < 2)
+            return 0;
+        for(unsigned int s=0; s<stages.size(); s++)
+        {
+            Module::Fusion fusion = stages[s]->getFusion();
+            if(!stages[s]->isInitialized() || (fusion == NO_FUSION))
+                return 0;
+            if(fusion == ELEMENT_WISE)
+            {
+                const TrackBank *output = stages[s]->getOutput();
+                if((output->getNChannels() != nChannels) ||
+                        (output->getNSamples() != 1))
+                    return 0;
+            }
+            else if(s + 1 < stages.size())
+                return 0;
+        }
+        return 1;
+    }
+
+    bool FusedModule::initializeInternal(const TrackBank &input)
+    {
+        if((input.getNSamples() != 1) ||
+                !canFuse(stages_, input.getNChannels()))
+        {
+            LOUDNESS_ERROR(name_ << ": Modules cannot be fused.");
+            return 0;
+        }
+
+        //the last stage hands on its output through this module
+        stages_.back()->removeTargetModule();
+        //element-wise outputs are written on request, reductions always
+        if(stages_.back()->getFusion() == ELEMENT_WISE)
+            requested_.back() = 1;
+        x_.assign(getNWorkers(), RealVec(input.getNChannels()));
+
+        return 1;
+    }
+
+    void FusedModule::process(const TrackBank &input)
+    {
+        if(initialized_ && input.getAndTrigs())
+        {
+#ifdef LOUDNESS_PROFILE
+            startProfile();
+            processInternal(input);
+            stopProfile();
+#else
+            processInternal(input);
+#endif
+            if(targetModule_)
+                targetModule_->process(stages_.back()->output_);
+        }
+    }
+
+    void FusedModule::processInternal(const TrackBank &input)
+    {
+        const int nChannels = input.getNChannels();
+        const int nStages = (int)stages_.size();
+        const int inStride = input.getChannelStride();
+
+        processTracks(input.getNTracks(), [&](int track, int worker)
+        {
+            //the first stage reads the input, the others transform y in place
+            Real *y = &x_[worker][0];
+            const Real *x = input.getTrackReadPointer(track);
+            if(inStride != 1)
+            {
+                for(int i=0; i<nChannels; i++)
+                    y[i] = x[inStride * i];
+                x = y;
+            }
+
+            for(int s=0; s<nStages; s++)
+            {
+                stages_[s]->processFused(track, x, y, worker);
+                x = y;
+
+                if(requested_[s])
+                {
+                    TrackBank &output = stages_[s]->output_;
+                    const int outStride = output.getChannelStride();
+                    Real *out = output.getTrackWritePointer(track);
+                    for(int i=0; i<nChannels; i++)
+                        out[outStride * i] = y[i];
+                }
+            }
+        });
+    }
+
+    bool FusedModule::requestOutput(const Module *stage)
+    {
+        for(unsigned int s=0; s<stages_.size(); s++)
+        {
+            if(stages_[s] == stage)
+            {
+                if(stage->getFusion() == ELEMENT_WISE)
+                    requested_[s] = 1;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    bool FusedModule::isOutputWritten(const Module *stage) const
+    {
+        for(unsigned int s=0; s<stages_.size(); s++)
+        {
+            if(stages_[s] == stage)
+                return requested_[s] || (stage->getFusion() != ELEMENT_WISE);
+        }
+        return 1;
+    }
+
+    void FusedModule::resetInternal()
+    {
+        //cascades through the stages, the last of which has no target
+        stages_[0]->reset();
+    }
+}
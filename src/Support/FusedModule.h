@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FUSEDMODULE_H
+#define FUSEDMODULE_H
+
+#include "Module.h"
+
+namespace loudness{
+
+    /**
+     * @class FusedModule
+     *
+     * @brief Runs a chain of initialised ELEMENT_WISE modules, optionally
+     * ending in a REDUCTION module, in a single pass over each track.
+     *
+     * The first stage reads the channels of a track from the input and writes
+     * them to per-worker scratch memory small enough to stay in the L1 cache,
+     * where the following stages transform them in place (see
+     * Module::processFused()) until the reduction writes its output.
+     * The output TrackBanks of the element-wise stages are only written if
+     * requested with requestOutput() before processing, except for the last
+     * stage whose output is passed on to the target module.
+     *
+     * The stages keep their own output TrackBanks, parameters and state, so
+     * their getOutput() remains valid. The target of the last stage is removed
+     * on initialisation; set the target of the FusedModule instead. Resetting
+     * the FusedModule resets every stage.
+     *
+     * @author Dominic Ward
+     *
+     * @sa Model::setFused()
+     */
+    class FusedModule : public Module
+    {
+    public:
+
+        /**
+         * @brief Constructs a fused module from @a stages, which must outlive
+         * it.
+         */
+        FusedModule(const vector<Module*> &stages);
+
+        virtual ~FusedModule();
+
+        /**
+         * @brief Returns true if @a stages are initialised and may be fused
+         * for an input with @a nChannels channels.
+         */
+        static bool canFuse(const vector<Module*> &stages, int nChannels);
+
+        virtual void process(const TrackBank &input);
+
+        /**
+         * @brief Writes the output TrackBank of @a stage as well. Must be
+         * called before processing.
+         *
+         * @return true if @a stage is part of this module, false otherwise.
+         */
+        bool requestOutput(const Module *stage);
+
+        /**
+         * @brief Returns true if the output TrackBank of @a stage is written.
+         */
+        bool isOutputWritten(const Module *stage) const;
+
+    private:
+        virtual bool initializeInternal(const TrackBank &input);
+        virtual void processInternal(const TrackBank &input);
+        virtual void resetInternal();
+
+        vector<Module*> stages_;
+        vector<char> requested_;
+        RealVecVec x_;
+    };
+}
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LevelWeightCache.h"
+#include "SIMD.h"
+
+namespace loudness{
+
+LOUDNESS_SIMD_BEGIN
+    //output += a * w0 + b * w1 over n elements
+    template<class Ops>
+    static LOUDNESS_ALWAYS_INLINE void addSlices(Real a, const Real *w0,
+            Real b, const Real *w1, Real *output, int n)
+    {
+        typedef typename Ops::Vec Vec;
+        const Vec va = Ops::set1(a), vb = Ops::set1(b);
+        int i = 0;
+        for(; i + Ops::size <= n; i += Ops::size)
+        {
+            Vec sum = Ops::add(Ops::mul(va, Ops::load(w0 + i)),
+                    Ops::mul(vb, Ops::load(w1 + i)));
+            Ops::store(output + i, Ops::add(Ops::load(output + i), sum));
+        }
+        for(; i < n; i++)
+            output[i] += a * w0[i] + b * w1[i];
+    }
+
+    template<class Ops>
+    static LOUDNESS_ALWAYS_INLINE void accumulateSlices(const Real *input,
+            const Real *level, Real *output, int nInputs, int nOutputs,
+            int nSlices, Real levelLo, Real resolution, const int *first,
+            const size_t *offset, const Real *weights)
+    {
+        const Real maxPos = nSlices - 1;
+        for(int j=0; j<nInputs; j++)
+        {
+            int n = nOutputs - first[j];
+            if((n <= 0) || (input[j] == 0))
+                continue;
+
+            //slice below the level and the fraction towards the next one
+            Real pos = (level[j] - levelLo) / resolution;
+            pos = pos < 0 ? 0 : (pos > maxPos ? maxPos : pos);
+            int k = (int)pos;
+            k = k > nSlices - 2 ? nSlices - 2 : k;
+            Real frac = pos - k;
+
+            const Real *w0 = weights + offset[j] + k * n;
+            addSlices<Ops>(input[j] * (1 - frac), w0, input[j] * frac,
+                    w0 + n, output + first[j], n);
+        }
+    }
+
+    static void accumulateSlicesDefault(const Real *input, const Real *level,
+            Real *output, int nInputs, int nOutputs, int nSlices,
+            Real levelLo, Real resolution, const int *first,
+            const size_t *offset, const Real *weights)
+    {
+        accumulateSlices<simd::Baseline<Real> >(input, level, output,
+                nInputs, nOutputs, nSlices, levelLo, resolution, first,
+                offset, weights);
+    }
+
+#if LOUDNESS_X86_DISPATCH
+    LOUDNESS_TARGET_AVX2 static void accumulateSlicesAVX2(const Real *input,
+            const Real *level, Real *output, int nInputs, int nOutputs,
+            int nSlices, Real levelLo, Real resolution, const int *first,
+            const size_t *offset, const Real *weights)
+    {
+        accumulateSlices<simd::AVX2<Real> >(input, level, output,
+                nInputs, nOutputs, nSlices, levelLo, resolution, first,
+                offset, weights);
+    }
+#endif
+LOUDNESS_SIMD_END
+
+    LevelWeightCache::LevelWeightCache() :
+        nOutputs_(0),
+        nSlices_(0),
+        levelLo_(0),
+        resolution_(0)
+    {}
+
+    bool LevelWeightCache::initialize(const vector<int> &firstOutput,
+            int nOutputs, Real levelLo, Real levelHi, Real resolution,
+            size_t maxBytes)
+    {
+        clear();
+        if((resolution <= 0) || (levelHi < levelLo) || (nOutputs < 1))
+        {
+            LOUDNESS_ERROR("LevelWeightCache: Invalid level range or resolution.");
+            return 0;
+        }
+
+        //at least two slices to interpolate between
+        int nSlices = (int)ceil((levelHi - levelLo) / resolution) + 1;
+        nSlices = nSlices < 2 ? 2 : nSlices;
+
+        vector<size_t> offset(firstOutput.size(), 0);
+        size_t size = 0;
+        for(unsigned int j=0; j<firstOutput.size(); j++)
+        {
+            offset[j] = size;
+            if(firstOutput[j] < nOutputs)
+                size += (size_t)nSlices * (nOutputs - firstOutput[j]);
+        }
+
+        if(size * sizeof(Real) > maxBytes)
+        {
+            LOUDNESS_WARNING("LevelWeightCache: "
+                    << size * sizeof(Real) / (1 << 20)
+                    << " MiB required, more than the limit of "
+                    << maxBytes / (1 << 20) << " MiB.");
+            return 0;
+        }
+
+        nOutputs_ = nOutputs;
+        nSlices_ = nSlices;
+        levelLo_ = levelLo;
+        resolution_ = resolution;
+        first_ = firstOutput;
+        offset_ = offset;
+        weights_.assign(size, 0.0);
+
+        LOUDNESS_DEBUG("LevelWeightCache: " << nSlices_ << " slices, "
+                << getNBytes() / 1024 << " KiB.");
+
+        return 1;
+    }
+
+    void LevelWeightCache::clear()
+    {
+        nOutputs_ = nSlices_ = 0;
+        first_.clear();
+        offset_.clear();
+        RealVec().swap(weights_);
+    }
+
+    void LevelWeightCache::accumulate(const Real *input, const Real *level,
+            Real *output) const
+    {
+        if(!isInitialized())
+            return;
+
+#if LOUDNESS_X86_DISPATCH
+        if(cpuHasAVX2())
+            accumulateSlicesAVX2(input, level, output, first_.size(),
+                    nOutputs_, nSlices_, levelLo_, resolution_, &first_[0],
+                    &offset_[0], &weights_[0]);
+        else
+#endif
+            accumulateSlicesDefault(input, level, output, first_.size(),
+                    nOutputs_, nSlices_, levelLo_, resolution_, &first_[0],
+                    &offset_[0], &weights_[0]);
+    }
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LEVELWEIGHTCACHE_H
+#define LEVELWEIGHTCACHE_H
+
+#include "Common.h"
+
+namespace loudness{
+
+    /**
+     * @class LevelWeightCache
+     *
+     * @brief Precomputed level dependent filter weights, indexed by
+     * input channel, quantised level and output channel.
+     *
+     * Input channel j contributes to the output channels [first_j, nOutputs)
+     * with weights that depend on a level associated with j, such as the
+     * lower skirts of level dependent roex filters. The weights are stored
+     * for levels spaced by the resolution between a lowest and highest level.
+     * Levels outside this range are clamped to it, so it should cover every
+     * level at which the weights still change.
+     *
+     * accumulate() interpolates linearly between the two slices either side
+     * of each input level, then adds the weighted input to the outputs. For
+     * each input channel this reads two contiguous rows, so there is no
+     * transcendental math per frame. The row pairs are processed with AVX2
+     * when the processor supports it.
+     *
+     * @author Dominic Ward
+     *
+     * @sa FastRoexBank, RoexBankANSIS3407
+     */
+    class LevelWeightCache
+    {
+    public:
+
+        LevelWeightCache();
+
+        /**
+         * @brief Allocates the cache.
+         *
+         * @param firstOutput First output channel of each input channel.
+         * @param nOutputs Number of output channels.
+         * @param levelLo Lowest level.
+         * @param levelHi Highest level.
+         * @param resolution Level spacing of the stored weights.
+         * @param maxBytes Largest cache to allocate (default 256 MiB).
+         *
+         * @return true on success, false if the parameters are invalid or
+         * the cache would need more than @a maxBytes. The cache is then
+         * left empty.
+         */
+        bool initialize(const vector<int> &firstOutput, int nOutputs,
+                Real levelLo, Real levelHi, Real resolution,
+                size_t maxBytes = 256 << 20);
+
+        /**
+         * @brief Fills the cache with weight(input, output, level) for every
+         * input channel, its outputs and every level slice.
+         */
+        template<class Weight>
+        void fill(Weight weight)
+        {
+            for(int j=0; j<(int)first_.size(); j++)
+            {
+                int n = nOutputs_ - first_[j];
+                if(n <= 0)
+                    continue;
+                Real *w = &weights_[0] + offset_[j];
+                for(int k=0; k<nSlices_; k++)
+                    for(int i=0; i<n; i++)
+                        *w++ = weight(j, first_[j] + i, getLevel(k));
+            }
+        }
+
+        /**
+         * @brief Frees the cache.
+         */
+        void clear();
+
+        /**
+         * @brief Adds the contributions of all input channels to @a output.
+         *
+         * @param input One value per input channel, e.g. power.
+         * @param level One level per input channel.
+         * @param output One value per output channel.
+         */
+        void accumulate(const Real *input, const Real *level,
+                Real *output) const;
+
+        /**
+         * @brief Returns the level of slice @a k.
+         */
+        inline Real getLevel(int k) const
+        {
+            return levelLo_ + k * resolution_;
+        }
+
+        inline int getNSlices() const
+        {
+            return nSlices_;
+        }
+
+        /**
+         * @brief Returns the number of bytes used by the weights.
+         */
+        inline size_t getNBytes() const
+        {
+            return weights_.size() * sizeof(Real);
+        }
+
+        inline bool isInitialized() const
+        {
+            return nSlices_ > 0;
+        }
+
+    private:
+
+        int nOutputs_, nSlices_;
+        Real levelLo_, resolution_;
+        vector<int> first_;
+        vector<size_t> offset_;
+        RealVec weights_;
+    };
+}
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LogLookupTable.h"
+#include "SIMD.h"
+#include <limits>
+
+namespace loudness{
+
+LOUDNESS_SIMD_BEGIN
+    /*
+     * Elements [i, i + Ops::size). The segment index and the position u in
+     * [0, 1) within it are exact: the octave comes from the exponent, the
+     * segment within it from the leading mantissa bits. The coefficients are
+     * gathered per element.
+     */
+    template<class Ops>
+    static LOUDNESS_ALWAYS_INLINE void lookupElements(const Real *x,
+            const Real *scale, const int *function, Real *y, int i,
+            const Real *coefs, int nSegments, Real lowOctave,
+            Real segmentsPerOctave, Real xLo, Real xTop)
+    {
+        typedef typename Ops::Vec Vec;
+        const Vec zero = Ops::set1(0.0), one = Ops::set1(1.0);
+        const Vec n = Ops::set1(segmentsPerOctave);
+
+        const Vec arg = Ops::mul(Ops::load(x + i), Ops::load(scale + i));
+        const Vec v = Ops::min(Ops::max(arg, Ops::set1(xLo)), Ops::set1(xTop));
+
+        //floor of the position within the octave by rounding to nearest
+        const Vec pos = Ops::mul(Ops::sub(Ops::mantissa(v), one), n);
+        const Vec magic = Ops::set1(sizeof(Real) == sizeof(double) ?
+                6755399441055744.0 : 12582912.0);
+        Vec j = Ops::sub(Ops::add(pos, magic), magic);
+        j = Ops::select(Ops::gt(j, pos), Ops::sub(j, one), j);
+        const Vec u = Ops::sub(pos, j);
+        const Vec segment = Ops::add(Ops::mul(Ops::sub(Ops::exponent(v),
+                        Ops::set1(lowOctave)), n), j);
+
+        Real s[Ops::size], c0[Ops::size], c1[Ops::size], c2[Ops::size],
+             c3[Ops::size];
+        Ops::store(s, segment);
+        for(int l=0; l<Ops::size; l++)
+        {
+            const Real *c = coefs + 4 * ((size_t)function[i + l] * nSegments
+                    + (int)s[l]);
+            c0[l] = c[0];
+            c1[l] = c[1];
+            c2[l] = c[2];
+            c3[l] = c[3];
+        }
+
+        Vec p = Ops::add(Ops::mul(Ops::load(c3), u), Ops::load(c2));
+        p = Ops::add(Ops::mul(p, u), Ops::load(c1));
+        p = Ops::add(Ops::mul(p, u), Ops::load(c0));
+        Ops::store(y + i, Ops::select(Ops::gt(Ops::set1(xLo), arg), zero, p));
+    }
+
+    template<class Ops>
+    static LOUDNESS_ALWAYS_INLINE void lookupArray(const Real *x,
+            const Real *scale, const int *function, Real *y, int n,
+            const Real *coefs, int nSegments, Real lowOctave,
+            Real segmentsPerOctave, Real xLo, Real xTop)
+    {
+        int i = 0;
+        for(; i + Ops::size <= n; i += Ops::size)
+            lookupElements<Ops>(x, scale, function, y, i, coefs, nSegments,
+                    lowOctave, segmentsPerOctave, xLo, xTop);
+        for(; i < n; i++)
+            lookupElements<simd::Scalar<Real> >(x, scale, function, y, i,
+                    coefs, nSegments, lowOctave, segmentsPerOctave, xLo, xTop);
+    }
+
+    static void lookupArrayDefault(const Real *x, const Real *scale,
+            const int *function, Real *y, int n, const Real *coefs,
+            int nSegments, Real lowOctave, Real segmentsPerOctave, Real xLo,
+            Real xTop)
+    {
+        lookupArray<simd::Baseline<Real> >(x, scale, function, y, n, coefs,
+                nSegments, lowOctave, segmentsPerOctave, xLo, xTop);
+    }
+
+#if LOUDNESS_X86_DISPATCH
+    LOUDNESS_TARGET_AVX2 static void lookupArrayAVX2(const Real *x,
+            const Real *scale, const int *function, Real *y, int n,
+            const Real *coefs, int nSegments, Real lowOctave,
+            Real segmentsPerOctave, Real xLo, Real xTop)
+    {
+        lookupArray<simd::AVX2<Real> >(x, scale, function, y, n, coefs,
+                nSegments, lowOctave, segmentsPerOctave, xLo, xTop);
+    }
+#endif
+LOUDNESS_SIMD_END
+
+    LogLookupTable::LogLookupTable() :
+        nFunctions_(0),
+        lowOctave_(0),
+        highOctave_(0),
+        segmentsPerOctave_(0),
+        nSegments_(0)
+    {}
+
+    bool LogLookupTable::initialize(int nFunctions, int lowOctave,
+            int highOctave, int segmentsPerOctave, size_t maxBytes)
+    {
+        clear();
+        if((nFunctions < 1) || (highOctave <= lowOctave) ||
+                (segmentsPerOctave < 1) ||
+                (segmentsPerOctave & (segmentsPerOctave - 1)))
+        {
+            LOUDNESS_ERROR("LogLookupTable: Invalid number of functions, octaves or segments.");
+            return 0;
+        }
+
+        int nSegments = (highOctave - lowOctave) * segmentsPerOctave;
+        size_t size = (size_t)4 * nFunctions * nSegments;
+        if(size * sizeof(Real) > maxBytes)
+        {
+            LOUDNESS_WARNING("LogLookupTable: "
+                    << size * sizeof(Real) / (1 << 20)
+                    << " MiB required, more than the limit of "
+                    << maxBytes / (1 << 20) << " MiB.");
+            return 0;
+        }
+
+        nFunctions_ = nFunctions;
+        lowOctave_ = lowOctave;
+        highOctave_ = highOctave;
+        segmentsPerOctave_ = segmentsPerOctave;
+        nSegments_ = nSegments;
+        coefs_.assign(size, 0.0);
+
+        return 1;
+    }
+
+    void LogLookupTable::clear()
+    {
+        nFunctions_ = nSegments_ = segmentsPerOctave_ = 0;
+        RealVec().swap(coefs_);
+    }
+
+    void LogLookupTable::setSegment(Real *c, Real f0, Real f1, Real f2,
+            Real f3)
+    {
+        //forward differences at steps of 1/3, then monomials in u
+        Real d1 = f1 - f0;
+        Real d2 = f2 - 2 * f1 + f0;
+        Real d3 = f3 - 3 * f2 + 3 * f1 - f0;
+        c[0] = f0;
+        c[1] = 3 * (d1 - d2 / 2 + d3 / 3);
+        c[2] = 9 * (d2 - d3) / 2;
+        c[3] = 27 * d3 / 6;
+    }
+
+    void LogLookupTable::lookup(const Real *x, const Real *scale,
+            const int *function, Real *y, int n) const
+    {
+        if(!isInitialized())
+            return;
+
+        //arguments are clamped to just below the top of the table
+        Real xLo = ldexp((Real)1.0, lowOctave_);
+        Real xTop = ldexp(1 - std::numeric_limits<Real>::epsilon(),
+                highOctave_);
+
+#if LOUDNESS_X86_DISPATCH
+        if(cpuHasAVX2())
+            lookupArrayAVX2(x, scale, function, y, n, &coefs_[0], nSegments_,
+                    lowOctave_, segmentsPerOctave_, xLo, xTop);
+        else
+#endif
+            lookupArrayDefault(x, scale, function, y, n, &coefs_[0],
+                    nSegments_, lowOctave_, segmentsPerOctave_, xLo, xTop);
+    }
+
+    Real LogLookupTable::lookup(int function, Real x) const
+    {
+        if(!isInitialized())
+            return 0;
+
+        Real y, scale = 1;
+        Real xLo = ldexp((Real)1.0, lowOctave_);
+        Real xTop = ldexp(1 - std::numeric_limits<Real>::epsilon(),
+                highOctave_);
+        lookupElements<simd::Scalar<Real> >(&x, &scale, &function, &y, 0,
+                &coefs_[0], nSegments_, lowOctave_, segmentsPerOctave_, xLo,
+                xTop);
+        return y;
+    }
+}
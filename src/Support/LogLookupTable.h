@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOGLOOKUPTABLE_H
+#define LOGLOOKUPTABLE_H
+
+#include "Common.h"
+
+namespace loudness{
+
+    /**
+     * @class LogLookupTable
+     *
+     * @brief Piecewise cubic tables of smooth functions of a positive
+     * argument spanning many octaves, such as power laws.
+     *
+     * Each octave [2^e, 2^(e+1)) between the lowest and highest octave is
+     * divided into a number of segments of equal width, so the segment and
+     * the position within it follow from the exponent and mantissa bits of
+     * the argument: the table is indexed by a piecewise linear approximation
+     * of its logarithm. Each segment stores the cubic through the function at
+     * four equally spaced points, so a lookup costs one polynomial and no
+     * transcendental math. Functions with a kink should have it on a segment
+     * boundary, e.g. at a power of two.
+     *
+     * Arguments above the highest octave are clamped to it. Arguments below
+     * the lowest octave give 0.
+     *
+     * lookup() evaluates a different function per element and uses AVX2 when
+     * the processor supports it.
+     *
+     * @author Dominic Ward
+     *
+     * @sa SpecificLoudnessGM
+     */
+    class LogLookupTable
+    {
+    public:
+
+        LogLookupTable();
+
+        /**
+         * @brief Allocates the tables.
+         *
+         * @param nFunctions Number of functions.
+         * @param lowOctave Exponent of the lowest argument.
+         * @param highOctave Exponent of the highest argument.
+         * @param segmentsPerOctave Number of segments per octave, a power of
+         * two.
+         * @param maxBytes Largest table to allocate (default 64 MiB).
+         *
+         * @return true on success, false if the parameters are invalid or
+         * the tables would need more than @a maxBytes. The tables are then
+         * left empty.
+         */
+        bool initialize(int nFunctions, int lowOctave, int highOctave,
+                int segmentsPerOctave, size_t maxBytes = 64 << 20);
+
+        /**
+         * @brief Fills the tables with function(k, x) for every function k.
+         */
+        template<class Function>
+        void fill(Function function)
+        {
+            Real *c = &coefs_[0];
+            for(int k=0; k<nFunctions_; k++)
+            {
+                for(int s=0; s<nSegments_; s++, c+=4)
+                {
+                    Real x0 = getSegmentStart(s);
+                    Real width = getSegmentStart(s + 1) - x0;
+                    setSegment(c, function(k, x0),
+                            function(k, x0 + width / 3),
+                            function(k, x0 + 2 * width / 3),
+                            function(k, x0 + width));
+                }
+            }
+        }
+
+        /**
+         * @brief Returns the largest relative error of the tables against
+         * function(k, x), measured at three points inside every segment.
+         */
+        template<class Function>
+        Real getMaxError(Function function) const
+        {
+            Real maxError = 0;
+            for(int k=0; k<nFunctions_; k++)
+            {
+                for(int s=0; s<nSegments_; s++)
+                {
+                    Real x0 = getSegmentStart(s);
+                    Real width = getSegmentStart(s + 1) - x0;
+                    for(int q=0; q<3; q++)
+                    {
+                        Real x = x0 + width * (2 * q + 1) / 6;
+                        Real exact = function(k, x);
+                        if(exact == 0)
+                            continue;
+                        Real error = fabs(lookup(k, x) / exact - 1);
+                        maxError = error > maxError ? error : maxError;
+                    }
+                }
+            }
+            return maxError;
+        }
+
+        /**
+         * @brief Frees the tables.
+         */
+        void clear();
+
+        /**
+         * @brief y[i] = f_k(x[i] * scale[i]) with k = function[i], for i in
+         * [0, n). @a x and @a y may be the same array.
+         */
+        void lookup(const Real *x, const Real *scale, const int *function,
+                Real *y, int n) const;
+
+        /**
+         * @brief Returns f_k(x).
+         */
+        Real lookup(int function, Real x) const;
+
+        /**
+         * @brief Returns the first argument of segment @a s.
+         */
+        inline Real getSegmentStart(int s) const
+        {
+            int octave = s / segmentsPerOctave_;
+            int j = s - octave * segmentsPerOctave_;
+            return ldexp(1 + j / (Real)segmentsPerOctave_,
+                    lowOctave_ + octave);
+        }
+
+        inline int getSegmentsPerOctave() const
+        {
+            return segmentsPerOctave_;
+        }
+
+        /**
+         * @brief Returns the number of bytes used by the tables.
+         */
+        inline size_t getNBytes() const
+        {
+            return coefs_.size() * sizeof(Real);
+        }
+
+        inline bool isInitialized() const
+        {
+            return nSegments_ > 0;
+        }
+
+    private:
+
+        //cubic coefficients in the position within the segment
+        static void setSegment(Real *c, Real f0, Real f1, Real f2, Real f3);
+
+        int nFunctions_, lowOctave_, highOctave_;
+        int segmentsPerOctave_, nSegments_;
+        RealVec coefs_;
+    };
+}
+
+#endif
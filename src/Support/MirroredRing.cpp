@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MirroredRing.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace loudness{
+
+    MirroredRing::MirroredRing() :
+        data_(0),
+        nTracks_(0),
+        size_(0),
+        trackStride_(0),
+        mappedBytes_(0),
+        mirrored_(false)
+    {}
+
+    MirroredRing::~MirroredRing()
+    {
+        release();
+    }
+
+    bool MirroredRing::initialize(int nTracks, int minSize, bool map)
+    {
+        release();
+        if((nTracks < 1) || (minSize < 1))
+        {
+            LOUDNESS_ERROR("MirroredRing: Invalid size.");
+            return 0;
+        }
+
+        //whole pages, so the mirror can be mapped directly after the ring
+        long pageSize = sysconf(_SC_PAGESIZE);
+        if(pageSize <= 0)
+            pageSize = 4096;
+        size_t ringBytes = ((minSize * sizeof(Real) + pageSize - 1) / pageSize) * pageSize;
+        nTracks_ = nTracks;
+        size_ = ringBytes / sizeof(Real);
+        trackStride_ = 2 * size_;
+
+        if(map && mapMirrored(ringBytes))
+        {
+            mirrored_ = true;
+            LOUDNESS_DEBUG("MirroredRing: Mapped " << nTracks_
+                    << " rings of " << size_ << " samples.");
+        }
+        else
+        {
+            void *ptr = 0;
+            if(posix_memalign(&ptr, LOUDNESS_ALIGNMENT,
+                        nTracks_ * 2 * ringBytes))
+            {
+                LOUDNESS_ERROR("MirroredRing: Failed to allocate "
+                        << nTracks_ * trackStride_ << " samples.");
+                nTracks_ = size_ = trackStride_ = 0;
+                return 0;
+            }
+            data_ = static_cast<Real*>(ptr);
+            mirrored_ = false;
+            LOUDNESS_DEBUG("MirroredRing: Allocated " << nTracks_
+                    << " rings of " << size_
+                    << " samples, mirrored by copying.");
+        }
+
+        clear();
+        return 1;
+    }
+
+    bool MirroredRing::mapMirrored(size_t ringBytes)
+    {
+#if defined(__linux__) && defined(SYS_memfd_create)
+        int fd = syscall(SYS_memfd_create, "loudness-ring", 0);
+        if(fd < 0)
+            return 0;
+        if(ftruncate(fd, nTracks_ * ringBytes) != 0)
+        {
+            close(fd);
+            return 0;
+        }
+
+        //reserve the address range, then map each ring over it twice
+        size_t totalBytes = nTracks_ * 2 * ringBytes;
+        void *base = mmap(0, totalBytes, PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(base == MAP_FAILED)
+        {
+            close(fd);
+            return 0;
+        }
+
+        bool mapped = true;
+        for(int track=0; mapped && (track<nTracks_); track++)
+        {
+            char *ring = static_cast<char*>(base) + track * 2 * ringBytes;
+            for(int copy=0; mapped && (copy<2); copy++)
+            {
+                void *ptr = mmap(ring + copy * ringBytes, ringBytes,
+                        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                        fd, track * ringBytes);
+                mapped = (ptr != MAP_FAILED);
+            }
+        }
+
+        //the mappings keep the memory alive
+        close(fd);
+        if(!mapped)
+        {
+            munmap(base, totalBytes);
+            return 0;
+        }
+
+        data_ = static_cast<Real*>(base);
+        mappedBytes_ = totalBytes;
+        return 1;
+#else
+        (void)ringBytes;
+        return 0;
+#endif
+    }
+
+    void MirroredRing::release()
+    {
+        if(data_)
+        {
+#ifdef __linux__
+            if(mappedBytes_ > 0)
+                munmap(data_, mappedBytes_);
+            else
+                free(data_);
+#else
+            free(data_);
+#endif
+        }
+        data_ = 0;
+        mappedBytes_ = 0;
+        mirrored_ = false;
+        nTracks_ = size_ = trackStride_ = 0;
+    }
+
+    void MirroredRing::clear()
+    {
+        for(int track=0; track<nTracks_; track++)
+            memset(getTrackPointer(track), 0,
+                    (mirrored_ ? size_ : trackStride_) * sizeof(Real));
+    }
+
+    void MirroredRing::write(int track, int idx, const Real *x, int nSamples)
+    {
+        Real *ring = getTrackPointer(track);
+        if(mirrored_)
+        {
+            //samples beyond the ring land in the mirror, i.e. at its start
+            memcpy(ring + idx, x, nSamples * sizeof(Real));
+            return;
+        }
+
+        int head = size_ - idx;
+        if(nSamples <= head)
+        {
+            memcpy(ring + idx, x, nSamples * sizeof(Real));
+            memcpy(ring + size_ + idx, x, nSamples * sizeof(Real));
+        }
+        else
+        {
+            memcpy(ring + idx, x, head * sizeof(Real));
+            memcpy(ring + size_ + idx, x, head * sizeof(Real));
+            memcpy(ring, x + head, (nSamples - head) * sizeof(Real));
+            memcpy(ring + size_, x + head, (nSamples - head) * sizeof(Real));
+        }
+    }
+}
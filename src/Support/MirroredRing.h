@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIRROREDRING_H
+#define MIRROREDRING_H
+
+#include "Common.h"
+
+namespace loudness{
+
+    /**
+     * @class MirroredRing
+     *
+     * @brief Per-track ring buffers whose contents are repeated directly
+     * after the end of each ring.
+     *
+     * Each track holds a ring of getSize() samples followed by a mirror of
+     * the same samples, so any getSize() consecutive samples starting at
+     * ring index i can be read contiguously from getTrackPointer(track) + i,
+     * without wrapping. Track t starts at t*getTrackStride() from the first.
+     *
+     * On Linux, the mirror is made by mapping the memory of each ring twice
+     * into adjacent virtual pages (memfd_create and mmap), so a sample
+     * written to the ring appears in the mirror at no cost. Elsewhere, or if
+     * the mapping fails, write() stores every sample twice instead. Both
+     * cases look the same to readers; use isMirrored() to find out which one
+     * is in use.
+     *
+     * @author Dominic Ward
+     *
+     * @sa FrameGenerator
+     */
+    class MirroredRing
+    {
+    public:
+
+        MirroredRing();
+        ~MirroredRing();
+
+        /**
+         * @brief Allocates a zeroed ring of at least @a minSize samples for
+         * each of @a nTracks tracks.
+         *
+         * The ring size is rounded up to a whole number of memory pages.
+         *
+         * @param map false to mirror by copying even where the mapping is
+         * available.
+         *
+         * @return true on success, false otherwise.
+         */
+        bool initialize(int nTracks, int minSize, bool map = true);
+
+        /**
+         * @brief Sets all samples to zero.
+         */
+        void clear();
+
+        /**
+         * @brief Writes @a nSamples samples to the ring of @a track starting
+         * at ring index @a idx, wrapping at the end of the ring.
+         *
+         * @a idx must be in [0, getSize()) and @a nSamples at most getSize().
+         */
+        void write(int track, int idx, const Real *x, int nSamples);
+
+        /**
+         * @brief Returns a pointer to the first sample of the ring of a
+         * track.
+         */
+        inline Real* getTrackPointer(int track)
+        {
+            return data_ + track * trackStride_;
+        }
+
+        inline const Real* getTrackPointer(int track) const
+        {
+            return data_ + track * trackStride_;
+        }
+
+        /**
+         * @brief Returns the number of samples in each ring.
+         */
+        inline int getSize() const
+        {
+            return size_;
+        }
+
+        /**
+         * @brief Returns the distance in samples between the rings of
+         * consecutive tracks.
+         */
+        inline int getTrackStride() const
+        {
+            return trackStride_;
+        }
+
+        /**
+         * @brief Returns true if the mirror is provided by the virtual memory
+         * mapping, false if write() copies samples into it.
+         */
+        inline bool isMirrored() const
+        {
+            return mirrored_;
+        }
+
+    private:
+
+        MirroredRing(const MirroredRing&);
+        MirroredRing& operator=(const MirroredRing&);
+
+        bool mapMirrored(size_t ringBytes);
+        void release();
+
+        Real *data_;
+        int nTracks_, size_, trackStride_;
+        size_t mappedBytes_;
+        bool mirrored_;
+    };
+}
+
+#endif
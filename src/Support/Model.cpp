@@ -18,12 +18,25 @@
  */
 
 #include "Model.h"
+#include <algorithm>
 
 namespace loudness{
 
     Model::Model(string name, bool dynamicModel) :
         name_(name),
-        dynamicModel_(dynamicModel)
+        dynamicModel_(dynamicModel),
+        initialized_(0),
+        pipelined_(0),
+        fused_(0),
+        nModules_(0),
+        nThreads_(1),
+        modulesPerStage_(1),
+        queueLength_(8),
+        blockFill_(0),
+        frameBatchSize_(1),
+        batchBegin_(0),
+        batchEnd_(0),
+        splitter_(&batcher_)
     {
         LOUDNESS_DEBUG(name_ << ": Constructed.");
     }
@@ -32,6 +45,10 @@ namespace loudness{
 
     bool Model::initialize(const TrackBank &input)
     {
+        //stop any running stages before the chain is rebuilt
+        pipeline_.reset();
+        fusedModules_.clear();
+
         if(!initializeInternal(input))
         {
             LOUDNESS_ERROR(name_ <<
@@ -42,16 +59,99 @@ namespace loudness{
         {
             LOUDNESS_DEBUG(name_ << ": initialised.");
 
+            //worker threads for track-parallel processing
+            if(nThreads_ > 1)
+            {
+                if(!threadPool_ || threadPool_->getNThreads() != nThreads_)
+                    threadPool_.reset(new ThreadPool(nThreads_));
+            }
+            else
+                threadPool_.reset();
+
             //set up the chain
             nModules_ = (int)modules_.size();
+            for(int i=0; i<nModules_; i++)
+                modules_[i]->setThreadPool(threadPool_.get());
             for(int i=0; i<nModules_-1; i++)
                 modules_[i]->setTargetModule(modules_[i+1].get());
+            //collects the final outputs for processBlock()
+            modules_[nModules_-1]->setTargetModule(&collector_);
+
+            //the first run of stateless modules processes batches of frames
+            batchBegin_ = batchEnd_ = 0;
+            if((frameBatchSize_ > 1) && pipelined_)
+            {
+                LOUDNESS_WARNING(name_ << ": Frames are not batched in pipelined mode.");
+            }
+            else if(frameBatchSize_ > 1)
+            {
+                while((batchBegin_ < nModules_) &&
+                        !modules_[batchBegin_]->isStateless())
+                    batchBegin_++;
+                batchEnd_ = batchBegin_;
+                while((batchEnd_ < nModules_) &&
+                        modules_[batchEnd_]->isStateless())
+                    batchEnd_++;
+            }
+            if(isBatched())
+            {
+                LOUDNESS_DEBUG(name_ << ": Modules " << batchBegin_ << " to "
+                        << batchEnd_ - 1 << " process batches of "
+                        << frameBatchSize_ << " frames.");
+                batcher_.setBatchSize(frameBatchSize_);
+                batcher_.setTargetModule(modules_[batchBegin_].get());
+                if(batchBegin_)
+                    modules_[batchBegin_-1]->setTargetModule(&batcher_);
+                modules_[batchEnd_-1]->setTargetModule(&splitter_);
+                if(batchEnd_ < nModules_)
+                    splitter_.setTargetModule(modules_[batchEnd_].get());
+                else
+                    splitter_.setTargetModule(&collector_);
+            }
+
             //initialise all
-            modules_[0]->initialize(input);
+            if(isBatched() && (batchBegin_ == 0))
+                batcher_.initialize(input);
+            else
+                modules_[0]->initialize(input);
+
+            //the chain as processed, with fusable runs replaced
+            fusedBy_.assign(nModules_, nullptr);
+            if(fused_)
+                fuseModules(input);
+            chain_.clear();
+            for(int i=0; i<nModules_; i++)
+            {
+                if(isBatched() && (i == batchBegin_))
+                    chain_.push_back(&batcher_);
+                if(isBatched() && (i == batchEnd_))
+                    chain_.push_back(&splitter_);
+                if(!fusedBy_[i])
+                    chain_.push_back(modules_[i].get());
+                else if((i == 0) || (fusedBy_[i-1] != fusedBy_[i]))
+                    chain_.push_back(fusedBy_[i]);
+            }
+            if(isBatched() && (batchEnd_ == nModules_))
+                chain_.push_back(&splitter_);
+
+            //holds partially filled input buffers between processBlock() calls
+            blockBuffer_.initialize(input);
+            blockFill_ = 0;
 
             LOUDNESS_DEBUG(name_ 
                     << ": Targets set and all modules initialised.");
 
+            if(pipelined_)
+            {
+                pipeline_.reset(new Pipeline(queueLength_));
+                if(!pipeline_->initialize(chain_, modulesPerStage_))
+                {
+                    LOUDNESS_ERROR(name_ << ": Pipeline not initialised!");
+                    pipeline_.reset();
+                    return 0;
+                }
+            }
+
             initialized_ = 1;
             return 1;
         }
@@ -60,14 +160,173 @@ namespace loudness{
     void Model::process(const TrackBank &input)
     {
         if(initialized_)
-            modules_[0]->process(input);
+        {
+            if(pipeline_)
+                pipeline_->process(input);
+            else
+                chain_[0]->process(input);
+        }
         else
             LOUDNESS_WARNING(name_ << ": Not initialised!");
     }
 
+    const TrackBank& Model::processBlock(const TrackBank &block)
+    {
+        if(!initialized_)
+        {
+            LOUDNESS_WARNING(name_ << ": Not initialised!");
+            return blockOutput_;
+        }
+        if((block.getNTracks() != blockBuffer_.getNTracks()) ||
+           (block.getNChannels() != blockBuffer_.getNChannels()))
+        {
+            LOUDNESS_ERROR(name_ 
+                    << ": Block must have the same number of tracks and channels as the initialisation input.");
+            return blockOutput_;
+        }
+
+        //outputs still queued from process() do not belong to this block
+        flush();
+        collector_.setEnabled(true);
+
+        int bufferSize = blockBuffer_.getNSamples();
+        int nSamples = block.getNSamples();
+        int readPos = 0;
+        while(readPos < nSamples)
+        {
+            int n = std::min(nSamples - readPos, bufferSize - blockFill_);
+            for(int track=0; track<block.getNTracks(); track++)
+            {
+                for(int chn=0; chn<block.getNChannels(); chn++)
+                {
+                    const Real *in = block.getSignalReadPointer(track, chn, readPos);
+                    std::copy(in, in + n,
+                            blockBuffer_.getSignalWritePointer(track, chn, blockFill_));
+                }
+            }
+            readPos += n;
+            blockFill_ += n;
+
+            if(blockFill_ == bufferSize)
+            {
+                process(blockBuffer_);
+                blockFill_ = 0;
+            }
+        }
+
+        flush();
+        collector_.setEnabled(false);
+        collector_.collect(blockOutput_);
+        return blockOutput_;
+    }
+
     void Model::reset()
     {
-        modules_[0]->reset();
+        blockFill_ = 0;
+        if(pipeline_)
+            pipeline_->reset();
+        else
+            chain_[0]->reset();
+    }
+
+    void Model::fuseModules(const TrackBank &input)
+    {
+        int i = 0;
+        while(i < nModules_)
+        {
+            //runs do not cross the ends of the batched run
+            int end = nModules_;
+            if(isBatched() && (i < batchBegin_))
+                end = batchBegin_;
+            else if(isBatched() && (i < batchEnd_))
+                end = batchEnd_;
+
+            //longest run of element-wise modules and an optional reduction
+            int j = i;
+            while((j < end) &&
+                    (modules_[j]->getFusion() == Module::ELEMENT_WISE))
+                j++;
+            if((j < end) &&
+                    (modules_[j]->getFusion() == Module::REDUCTION))
+                j++;
+
+            vector<Module*> stages;
+            for(int k=i; k<j; k++)
+                stages.push_back(modules_[k].get());
+            const TrackBank *runInput = &input;
+            if(isBatched() && (i == batchBegin_))
+                runInput = batcher_.getOutput();
+            else if(isBatched() && (i == batchEnd_))
+                runInput = splitter_.getOutput();
+            else if(i)
+                runInput = modules_[i-1]->getOutput();
+
+            if((runInput->getNSamples() == 1) &&
+                    FusedModule::canFuse(stages, runInput->getNChannels()))
+            {
+                unique_ptr<FusedModule> fused(new FusedModule(stages));
+                fused->setThreadPool(threadPool_.get());
+                fused->setTargetModule(getSinkModule(j));
+
+                if(fused->initialize(*runInput))
+                {
+                    LOUDNESS_DEBUG(name_ << ": " << fused->getName());
+                    for(unsigned int r=0; r<requestedOutputs_.size(); r++)
+                    {
+                        int k = requestedOutputs_[r];
+                        if((k >= i) && (k < j))
+                            fused->requestOutput(modules_[k].get());
+                    }
+                    Module *source = getSourceModule(i);
+                    if(source)
+                        source->setTargetModule(fused.get());
+                    for(int k=i; k<j; k++)
+                        fusedBy_[k] = fused.get();
+                    fusedModules_.push_back(std::move(fused));
+                }
+            }
+
+            i = j > i ? j : i + 1;
+        }
+    }
+
+    Module* Model::getSourceModule(int i)
+    {
+        if(isBatched() && (i == batchBegin_))
+            return &batcher_;
+        else if(isBatched() && (i == batchEnd_))
+            return &splitter_;
+        else if(i == 0)
+            return 0;
+        else if(fusedBy_[i-1])
+            return fusedBy_[i-1];
+        else
+            return modules_[i-1].get();
+    }
+
+    Module* Model::getSinkModule(int i)
+    {
+        if(isBatched() && (i == batchBegin_))
+            return &batcher_;
+        else if(isBatched() && (i == batchEnd_))
+            return &splitter_;
+        else if(i == nModules_)
+            return &collector_;
+        else
+            return modules_[i].get();
+    }
+
+    bool Model::isBatched() const
+    {
+        return batchEnd_ > batchBegin_;
+    }
+
+    void Model::flush()
+    {
+        if(isBatched())
+            batcher_.emitBatch();
+        if(pipeline_)
+            pipeline_->flush();
     }
 
     void Model::resize(int nTracks)
@@ -75,10 +334,73 @@ namespace loudness{
         modules_[0]->resize(nTracks);
     }
 
+    void Model::setNThreads(int nThreads)
+    {
+        if(initialized_)
+            LOUDNESS_WARNING(name_ << ": Number of threads will be applied on the next initialisation.");
+        nThreads_ = nThreads < 1 ? 1 : nThreads;
+    }
+
+    int Model::getNThreads() const
+    {
+        return nThreads_;
+    }
+
+    void Model::setPipelined(bool pipelined, int modulesPerStage, int queueLength)
+    {
+        if(initialized_)
+            LOUDNESS_WARNING(name_ << ": Pipelining will be applied on the next initialisation.");
+        pipelined_ = pipelined;
+        modulesPerStage_ = modulesPerStage < 1 ? 1 : modulesPerStage;
+        queueLength_ = queueLength < 1 ? 1 : queueLength;
+    }
+
+    bool Model::isPipelined() const
+    {
+        return pipelined_;
+    }
+
+    void Model::setFused(bool fused)
+    {
+        if(initialized_)
+            LOUDNESS_WARNING(name_ << ": Fusion will be applied on the next initialisation.");
+        fused_ = fused;
+    }
+
+    bool Model::isFused() const
+    {
+        return fused_;
+    }
+
+    void Model::setFrameBatchSize(int nFrames)
+    {
+        if(initialized_)
+            LOUDNESS_WARNING(name_ << ": Frame batch size will be applied on the next initialisation.");
+        frameBatchSize_ = nFrames < 1 ? 1 : nFrames;
+    }
+
+    int Model::getFrameBatchSize() const
+    {
+        return frameBatchSize_;
+    }
+
+    void Model::requestModuleOutput(int module)
+    {
+        if(initialized_)
+            LOUDNESS_WARNING(name_ << ": Output request will be applied on the next initialisation.");
+        requestedOutputs_.push_back(module);
+    }
+
     const TrackBank* Model::getModuleOutput(int module) const
     {
         if (module<nModules_)
+        {
+            if(fusedBy_[module] && !fusedBy_[module]->isOutputWritten(
+                        modules_[module].get()))
+                LOUDNESS_WARNING(name_ << ": Output of fused module "
+                        << module << " is not written, see requestModuleOutput().");
             return modules_[module]->getOutput();
+        }
         else
             return 0;
     }
@@ -98,6 +420,24 @@ namespace loudness{
         }
     }
 
+    ModuleStats Model::getModuleStats(int module) const
+    {
+        if(module < (int)modules_.size())
+            return modules_[module]->getStats();
+        else
+        {
+            LOUDNESS_ERROR(name_ << ": index out of bounds.");
+            ModuleStats stats = {0, 0, 0, 0};
+            return stats;
+        }
+    }
+
+    void Model::resetModuleStats()
+    {
+        for(unsigned int i=0; i<modules_.size(); i++)
+            modules_[i]->resetStats();
+    }
+
     const string& Model::getName() const
     {
         return name_;
@@ -117,11 +457,190 @@ namespace loudness{
     {
         return nModules_;
     }            
-}
 
+    Model::FrameCollector::FrameCollector() :
+        Module("FrameCollector"),
+        enabled_(0),
+        nTracks_(0),
+        nOutputs_(0),
+        nFrames_(0),
+        fs_(0),
+        frameRate_(0)
+    {}
 
+    bool Model::FrameCollector::initializeInternal(const TrackBank &input)
+    {
+        nTracks_ = input.getNTracks();
+        nOutputs_ = input.getNChannels() * input.getNSamples();
+        fs_ = input.getFs();
+        frameRate_ = input.getFrameRate();
+        values_.assign(nTracks_, RealVec());
+        nFrames_ = 0;
+        return 1;
+    }
 
+    void Model::FrameCollector::processInternal(const TrackBank &input)
+    {
+        if(!enabled_)
+            return;
 
+        int nSamples = input.getNSamples();
+        for(int track=0; track<nTracks_; track++)
+        {
+            for(int chn=0; chn<input.getNChannels(); chn++)
+            {
+                const Real *in = input.getSignalReadPointer(track, chn);
+                values_[track].insert(values_[track].end(), in, in + nSamples);
+            }
+        }
+        nFrames_++;
+    }
 
+    void Model::FrameCollector::resetInternal()
+    {
+        for(int track=0; track<nTracks_; track++)
+            values_[track].clear();
+        nFrames_ = 0;
+    }
 
+    void Model::FrameCollector::setEnabled(bool enabled)
+    {
+        enabled_ = enabled;
+    }
 
+    void Model::FrameCollector::collect(TrackBank &frames)
+    {
+        frames.initialize(nTracks_, nFrames_, nOutputs_, fs_);
+        frames.setFrameRate(frameRate_);
+        for(int track=0; track<nTracks_; track++)
+        {
+            for(int frame=0; frame<nFrames_; frame++)
+            {
+                const Real *in = &values_[track][frame * nOutputs_];
+                std::copy(in, in + nOutputs_,
+                        frames.getSignalWritePointer(track, frame));
+            }
+        }
+        resetInternal();
+    }
+
+    Model::FrameBatcher::FrameBatcher() :
+        Module("FrameBatcher"),
+        batchSize_(1),
+        nTracks_(0),
+        nFrames_(0)
+    {}
+
+    void Model::FrameBatcher::setBatchSize(int batchSize)
+    {
+        batchSize_ = batchSize;
+    }
+
+    int Model::FrameBatcher::getBatchSize() const
+    {
+        return batchSize_;
+    }
+
+    int Model::FrameBatcher::getNFrames() const
+    {
+        return nFrames_;
+    }
+
+    bool Model::FrameBatcher::initializeInternal(const TrackBank &input)
+    {
+        nTracks_ = input.getNTracks();
+        output_.initialize(nTracks_ * batchSize_, input.getNChannels(),
+                input.getNSamples(), input.getFs());
+        output_.setFrameRate(input.getFrameRate());
+        output_.setCentreFreqs(input.getCentreFreqs());
+        nFrames_ = 0;
+        return 1;
+    }
+
+    void Model::FrameBatcher::process(const TrackBank &input)
+    {
+        if(initialized_ && input.getAndTrigs())
+        {
+#ifdef LOUDNESS_PROFILE
+            startProfile();
+            processInternal(input);
+            stopProfile();
+#else
+            processInternal(input);
+#endif
+            if(nFrames_ == batchSize_)
+                emitBatch();
+        }
+    }
+
+    void Model::FrameBatcher::processInternal(const TrackBank &input)
+    {
+        int nSamples = input.getNSamples();
+        for(int track=0; track<nTracks_; track++)
+        {
+            for(int chn=0; chn<input.getNChannels(); chn++)
+            {
+                const Real *in = input.getSignalReadPointer(track, chn);
+                std::copy(in, in + nSamples, output_.getSignalWritePointer(
+                            track * batchSize_ + nFrames_, chn));
+            }
+        }
+        nFrames_++;
+    }
+
+    void Model::FrameBatcher::emitBatch()
+    {
+        if(nFrames_ && targetModule_)
+            targetModule_->process(output_);
+        nFrames_ = 0;
+    }
+
+    void Model::FrameBatcher::resetInternal()
+    {
+        nFrames_ = 0;
+    }
+
+    Model::FrameSplitter::FrameSplitter(const FrameBatcher *batcher) :
+        Module("FrameSplitter"),
+        batcher_(batcher)
+    {}
+
+    bool Model::FrameSplitter::initializeInternal(const TrackBank &input)
+    {
+        int batchSize = batcher_->getBatchSize();
+        if((input.getNTracks() % batchSize) ||
+                (input.getLayout() != TrackBank::TRACK_MAJOR))
+        {
+            LOUDNESS_ERROR(name_
+                    << ": Input must be a track major batch of " << batchSize << " frames.");
+            return 0;
+        }
+        output_.initialize(input.getNTracks() / batchSize,
+                input.getNChannels(), input.getNSamples(), input.getFs());
+        output_.setFrameRate(input.getFrameRate());
+        output_.setCentreFreqs(input.getCentreFreqs());
+        return 1;
+    }
+
+    void Model::FrameSplitter::process(const TrackBank &input)
+    {
+        if(!initialized_ || !input.getAndTrigs())
+            return;
+
+        //frame f of track t is track t * batchSize + f of the input; the
+        //view is only read by the target module
+        int batchSize = batcher_->getBatchSize();
+        int trackStride = input.getTrackStride();
+        Real *data = const_cast<Real*>(input.getTrackReadPointer(0));
+        for(int frame=0; frame<batcher_->getNFrames(); frame++)
+        {
+            output_.setView(data + frame * trackStride, batchSize * trackStride);
+            if(targetModule_)
+                targetModule_->process(output_);
+        }
+    }
+
+    void Model::FrameSplitter::processInternal(const TrackBank&){}
+
+    void Model::FrameSplitter::resetInternal(){}
+}
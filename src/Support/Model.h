@@ -21,6 +21,8 @@
 #define MODEL_H
 
 #include "Module.h"
+#include "FusedModule.h"
+#include "Pipeline.h"
 
 namespace loudness{
 
@@ -40,6 +42,13 @@ namespace loudness{
      * Unlike Module, there is no processInternal() function. Instead, process()
      * will call the process function on the first (root) module in the chain
      * which will trigger the remaining modules internally.
+     *
+     * Runs of consecutive modules that are element-wise over channels or
+     * reduce them (see Module::getFusion()) can be processed as a single
+     * FusedModule, see setFused().
+     *
+     * Runs of stateless modules (see Module::isStateless()) can process many
+     * frames per call as a batch of tracks, see setFrameBatchSize().
      * 
      * @author Dominic Ward
      *
@@ -81,13 +90,154 @@ namespace loudness{
         */
         void process(const TrackBank &input);
 
+        /**
+        * @brief Processes a block of any number of samples and returns the
+        * outputs of the final module for every frame completed in the block.
+        *
+        * The block must have the same number of tracks and channels as the
+        * TrackBank used to initialise the model, but @a block.getNSamples()
+        * is arbitrary. Samples are passed to the first module in buffers of
+        * the initialisation size; any remainder is carried over to the next
+        * call. A FrameGenerator emits every frame due within each buffer, so
+        * initialising the model with a buffer longer than the hop size
+        * processes many frames per call. With setFrameBatchSize(), the
+        * stateless modules downstream then process those frames in batches,
+        * the last of which may be partial.
+        *
+        * The returned TrackBank has the same number of tracks as the final
+        * module's output, one channel per frame and one sample per output
+        * value. With an output of C channels by S samples, value (c, s) of
+        * frame f is at getSample(track, f, c * S + s). The reference stays
+        * valid until the next call to processBlock(). In pipelined mode the
+        * pipeline is flushed before returning.
+        *
+        * @param block The input TrackBank to be processed.
+        *
+        * @return The frames x outputs TrackBank.
+        */
+        const TrackBank& processBlock(const TrackBank &block);
+
         /**
         * @brief Resets all modules. The output TrackBanks are also cleared.
+        *
+        * In pipelined mode, all queued TrackBanks are processed first.
         */
         void reset();
 
+        /**
+        * @brief Blocks until all TrackBanks queued between pipeline stages
+        * have been processed.
+        *
+        * Only has an effect in pipelined mode (see setPipelined()), where
+        * module outputs beyond the first stage are consistent only after
+        * calling this function, or when frames are batched (see
+        * setFrameBatchSize()), where the frames of an incomplete batch are
+        * processed.
+        */
+        void flush();
+
         void resize(int nTracks);
 
+        /**
+         * @brief Sets the number of threads used to process tracks in
+         * parallel.
+         *
+         * When @a nThreads is greater than one, the model owns a pool of
+         * worker threads (including the calling thread) and the per-track
+         * work of each module is partitioned across it. Must be called before
+         * initialize(). The default is 1 (serial processing).
+         */
+        void setNThreads(int nThreads);
+
+        /**
+         * @brief Returns the number of threads used for processing.
+         */
+        int getNThreads() const;
+
+        /**
+         * @brief Enables pipelined execution.
+         *
+         * When enabled, the module chain is split into stages of @a
+         * modulesPerStage consecutive modules. The first stage runs on the
+         * thread calling process(), the remaining stages run concurrently on
+         * their own threads, connected by lock-free rings holding up to @a
+         * queueLength TrackBanks. process() therefore returns once the first
+         * stage is done; call flush() before reading the outputs of later
+         * modules. Must be called before initialize(). Disabled by default.
+         *
+         * @sa Pipeline
+         */
+        void setPipelined(bool pipelined, int modulesPerStage = 1, int queueLength = 8);
+
+        /**
+         * @brief Returns true if pipelined execution is enabled.
+         */
+        bool isPipelined() const;
+
+        /**
+         * @brief Enables fusion of element-wise and reduction modules.
+         *
+         * When enabled, initialize() replaces every run of two or more
+         * consecutive modules that are ELEMENT_WISE, optionally followed by a
+         * REDUCTION (see Module::getFusion()), by a FusedModule which
+         * processes each track in a single pass. The output TrackBanks of the
+         * fused element-wise modules are then only written if requested with
+         * requestModuleOutput(), and their statistics are gathered by the
+         * FusedModule instead. In pipelined mode each run counts as a single
+         * module. Must be called before initialize(). Disabled by default.
+         *
+         * @sa FusedModule
+         */
+        void setFused(bool fused);
+
+        /**
+         * @brief Returns true if fusion of modules is enabled.
+         */
+        bool isFused() const;
+
+        /**
+         * @brief Sets the number of frames processed per call by stateless
+         * modules.
+         *
+         * When @a nFrames is greater than one, initialize() finds the first
+         * run of consecutive modules that are stateless (see
+         * Module::isStateless()), such as the spectrum, excitation and
+         * specific loudness stages, and lets them process @a nFrames frames
+         * per call as if they were tracks: frame f of track t becomes track
+         * t * nFrames + f of their inputs and outputs. The frames are then
+         * passed on one at a time to the module following the run. process()
+         * passes a batch on once it is complete; processBlock() and flush()
+         * also pass on an incomplete batch. Not available in pipelined mode.
+         * Must be called before initialize(). The default is 1 (no batching).
+         *
+         * Batching does not speed up the kernels themselves: PowerSpectrum
+         * transforms the frames of a batch in one FFTW call, but on a single
+         * core a batch of 8 frames runs about 5% slower than no batching and
+         * a batch of 32 about 40% slower (cache pressure). It is meant for
+         * spreading models with few tracks over threads (see setNThreads()).
+         * Frames may pass through different (batched) FFT plans than without
+         * batching, so the output may differ from unbatched processing by
+         * rounding.
+         */
+        void setFrameBatchSize(int nFrames);
+
+        /**
+         * @brief Returns the number of frames processed per call by
+         * stateless modules.
+         */
+        int getFrameBatchSize() const;
+
+        /**
+         * @brief Requests the output TrackBank of @a module to be written
+         * even if the module is fused with its neighbours.
+         *
+         * Only needed with setFused(). Must be called before initialize();
+         * outputs of other fused element-wise modules are not written.
+         *
+         * @param module Module index.
+         */
+        void requestModuleOutput(int module);
+
         /**
          * @brief Returns the initialisation state.
          *
@@ -105,6 +255,12 @@ namespace loudness{
         /**
          * @brief Returns a pointer to the output TrackBank of @a module.
          *
+         * If @a module has been fused with its neighbours (see setFused()),
+         * its output is only written if requested with requestModuleOutput()
+         * before initialisation. If frames are batched (see
+         * setFrameBatchSize()), the output of a module in the batched run
+         * holds the last batch.
+         *
          * @param module Module index.
          *
          * @return TrackBank pointer.
@@ -118,15 +274,123 @@ namespace loudness{
         int getNModules() const;
 
         string getModuleName(int module) const;
+
+        /**
+         * @brief Returns the processing statistics of @a module.
+         *
+         * Statistics are only gathered when the library is compiled with
+         * LOUDNESS_PROFILE defined (make PROFILE=1); otherwise all fields
+         * are zero. In pipelined mode, call flush() first.
+         *
+         * @param module Module index.
+         *
+         * @sa ModuleStats
+         */
+        ModuleStats getModuleStats(int module) const;
+
+        /**
+         * @brief Zeros the processing statistics of all modules.
+         */
+        void resetModuleStats();
         const string& getName() const;
 
     protected:
         virtual bool initializeInternal(const TrackBank &input) = 0;
 
+        /*
+         * Terminal module used by processBlock(): appends each output of the
+         * final module to a frames x outputs buffer while enabled.
+         */
+        class FrameCollector : public Module
+        {
+        public:
+            FrameCollector();
+            void setEnabled(bool enabled);
+            void collect(TrackBank &frames);
+        private:
+            virtual bool initializeInternal(const TrackBank &input);
+            virtual void processInternal(const TrackBank &input);
+            virtual void resetInternal();
+
+            bool enabled_;
+            int nTracks_, nOutputs_, nFrames_, fs_;
+            Real frameRate_;
+            RealVecVec values_;
+        };
+
+        /*
+         * Gathers consecutive frames into the tracks of a batch: frame f of
+         * track t is copied to track t * batchSize + f of the output, which
+         * is passed on when full or with emitBatch().
+         */
+        class FrameBatcher : public Module
+        {
+        public:
+            FrameBatcher();
+            void setBatchSize(int batchSize);
+            int getBatchSize() const;
+            //number of frames in the batch being passed on or gathered
+            int getNFrames() const;
+            void emitBatch();
+            virtual void process(const TrackBank &input);
+        private:
+            virtual bool initializeInternal(const TrackBank &input);
+            virtual void processInternal(const TrackBank &input);
+            virtual void resetInternal();
+
+            int batchSize_, nTracks_, nFrames_;
+        };
+
+        /*
+         * Passes each frame of a batch gathered by a FrameBatcher on to the
+         * target module as a view of the input.
+         */
+        class FrameSplitter : public Module
+        {
+        public:
+            FrameSplitter(const FrameBatcher *batcher);
+            virtual void process(const TrackBank &input);
+        private:
+            virtual bool initializeInternal(const TrackBank &input);
+            virtual void processInternal(const TrackBank &input);
+            virtual void resetInternal();
+
+            const FrameBatcher *batcher_;
+        };
+
         string name_;
-        bool dynamicModel_, initialized_;
-        int nModules_;
+        /*
+         * Replaces runs of fusable modules in chain_ by FusedModules.
+         */
+        void fuseModules(const TrackBank &input);
+
+        /*
+         * Module passing its output to module i as processed, or null for
+         * the first module.
+         */
+        Module* getSourceModule(int i);
+
+        /*
+         * Module receiving the output of module i - 1 as processed.
+         */
+        Module* getSinkModule(int i);
+
+        bool isBatched() const;
+
+        bool dynamicModel_, initialized_, pipelined_, fused_;
+        int nModules_, nThreads_, modulesPerStage_, queueLength_, blockFill_;
+        int frameBatchSize_, batchBegin_, batchEnd_;
         vector<unique_ptr<Module>> modules_;
+        vector<Module*> chain_;
+        vector<unique_ptr<FusedModule>> fusedModules_;
+        vector<FusedModule*> fusedBy_;
+        vector<int> requestedOutputs_;
+        FrameCollector collector_;
+        FrameBatcher batcher_;
+        FrameSplitter splitter_;
+        TrackBank blockBuffer_, blockOutput_;
+        unique_ptr<ThreadPool> threadPool_;
+        unique_ptr<Pipeline> pipeline_;
     };
 }
 
@@ -22,10 +22,17 @@
 namespace loudness{
     
     Module::Module(string name):
+#ifdef LOUDNESS_PROFILE
+        wallTimer_("WALL"),
+        cpuTimer_("CPU"),
+        callLatency_(0),
+#endif
         name_(name)
     {
         targetModule_ = nullptr;
+        threadPool_ = nullptr;
         initialized_ = 0;
+        resetStats();
         LOUDNESS_DEBUG(name_ << ": Constructed.");
     };
 
@@ -64,7 +71,13 @@ namespace loudness{
     {
         if(initialized_ && input.getAndTrigs())
         {
+#ifdef LOUDNESS_PROFILE
+            startProfile();
             processInternal(input);
+            stopProfile();
+#else
+            processInternal(input);
+#endif
             if(targetModule_)
                 targetModule_->process(output_);
         }
@@ -106,6 +119,42 @@ namespace loudness{
         targetModule_ = 0;
     }
 
+    void Module::setThreadPool(ThreadPool *threadPool)
+    {
+        threadPool_ = threadPool;
+    }
+
+    int Module::getNWorkers() const
+    {
+        if(threadPool_)
+            return threadPool_->getNThreads();
+        else
+            return 1;
+    }
+
+    void Module::processTracks(int nTracks, const ThreadPool::TaskFunction &func)
+    {
+        if(threadPool_)
+            threadPool_->run(nTracks, func);
+        else
+        {
+            for(int track = 0; track < nTracks; track++)
+                func(track, 0);
+        }
+    }
+
+    void Module::processFused(int, const Real*, Real*, int){}
+
+    Module::Fusion Module::getFusion() const
+    {
+        return NO_FUSION;
+    }
+
+    bool Module::isStateless() const
+    {
+        return 0;
+    }
+
     bool Module::isInitialized() const
     {
         return initialized_;
@@ -120,5 +169,49 @@ namespace loudness{
     {
         return name_;
     }
+
+    const ModuleStats& Module::getStats() const
+    {
+        return stats_;
+    }
+
+    void Module::resetStats()
+    {
+        stats_.nCalls = 0;
+        stats_.wallTime = 0;
+        stats_.cpuTime = 0;
+        stats_.maxLatency = 0;
+    }
+
+#ifdef LOUDNESS_PROFILE
+    void Module::startProfile()
+    {
+        callLatency_ = 0;
+        resumeProfile();
+    }
+
+    void Module::pauseProfile()
+    {
+        wallTimer_.toc();
+        cpuTimer_.toc();
+        callLatency_ += wallTimer_.getElapsedTime();
+        stats_.wallTime += wallTimer_.getElapsedTime();
+        stats_.cpuTime += cpuTimer_.getElapsedTime();
+    }
+
+    void Module::resumeProfile()
+    {
+        cpuTimer_.tic();
+        wallTimer_.tic();
+    }
+
+    void Module::stopProfile()
+    {
+        pauseProfile();
+        stats_.nCalls++;
+        if(callLatency_ > stats_.maxLatency)
+            stats_.maxLatency = callLatency_;
+    }
+#endif
 }
 
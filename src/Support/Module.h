@@ -21,9 +21,30 @@
 #define MODULE_H
 
 #include "TrackBank.h"
+#include "ThreadPool.h"
+#ifdef LOUDNESS_PROFILE
+#include "Timer.h"
+#endif
 
 namespace loudness{
 
+    /**
+     * @brief Processing statistics of a single module.
+     *
+     * Times are in seconds and exclude the time spent in the target module.
+     * All fields remain zero unless the library is compiled with
+     * LOUDNESS_PROFILE defined (make PROFILE=1).
+     *
+     * @sa Module::getStats(), Model::getModuleStats()
+     */
+    struct ModuleStats
+    {
+        long int nCalls; ///< Number of calls to processInternal().
+        double wallTime; ///< Cumulative wall-clock time.
+        double cpuTime; ///< Cumulative CPU time of the process.
+        double maxLatency; ///< Longest wall-clock time of a single call.
+    };
+
     /**
      * @class Module
      * 
@@ -55,6 +76,11 @@ namespace loudness{
      * processInternal() is only called if the TrackBank trigger is 1 (which is
      * the default), otherwise the output bank will not be updated.
      *
+     * Tracks are independent, so modules may distribute their per-track work
+     * over a ThreadPool (see setThreadPool()) by routing the track loop of
+     * processInternal() through processTracks(). Any scratch memory used
+     * inside the loop must then be allocated per worker (see getNWorkers()).
+     *
      * @author Dominic Ward
      *
      * @sa TrackBank
@@ -62,6 +88,18 @@ namespace loudness{
     class Module
     {
     public:
+
+        /**
+         * @brief How the per-track work of a module may be fused with that
+         * of its neighbours.
+         */
+        enum Fusion
+        {
+            NO_FUSION, ///< Processes whole TrackBanks only.
+            ELEMENT_WISE, ///< Each output channel depends on the same input channel only.
+            REDUCTION ///< Reduces all channels of a track to its output.
+        };
+
         Module(string name = "Module");
         virtual ~Module();
 
@@ -131,6 +169,17 @@ namespace loudness{
          */
         void removeTargetModule();
 
+        /**
+         * @brief Sets the thread pool used to process tracks in parallel.
+         *
+         * Must be called before initialize() so that per-worker scratch
+         * memory can be allocated. The pool must outlive the module. Pass a
+         * null pointer to process tracks serially (the default).
+         *
+         * @param threadPool Pointer to the thread pool.
+         */
+        void setThreadPool(ThreadPool *threadPool);
+
         /**
          * @brief Returns the module initialisation state.
          *
@@ -153,6 +202,40 @@ namespace loudness{
          */
         const string& getName() const;
 
+        /**
+         * @brief Returns the processing statistics accumulated since
+         * construction or the last call to resetStats().
+         *
+         * CPU time is measured with the process clock, so it includes the
+         * work of thread pool workers but, in pipelined mode, also that of
+         * stages running concurrently.
+         */
+        const ModuleStats& getStats() const;
+
+        /**
+         * @brief Zeros the processing statistics.
+         */
+        void resetStats();
+
+        /**
+         * @brief Returns how the module may be fused once initialised.
+         *
+         * The default is NO_FUSION. Fusable modules must take one sample per
+         * channel and, if ELEMENT_WISE, output one sample per channel.
+         */
+        virtual Fusion getFusion() const;
+
+        /**
+         * @brief Returns true if the output of every call depends only on the
+         * input of that call.
+         *
+         * Each output track must depend only on the same input track or, for
+         * modules pairing track t with track t + nTracks/2, on that pair.
+         * Frames may then be processed as a batch of tracks (see
+         * Model::setFrameBatchSize()). The default is false.
+         */
+        virtual bool isStateless() const;
+
     protected:
         //Pure virtual functions
         virtual bool initializeInternal(const TrackBank &input) = 0;
@@ -160,11 +243,54 @@ namespace loudness{
         virtual void resetInternal() = 0;
         //virtual void resizeInternal(int nTracks) = 0;
 
+        /**
+         * @brief Returns the number of workers that may execute the function
+         * passed to processTracks() concurrently.
+         */
+        int getNWorkers() const;
+
+        /**
+         * @brief Calls @a func(track, worker) for every track in [0,
+         * nTracks), distributing the tracks over the thread pool if one has
+         * been set.
+         *
+         * @a worker is in [0, getNWorkers()) and identifies the per-worker
+         * scratch memory to use.
+         */
+        void processTracks(int nTracks, const ThreadPool::TaskFunction &func);
+
+        /*
+         * Fused processing of a single track. x holds the input, one sample
+         * per channel, contiguously. ELEMENT_WISE modules write their output
+         * to y in the same layout, y may be x. REDUCTION modules write their
+         * output TrackBank instead. Called by FusedModule on the worker given.
+         */
+        virtual void processFused(int track, const Real *x, Real *y,
+                int worker);
+        friend class FusedModule;
+
+#ifdef LOUDNESS_PROFILE
+        /*
+         * Timing of a single call: startProfile() ... stopProfile(). Modules
+         * which pass output to their target from within processInternal()
+         * bracket that call with pauseProfile() and resumeProfile().
+         */
+        void startProfile();
+        void pauseProfile();
+        void resumeProfile();
+        void stopProfile();
+
+        Timer wallTimer_, cpuTimer_;
+        double callLatency_;
+#endif
+
         //members
         bool initialized_;
         Module *targetModule_;
+        ThreadPool *threadPool_;
         TrackBank output_;
         string name_;
+        ModuleStats stats_;
     };
 }
 
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Pipeline.h"
+#include <chrono>
+#include <algorithm>
+
+namespace loudness{
+
+    /*
+     * Spin briefly before yielding, then sleep, so that a waiting stage
+     * responds quickly at high frame rates without burning a core when idle.
+     */
+    static void backOff(int &nTries)
+    {
+        if (nTries < 64)
+            nTries++;
+        else if (nTries < 128)
+        {
+            nTries++;
+            std::this_thread::yield();
+        }
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    Pipeline::StageWriter::StageWriter(SPSCRing<TrackBank> *ring,
+            const std::atomic<bool> *stop) :
+        Module("StageWriter"),
+        ring_(ring),
+        stop_(stop)
+    {}
+
+    bool Pipeline::StageWriter::initializeInternal(const TrackBank &input)
+    {
+        for (int i = 0; i < ring_->getCapacity(); i++)
+            ring_->getSlot(i) = input;
+        return 1;
+    }
+
+    void Pipeline::StageWriter::processInternal(const TrackBank &input)
+    {
+        //back-pressure: wait for the next stage to free a slot
+        TrackBank *slot;
+        int nTries = 0;
+        while (!(slot = ring_->getWriteSlot()))
+        {
+            if (stop_->load(std::memory_order_relaxed))
+                return;
+            backOff(nTries);
+        }
+        *slot = input;
+        ring_->commitWrite();
+    }
+
+    void Pipeline::StageWriter::resetInternal(){}
+
+    Pipeline::Pipeline(int queueLength) :
+        queueLength_(queueLength < 1 ? 1 : queueLength),
+        stop_(false)
+    {}
+
+    Pipeline::~Pipeline()
+    {
+        stop();
+    }
+
+    bool Pipeline::initialize(const vector<Module*> &modules, int modulesPerStage)
+    {
+        stop();
+
+        int nModules = (int)modules.size();
+        if ((nModules == 0) || (modulesPerStage < 1))
+        {
+            LOUDNESS_ERROR("Pipeline: Invalid number of modules per stage.");
+            return 0;
+        }
+
+        //cut the chain into stages
+        int nStages = (nModules + modulesPerStage - 1) / modulesPerStage;
+        stages_.resize(nStages);
+        for (int s = 0; s < nStages; s++)
+        {
+            int first = s * modulesPerStage;
+            int last = std::min(first + modulesPerStage, nModules) - 1;
+            Stage &stage = stages_[s];
+            stage.first = modules[first];
+            stage.last = modules[last];
+            stage.next = last + 1 < nModules ? modules[last + 1] : nullptr;
+
+            if (stage.next)
+            {
+                stage.ring.reset(new SPSCRing<TrackBank>(queueLength_));
+                stage.writer.reset(new StageWriter(stage.ring.get(), &stop_));
+                stage.writer->initialize(*stage.last->getOutput());
+                stage.last->setTargetModule(stage.writer.get());
+            }
+        }
+
+        stop_.store(false);
+        for (int s = 1; s < nStages; s++)
+            threads_.push_back(std::thread(&Pipeline::stageLoop, this, s));
+
+        LOUDNESS_DEBUG("Pipeline: Started " << nStages << " stages.");
+        return 1;
+    }
+
+    void Pipeline::process(const TrackBank &input)
+    {
+        if (!stages_.empty())
+            stages_[0].first->process(input);
+    }
+
+    void Pipeline::flush()
+    {
+        //stages drain in order, so waiting on each ring in turn is sufficient
+        for (unsigned int s = 0; s + 1 < stages_.size(); s++)
+        {
+            int nTries = 0;
+            while (!stages_[s].ring->isEmpty())
+                backOff(nTries);
+        }
+    }
+
+    void Pipeline::reset()
+    {
+        flush();
+        for (unsigned int s = 0; s < stages_.size(); s++)
+            stages_[s].first->reset();
+    }
+
+    void Pipeline::stop()
+    {
+        if (stages_.empty())
+            return;
+
+        flush();
+        stop_.store(true);
+        for (unsigned int i = 0; i < threads_.size(); i++)
+            threads_[i].join();
+        threads_.clear();
+
+        //restore the original chain
+        for (unsigned int s = 0; s < stages_.size(); s++)
+        {
+            if (stages_[s].next)
+                stages_[s].last->setTargetModule(stages_[s].next);
+        }
+        stages_.clear();
+    }
+
+    int Pipeline::getNStages() const
+    {
+        return (int)stages_.size();
+    }
+
+    void Pipeline::stageLoop(int s)
+    {
+        SPSCRing<TrackBank> *input = stages_[s - 1].ring.get();
+        Module *first = stages_[s].first;
+        int nTries = 0;
+        while (!stop_.load(std::memory_order_relaxed))
+        {
+            TrackBank *slot = input->getReadSlot();
+            if (slot)
+            {
+                first->process(*slot);
+                input->commitRead();
+                nTries = 0;
+            }
+            else
+                backOff(nTries);
+        }
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "Module.h"
+#include "SPSCRing.h"
+#include <thread>
+
+namespace loudness{
+
+    /**
+     * @class Pipeline
+     *
+     * @brief Runs a chain of initialised modules as a pipeline of stages,
+     * each stage on its own thread.
+     *
+     * The chain is cut into stages of @a modulesPerStage consecutive modules.
+     * The first stage runs on the thread calling process(); every other stage
+     * runs on a dedicated thread. Stages are connected by lock-free
+     * single-producer/single-consumer rings (SPSCRing) of TrackBanks: when the
+     * last module of a stage produces an output, a copy is pushed to the ring
+     * and the next stage processes it as soon as it is free. If a ring is full
+     * the producing stage waits (back-pressure), so no more than @a
+     * queueLength outputs are ever in flight between two stages.
+     *
+     * Because stages run asynchronously, the outputs of modules beyond the
+     * first stage are only consistent after flush(), which blocks until every
+     * queued TrackBank has been processed.
+     *
+     * @author Dominic Ward
+     *
+     * @sa Model::setPipelined()
+     */
+    class Pipeline
+    {
+    public:
+
+        Pipeline(int queueLength = 8);
+        ~Pipeline();
+
+        /**
+         * @brief Splits the chain of @a modules into stages and starts the
+         * stage threads.
+         *
+         * The modules must be initialised and connected via
+         * Module::setTargetModule(). The targets between stages are replaced
+         * and are restored by stop().
+         *
+         * @return true if the pipeline has been started, false otherwise.
+         */
+        bool initialize(const vector<Module*> &modules, int modulesPerStage);
+
+        /**
+         * @brief Processes @a input with the first stage and hands the
+         * result on to the next stage.
+         */
+        void process(const TrackBank &input);
+
+        /**
+         * @brief Blocks until all queued TrackBanks have been processed by
+         * every stage.
+         */
+        void flush();
+
+        /**
+         * @brief Flushes and resets all modules.
+         */
+        void reset();
+
+        /**
+         * @brief Flushes, stops the stage threads and restores the original
+         * chain.
+         */
+        void stop();
+
+        /**
+         * @brief Returns the number of stages.
+         */
+        int getNStages() const;
+
+    private:
+
+        /*
+         * Terminal module of a stage: copies its input into the ring
+         * feeding the next stage.
+         */
+        class StageWriter : public Module
+        {
+        public:
+            StageWriter(SPSCRing<TrackBank> *ring, const std::atomic<bool> *stop);
+        private:
+            virtual bool initializeInternal(const TrackBank &input);
+            virtual void processInternal(const TrackBank &input);
+            virtual void resetInternal();
+
+            SPSCRing<TrackBank> *ring_;
+            const std::atomic<bool> *stop_;
+        };
+
+        struct Stage
+        {
+            Module *first, *last, *next;
+            unique_ptr<SPSCRing<TrackBank> > ring; //ring feeding the next stage
+            unique_ptr<StageWriter> writer;
+        };
+
+        void stageLoop(int stage);
+
+        int queueLength_;
+        vector<Stage> stages_;
+        vector<std::thread> threads_;
+        std::atomic<bool> stop_;
+    };
+}
+
+#endif
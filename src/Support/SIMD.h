@@ -0,0 +1,406 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+/*
+ * Support for kernels compiled for more than one instruction set.
+ *
+ * The library is built for the baseline of the target architecture. A hot
+ * loop is written once as an always-inlined function and wrapped twice: once
+ * plainly and once with LOUDNESS_TARGET_AVX2, which makes the compiler
+ * generate AVX2/FMA code for the inlined copy. The caller picks the wrapper
+ * with cpuHasAVX2() at run time. On other compilers or architectures only
+ * the plain wrapper is used.
+ *
+ * Kernels which the compiler cannot vectorise by itself (e.g. because of
+ * square roots, selects or reductions) are instead written as templates
+ * over one of the operation sets in namespace simd: Scalar<T>, SSE2<T> and
+ * AVX2<T>, for T float or double. Each provides a vector type Vec of size
+ * lanes, a mask type Mask and the same static functions, so one kernel
+ * body serves every instruction set. Loads and stores are unaligned.
+ * Vectorised elementary functions built on these are in SIMDMath.h.
+ *
+ * Such kernels pass AVX types by value in code compiled for the baseline,
+ * for which GCC warns about the ABI (-Wpsabi). The AVX2 operation set and
+ * every kernel template are therefore enclosed in LOUDNESS_SIMD_BEGIN and
+ * LOUDNESS_SIMD_END, which silence the warning for that code only. Templates
+ * instantiated at the end of a source file are diagnosed there, so a source
+ * file whose kernels call those of SIMDMath.h leaves its region open.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LOUDNESS_X86_DISPATCH 1
+#define LOUDNESS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define LOUDNESS_ALWAYS_INLINE inline __attribute__((always_inline))
+#include <immintrin.h>
+#else
+#define LOUDNESS_X86_DISPATCH 0
+#define LOUDNESS_TARGET_AVX2
+#define LOUDNESS_ALWAYS_INLINE inline
+#endif
+
+#if LOUDNESS_X86_DISPATCH && !defined(__clang__)
+#define LOUDNESS_SIMD_BEGIN _Pragma("GCC diagnostic push") \
+    _Pragma("GCC diagnostic ignored \"-Wpsabi\"")
+#define LOUDNESS_SIMD_END _Pragma("GCC diagnostic pop")
+#else
+#define LOUDNESS_SIMD_BEGIN
+#define LOUDNESS_SIMD_END
+#endif
+
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+namespace loudness{
+namespace simd{
+
+    template<class T>
+    struct Scalar
+    {
+        typedef T Type;
+        typedef T Vec;
+        typedef bool Mask;
+        static const int size = 1;
+
+        static LOUDNESS_ALWAYS_INLINE Vec load(const T *p) { return *p; }
+        static LOUDNESS_ALWAYS_INLINE void store(T *p, Vec a) { *p = a; }
+        static LOUDNESS_ALWAYS_INLINE Vec set1(T a) { return a; }
+        static LOUDNESS_ALWAYS_INLINE Vec add(Vec a, Vec b) { return a + b; }
+        static LOUDNESS_ALWAYS_INLINE Vec sub(Vec a, Vec b) { return a - b; }
+        static LOUDNESS_ALWAYS_INLINE Vec mul(Vec a, Vec b) { return a * b; }
+        static LOUDNESS_ALWAYS_INLINE Vec div(Vec a, Vec b) { return a / b; }
+        static LOUDNESS_ALWAYS_INLINE Vec sqrt(Vec a) { return std::sqrt(a); }
+        static LOUDNESS_ALWAYS_INLINE Vec min(Vec a, Vec b) { return b < a ? b : a; }
+        static LOUDNESS_ALWAYS_INLINE Vec max(Vec a, Vec b) { return a < b ? b : a; }
+        static LOUDNESS_ALWAYS_INLINE Mask gt(Vec a, Vec b) { return a > b; }
+        static LOUDNESS_ALWAYS_INLINE Mask eq(Vec a, Vec b) { return a == b; }
+        //m ? a : b
+        static LOUDNESS_ALWAYS_INLINE Vec select(Mask m, Vec a, Vec b) { return m ? a : b; }
+        static LOUDNESS_ALWAYS_INLINE T sum(Vec a) { return a; }
+        //2^n for integral n within the normal exponent range
+        static LOUDNESS_ALWAYS_INLINE Vec exp2i(Vec n) { return exp2iBits(n); }
+        //for positive normal a: the unbiased exponent and a scaled to [1, 2)
+        static LOUDNESS_ALWAYS_INLINE Vec exponent(Vec a) { return exponentBits(a); }
+        static LOUDNESS_ALWAYS_INLINE Vec mantissa(Vec a) { return mantissaBits(a); }
+
+    private:
+        static LOUDNESS_ALWAYS_INLINE double exp2iBits(double n)
+        {
+            //n + 1023 ends up in the low mantissa bits, shift to the exponent
+            double t = n + 6755399441055744.0 + 1023.0;
+            uint64_t bits;
+            memcpy(&bits, &t, sizeof(bits));
+            bits <<= 52;
+            memcpy(&t, &bits, sizeof(bits));
+            return t;
+        }
+        static LOUDNESS_ALWAYS_INLINE float exp2iBits(float n)
+        {
+            float t = n + 12582912.0f + 127.0f;
+            uint32_t bits;
+            memcpy(&bits, &t, sizeof(bits));
+            bits <<= 23;
+            memcpy(&t, &bits, sizeof(bits));
+            return t;
+        }
+        static LOUDNESS_ALWAYS_INLINE double exponentBits(double a)
+        {
+            uint64_t bits;
+            memcpy(&bits, &a, sizeof(bits));
+            return (double)(int)(bits >> 52) - 1023.0;
+        }
+        static LOUDNESS_ALWAYS_INLINE float exponentBits(float a)
+        {
+            uint32_t bits;
+            memcpy(&bits, &a, sizeof(bits));
+            return (float)(int)(bits >> 23) - 127.0f;
+        }
+        static LOUDNESS_ALWAYS_INLINE double mantissaBits(double a)
+        {
+            uint64_t bits;
+            memcpy(&bits, &a, sizeof(bits));
+            bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+            memcpy(&a, &bits, sizeof(bits));
+            return a;
+        }
+        static LOUDNESS_ALWAYS_INLINE float mantissaBits(float a)
+        {
+            uint32_t bits;
+            memcpy(&bits, &a, sizeof(bits));
+            bits = (bits & 0x007FFFFFU) | 0x3F800000U;
+            memcpy(&a, &bits, sizeof(bits));
+            return a;
+        }
+    };
+
+#ifdef __SSE2__
+    template<class T>
+    struct SSE2;
+
+    template<>
+    struct SSE2<double>
+    {
+        typedef double Type;
+        typedef __m128d Vec;
+        typedef __m128d Mask;
+        static const int size = 2;
+
+        static LOUDNESS_ALWAYS_INLINE Vec load(const double *p) { return _mm_loadu_pd(p); }
+        static LOUDNESS_ALWAYS_INLINE void store(double *p, Vec a) { _mm_storeu_pd(p, a); }
+        static LOUDNESS_ALWAYS_INLINE Vec set1(double a) { return _mm_set1_pd(a); }
+        static LOUDNESS_ALWAYS_INLINE Vec add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec sub(Vec a, Vec b) { return _mm_sub_pd(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec mul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec div(Vec a, Vec b) { return _mm_div_pd(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec sqrt(Vec a) { return _mm_sqrt_pd(a); }
+        static LOUDNESS_ALWAYS_INLINE Vec min(Vec a, Vec b) { return _mm_min_pd(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec max(Vec a, Vec b) { return _mm_max_pd(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Mask gt(Vec a, Vec b) { return _mm_cmpgt_pd(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Mask eq(Vec a, Vec b) { return _mm_cmpeq_pd(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec select(Mask m, Vec a, Vec b)
+        {
+            return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b));
+        }
+        static LOUDNESS_ALWAYS_INLINE double sum(Vec a)
+        {
+            return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+        }
+        static LOUDNESS_ALWAYS_INLINE Vec exp2i(Vec n)
+        {
+            __m128d t = _mm_add_pd(n, _mm_set1_pd(6755399441055744.0 + 1023.0));
+            return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(t), 52));
+        }
+        static LOUDNESS_ALWAYS_INLINE Vec exponent(Vec a)
+        {
+            //the biased exponent as the low bits of 2^52
+            __m128i e = _mm_srli_epi64(_mm_castpd_si128(a), 52);
+            e = _mm_or_si128(e, _mm_castpd_si128(_mm_set1_pd(4503599627370496.0)));
+            return _mm_sub_pd(_mm_castsi128_pd(e), _mm_set1_pd(4503599627370496.0 + 1023.0));
+        }
+        static LOUDNESS_ALWAYS_INLINE Vec mantissa(Vec a)
+        {
+            __m128i m = _mm_and_si128(_mm_castpd_si128(a), _mm_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+            return _mm_castsi128_pd(_mm_or_si128(m, _mm_castpd_si128(_mm_set1_pd(1.0))));
+        }
+    };
+
+    template<>
+    struct SSE2<float>
+    {
+        typedef float Type;
+        typedef __m128 Vec;
+        typedef __m128 Mask;
+        static const int size = 4;
+
+        static LOUDNESS_ALWAYS_INLINE Vec load(const float *p) { return _mm_loadu_ps(p); }
+        static LOUDNESS_ALWAYS_INLINE void store(float *p, Vec a) { _mm_storeu_ps(p, a); }
+        static LOUDNESS_ALWAYS_INLINE Vec set1(float a) { return _mm_set1_ps(a); }
+        static LOUDNESS_ALWAYS_INLINE Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec sqrt(Vec a) { return _mm_sqrt_ps(a); }
+        static LOUDNESS_ALWAYS_INLINE Vec min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Mask gt(Vec a, Vec b) { return _mm_cmpgt_ps(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Mask eq(Vec a, Vec b) { return _mm_cmpeq_ps(a, b); }
+        static LOUDNESS_ALWAYS_INLINE Vec select(Mask m, Vec a, Vec b)
+        {
+            return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+        }
+        static LOUDNESS_ALWAYS_INLINE float sum(Vec a)
+        {
+            a = _mm_add_ps(a, _mm_movehl_ps(a, a));
+            return _mm_cvtss_f32(_mm_add_ss(a, _mm_shuffle_ps(a, a, 1)));
+        }
+        static LOUDNESS_ALWAYS_INLINE Vec exp2i(Vec n)
+        {
+            __m128 t = _mm_add_ps(n, _mm_set1_ps(12582912.0f + 127.0f));
+            return _mm_castsi128_ps(_mm_slli_epi32(_mm_castps_si128(t), 23));
+        }
+        static LOUDNESS_ALWAYS_INLINE Vec exponent(Vec a)
+        {
+            __m128i e = _mm_srli_epi32(_mm_castps_si128(a), 23);
+            e = _mm_or_si128(e, _mm_castps_si128(_mm_set1_ps(8388608.0f)));
+            return _mm_sub_ps(_mm_castsi128_ps(e), _mm_set1_ps(8388608.0f + 127.0f));
+        }
+        static LOUDNESS_ALWAYS_INLINE Vec mantissa(Vec a)
+        {
+            __m128i m = _mm_and_si128(_mm_castps_si128(a), _mm_set1_epi32(0x007FFFFF));
+            return _mm_castsi128_ps(_mm_or_si128(m, _mm_castps_si128(_mm_set1_ps(1.0f))));
+        }
+    };
+#endif
+
+    /*
+     * The widest operation set available without run-time dispatch.
+     */
+#ifdef __SSE2__
+    template<class T>
+    struct Baseline : public SSE2<T> {};
+#else
+    template<class T>
+    struct Baseline : public Scalar<T> {};
+#endif
+
+LOUDNESS_SIMD_BEGIN
+#if LOUDNESS_X86_DISPATCH
+    /*
+     * Only usable from functions compiled with LOUDNESS_TARGET_AVX2. The
+     * functions are not forced inline, so that a kernel template (itself
+     * compiled for the baseline) can be instantiated with them. They are
+     * inlined once the kernel is inlined into the AVX2 wrapper, so kernels
+     * used with AVX2 must be LOUDNESS_ALWAYS_INLINE and must only be called
+     * from such a wrapper.
+     */
+    template<class T>
+    struct AVX2;
+
+    template<>
+    struct AVX2<double>
+    {
+        typedef double Type;
+        typedef __m256d Vec;
+        typedef __m256d Mask;
+        static const int size = 4;
+
+        LOUDNESS_TARGET_AVX2 static inline Vec load(const double *p) { return _mm256_loadu_pd(p); }
+        LOUDNESS_TARGET_AVX2 static inline void store(double *p, Vec a) { _mm256_storeu_pd(p, a); }
+        LOUDNESS_TARGET_AVX2 static inline Vec set1(double a) { return _mm256_set1_pd(a); }
+        LOUDNESS_TARGET_AVX2 static inline Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Vec mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Vec div(Vec a, Vec b) { return _mm256_div_pd(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Vec sqrt(Vec a) { return _mm256_sqrt_pd(a); }
+        LOUDNESS_TARGET_AVX2 static inline Vec min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Vec max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Mask gt(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+        LOUDNESS_TARGET_AVX2 static inline Mask eq(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+        LOUDNESS_TARGET_AVX2 static inline Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_pd(b, a, m); }
+        LOUDNESS_TARGET_AVX2 static inline double sum(Vec a)
+        {
+            __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+        LOUDNESS_TARGET_AVX2 static inline Vec exp2i(Vec n)
+        {
+            __m256d t = _mm256_add_pd(n, _mm256_set1_pd(6755399441055744.0 + 1023.0));
+            return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(t), 52));
+        }
+        LOUDNESS_TARGET_AVX2 static inline Vec exponent(Vec a)
+        {
+            __m256i e = _mm256_srli_epi64(_mm256_castpd_si256(a), 52);
+            e = _mm256_or_si256(e, _mm256_castpd_si256(_mm256_set1_pd(4503599627370496.0)));
+            return _mm256_sub_pd(_mm256_castsi256_pd(e), _mm256_set1_pd(4503599627370496.0 + 1023.0));
+        }
+        LOUDNESS_TARGET_AVX2 static inline Vec mantissa(Vec a)
+        {
+            __m256i m = _mm256_and_si256(_mm256_castpd_si256(a), _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+            return _mm256_castsi256_pd(_mm256_or_si256(m, _mm256_castpd_si256(_mm256_set1_pd(1.0))));
+        }
+    };
+
+    template<>
+    struct AVX2<float>
+    {
+        typedef float Type;
+        typedef __m256 Vec;
+        typedef __m256 Mask;
+        static const int size = 8;
+
+        LOUDNESS_TARGET_AVX2 static inline Vec load(const float *p) { return _mm256_loadu_ps(p); }
+        LOUDNESS_TARGET_AVX2 static inline void store(float *p, Vec a) { _mm256_storeu_ps(p, a); }
+        LOUDNESS_TARGET_AVX2 static inline Vec set1(float a) { return _mm256_set1_ps(a); }
+        LOUDNESS_TARGET_AVX2 static inline Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Vec sqrt(Vec a) { return _mm256_sqrt_ps(a); }
+        LOUDNESS_TARGET_AVX2 static inline Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+        LOUDNESS_TARGET_AVX2 static inline Mask gt(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        LOUDNESS_TARGET_AVX2 static inline Mask eq(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+        LOUDNESS_TARGET_AVX2 static inline Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_ps(b, a, m); }
+        LOUDNESS_TARGET_AVX2 static inline float sum(Vec a)
+        {
+            __m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+            s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+            return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+        LOUDNESS_TARGET_AVX2 static inline Vec exp2i(Vec n)
+        {
+            __m256 t = _mm256_add_ps(n, _mm256_set1_ps(12582912.0f + 127.0f));
+            return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_castps_si256(t), 23));
+        }
+        LOUDNESS_TARGET_AVX2 static inline Vec exponent(Vec a)
+        {
+            __m256i e = _mm256_srli_epi32(_mm256_castps_si256(a), 23);
+            e = _mm256_or_si256(e, _mm256_castps_si256(_mm256_set1_ps(8388608.0f)));
+            return _mm256_sub_ps(_mm256_castsi256_ps(e), _mm256_set1_ps(8388608.0f + 127.0f));
+        }
+        LOUDNESS_TARGET_AVX2 static inline Vec mantissa(Vec a)
+        {
+            __m256i m = _mm256_and_si256(_mm256_castps_si256(a), _mm256_set1_epi32(0x007FFFFF));
+            return _mm256_castsi256_ps(_mm256_or_si256(m, _mm256_castps_si256(_mm256_set1_ps(1.0f))));
+        }
+    };
+#endif
+
+    /*
+     * Dot product of a and b over n elements, accumulated in two vectors.
+     */
+    template<class Ops>
+    LOUDNESS_ALWAYS_INLINE typename Ops::Type dot(const typename Ops::Type *a,
+            const typename Ops::Type *b, int n)
+    {
+        typedef typename Ops::Vec Vec;
+        Vec acc0 = Ops::set1(0), acc1 = acc0;
+        int j = 0;
+        for(; j + 2 * Ops::size <= n; j += 2 * Ops::size)
+        {
+            acc0 = Ops::add(acc0, Ops::mul(Ops::load(a + j), Ops::load(b + j)));
+            acc1 = Ops::add(acc1, Ops::mul(Ops::load(a + j + Ops::size),
+                        Ops::load(b + j + Ops::size)));
+        }
+        typename Ops::Type sum = Ops::sum(Ops::add(acc0, acc1));
+        for(; j < n; j++)
+            sum += a[j] * b[j];
+        return sum;
+    }
+LOUDNESS_SIMD_END
+}
+
+    /**
+     * @brief Returns true if the processor supports AVX2 and FMA.
+     */
+    inline bool cpuHasAVX2()
+    {
+#if LOUDNESS_X86_DISPATCH
+        static const bool hasAVX2 = __builtin_cpu_supports("avx2")
+            && __builtin_cpu_supports("fma");
+        return hasAVX2;
+#else
+        return false;
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SIMDMath.h"
+
+namespace loudness{
+
+    /*
+     * The simd:: functions called by the kernels below are instantiated at
+     * the end of this file, where the ABI warning for them is reported, so
+     * the region is left open to the end of the file.
+     */
+LOUDNESS_SIMD_BEGIN
+    /*
+     * One functor per function, applied by the array kernels below with
+     * the vector operation set for whole vectors and Scalar for the rest.
+     */
+    struct ExpFunction
+    {
+        template<class Ops>
+        static LOUDNESS_ALWAYS_INLINE typename Ops::Vec apply(
+                typename Ops::Vec x, typename Ops::Vec)
+        {
+            return simd::vexp<Ops>(x);
+        }
+    };
+
+    struct LogFunction
+    {
+        template<class Ops>
+        static LOUDNESS_ALWAYS_INLINE typename Ops::Vec apply(
+                typename Ops::Vec x, typename Ops::Vec)
+        {
+            return simd::vlog<Ops>(x);
+        }
+    };
+
+    struct Log10Function
+    {
+        template<class Ops>
+        static LOUDNESS_ALWAYS_INLINE typename Ops::Vec apply(
+                typename Ops::Vec x, typename Ops::Vec)
+        {
+            return simd::vlog10<Ops>(x);
+        }
+    };
+
+    struct PowFunction
+    {
+        template<class Ops>
+        static LOUDNESS_ALWAYS_INLINE typename Ops::Vec apply(
+                typename Ops::Vec x, typename Ops::Vec exponent)
+        {
+            return simd::vpow<Ops>(x, exponent);
+        }
+    };
+
+    //y = f(x, a) with a constant second argument
+    template<class Ops, class F>
+    static LOUDNESS_ALWAYS_INLINE void applyArray(const Real *x, Real a,
+            Real *y, int n)
+    {
+        typedef simd::Scalar<Real> S;
+        const typename Ops::Vec va = Ops::set1(a);
+        int i = 0;
+        for(; i + Ops::size <= n; i += Ops::size)
+            Ops::store(y + i, F::template apply<Ops>(Ops::load(x + i), va));
+        for(; i < n; i++)
+            y[i] = F::template apply<S>(x[i], a);
+    }
+
+    //y = f(x, a) with a second argument per element
+    template<class Ops, class F>
+    static LOUDNESS_ALWAYS_INLINE void applyArray(const Real *x, const Real *a,
+            Real *y, int n)
+    {
+        typedef simd::Scalar<Real> S;
+        int i = 0;
+        for(; i + Ops::size <= n; i += Ops::size)
+            Ops::store(y + i, F::template apply<Ops>(Ops::load(x + i),
+                        Ops::load(a + i)));
+        for(; i < n; i++)
+            y[i] = F::template apply<S>(x[i], a[i]);
+    }
+
+    template<class F, class A>
+    static void applyArrayDefault(const Real *x, A a, Real *y, int n)
+    {
+        applyArray<simd::Baseline<Real>, F>(x, a, y, n);
+    }
+
+#if LOUDNESS_X86_DISPATCH
+    template<class F, class A>
+    LOUDNESS_TARGET_AVX2 static void applyArrayAVX2(const Real *x, A a,
+            Real *y, int n)
+    {
+        applyArray<simd::AVX2<Real>, F>(x, a, y, n);
+    }
+#endif
+
+    template<class F, class A>
+    static void dispatchArray(const Real *x, A a, Real *y, int n)
+    {
+#if LOUDNESS_X86_DISPATCH
+        if(cpuHasAVX2())
+            applyArrayAVX2<F, A>(x, a, y, n);
+        else
+#endif
+            applyArrayDefault<F, A>(x, a, y, n);
+    }
+
+    void ExpArray(const Real *x, Real *y, int n)
+    {
+        dispatchArray<ExpFunction, Real>(x, 0, y, n);
+    }
+
+    void LogArray(const Real *x, Real *y, int n)
+    {
+        dispatchArray<LogFunction, Real>(x, 0, y, n);
+    }
+
+    void Log10Array(const Real *x, Real *y, int n)
+    {
+        dispatchArray<Log10Function, Real>(x, 0, y, n);
+    }
+
+    void PowArray(const Real *x, Real exponent, Real *y, int n)
+    {
+        dispatchArray<PowFunction, Real>(x, exponent, y, n);
+    }
+
+    void PowArray(const Real *x, const Real *exponent, Real *y, int n)
+    {
+        dispatchArray<PowFunction, const Real*>(x, exponent, y, n);
+    }
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIMDMATH_H
+#define SIMDMATH_H
+
+#include "Common.h"
+#include "SIMD.h"
+
+/*
+ * Elementary functions over the operation sets of SIMD.h. They are
+ * branch-free, so they work lane by lane on any Ops, and follow the same
+ * inlining rules as the kernels that use them. Error bounds are relative to
+ * the exact result and were measured against long double libm over the
+ * stated domain.
+ *
+ * ExpArray() and friends apply them to whole arrays, using AVX2 when the
+ * processor supports it. Input and output may be the same array.
+ */
+namespace loudness{
+namespace simd{
+LOUDNESS_SIMD_BEGIN
+
+    //1/k!, the Taylor coefficients of exp
+    static const double expTaylor[13] = {
+        1.0, 1.0, 1.0/2, 1.0/6, 1.0/24, 1.0/120, 1.0/720, 1.0/5040,
+        1.0/40320, 1.0/362880, 1.0/3628800, 1.0/39916800, 1.0/479001600
+    };
+
+    /*
+     * exp(x). Relative error below 5e-16 for double x in [-708, 709] and
+     * 2e-7 for float x in [-87, 88]. Arguments outside this domain are
+     * clamped to it, so the result never becomes denormal or infinite.
+     *
+     * x is split as n*ln(2) + r with integral n and |r| <= ln(2)/2, exp(r) is
+     * a Taylor polynomial (degree 12 for double, 7 for float) and 2^n is
+     * built directly in the exponent bits.
+     */
+    template<class Ops>
+    LOUDNESS_ALWAYS_INLINE typename Ops::Vec vexp(typename Ops::Vec x)
+    {
+        typedef typename Ops::Type T;
+        typedef typename Ops::Vec Vec;
+        const bool isDouble = sizeof(T) == sizeof(double);
+
+        x = Ops::max(Ops::min(x, Ops::set1(isDouble ? 709.0 : 88.0)),
+                Ops::set1(isDouble ? -708.0 : -87.0));
+
+        //round to nearest by adding and removing 1.5*2^(mantissa bits)
+        const Vec magic = Ops::set1(isDouble ? 6755399441055744.0 : 12582912.0);
+        Vec n = Ops::sub(Ops::add(Ops::mul(x, Ops::set1(1.4426950408889634)),
+                    magic), magic);
+
+        //ln(2) in two parts, the first exact when multiplied by n
+        Vec r = Ops::sub(x, Ops::mul(n,
+                    Ops::set1(isDouble ? 6.93145751953125e-1 : 0.693359375)));
+        r = Ops::sub(r, Ops::mul(n,
+                    Ops::set1(isDouble ? 1.42860682030941723212e-6 : -2.12194440e-4)));
+
+        const int degree = isDouble ? 12 : 7;
+        Vec p = Ops::set1(T(expTaylor[degree]));
+        for(int k=degree-1; k>=0; k--)
+            p = Ops::add(Ops::mul(p, r), Ops::set1(T(expTaylor[k])));
+
+        return Ops::mul(p, Ops::exp2i(n));
+    }
+
+    //1/(2k+1), the series of atanh(f)/f in f^2
+    static const double atanhSeries[11] = {
+        1.0, 1.0/3, 1.0/5, 1.0/7, 1.0/9, 1.0/11, 1.0/13, 1.0/15, 1.0/17,
+        1.0/19, 1.0/21
+    };
+
+    /*
+     * Natural logarithm of positive normal x. Relative error below 4e-16
+     * for double and 2.5e-7 for float (absolute error below 5e-17 and 2e-8
+     * around x = 1). Zero gives the logarithm of the smallest power of two
+     * (about -709.1 for double, -88.0 for float) rather than -infinity.
+     *
+     * x is split as m*2^e with m in [sqrt(1/2), sqrt(2)). Then
+     * log(m) = 2*atanh(f) with f = (m-1)/(m+1), |f| < 0.172, whose series in
+     * f^2 is truncated after 11 terms for double and 5 for float.
+     */
+    template<class Ops>
+    LOUDNESS_ALWAYS_INLINE typename Ops::Vec vlog(typename Ops::Vec x)
+    {
+        typedef typename Ops::Type T;
+        typedef typename Ops::Vec Vec;
+        const bool isDouble = sizeof(T) == sizeof(double);
+        const Vec one = Ops::set1(1.0);
+
+        Vec e = Ops::exponent(x);
+        Vec m = Ops::mantissa(x);
+        typename Ops::Mask high = Ops::gt(m, Ops::set1(1.4142135623730951));
+        m = Ops::select(high, Ops::mul(m, Ops::set1(0.5)), m);
+        e = Ops::select(high, Ops::add(e, one), e);
+
+        Vec f = Ops::div(Ops::sub(m, one), Ops::add(m, one));
+        Vec s = Ops::mul(f, f);
+        const int nTerms = isDouble ? 11 : 5;
+        Vec p = Ops::set1(T(atanhSeries[nTerms - 1]));
+        for(int k=nTerms-2; k>=0; k--)
+            p = Ops::add(Ops::mul(p, s), Ops::set1(T(atanhSeries[k])));
+        Vec logm = Ops::mul(Ops::add(f, f), p);
+
+        //ln(2) in two parts, the first exact when multiplied by e
+        logm = Ops::add(logm, Ops::mul(e,
+                    Ops::set1(isDouble ? 1.90821492927058770002e-10 : -2.12194440e-4)));
+        return Ops::add(logm, Ops::mul(e,
+                    Ops::set1(isDouble ? 6.93147180369123816490e-01 : 0.693359375)));
+    }
+
+    /*
+     * Base 10 logarithm of positive normal x, vlog(x)*log10(e). Relative
+     * error below 4e-16 for double and 2.5e-7 for float.
+     */
+    template<class Ops>
+    LOUDNESS_ALWAYS_INLINE typename Ops::Vec vlog10(typename Ops::Vec x)
+    {
+        return Ops::mul(vlog<Ops>(x), Ops::set1(0.43429448190325182765));
+    }
+
+    /*
+     * x^y as exp(y*log(x)) for x > 0, 0 for x <= 0. The rounding error of
+     * y*log(x) carries into the result, so the relative error is below
+     * 4e-16*(1 + |y*log(x)|) for double and 2e-7*(1 + |y*log(x)|) for float,
+     * as long as y*log(x) is within the domain of vexp.
+     */
+    template<class Ops>
+    LOUDNESS_ALWAYS_INLINE typename Ops::Vec vpow(typename Ops::Vec x,
+            typename Ops::Vec y)
+    {
+        const typename Ops::Vec zero = Ops::set1(0.0);
+        return Ops::select(Ops::gt(x, zero),
+                vexp<Ops>(Ops::mul(y, vlog<Ops>(x))), zero);
+    }
+LOUDNESS_SIMD_END
+}
+
+    /**
+     * @brief y[i] = exp(x[i]) for i in [0, n), see simd::vexp.
+     */
+    void ExpArray(const Real *x, Real *y, int n);
+
+    /**
+     * @brief y[i] = log(x[i]) for i in [0, n), see simd::vlog.
+     */
+    void LogArray(const Real *x, Real *y, int n);
+
+    /**
+     * @brief y[i] = log10(x[i]) for i in [0, n), see simd::vlog10.
+     */
+    void Log10Array(const Real *x, Real *y, int n);
+
+    /**
+     * @brief y[i] = pow(x[i], exponent) for i in [0, n), see simd::vpow.
+     */
+    void PowArray(const Real *x, Real exponent, Real *y, int n);
+
+    /**
+     * @brief y[i] = pow(x[i], exponent[i]) for i in [0, n), see simd::vpow.
+     */
+    void PowArray(const Real *x, const Real *exponent, Real *y, int n);
+}
+
+#endif
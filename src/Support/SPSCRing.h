@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include "Common.h"
+#include <atomic>
+
+namespace loudness{
+
+    /**
+     * @class SPSCRing
+     *
+     * @brief A lock-free single-producer/single-consumer ring of
+     * preallocated slots.
+     *
+     * Exactly one thread may write and exactly one (other) thread may read.
+     * Elements are not moved in or out of the ring. Instead, the producer
+     * obtains the next free slot with getWriteSlot(), fills it in place and
+     * publishes it with commitWrite(). The consumer obtains the oldest
+     * published slot with getReadSlot(), uses it in place and releases it
+     * with commitRead(). A slot remains owned by the consumer until
+     * commitRead() is called, so isEmpty() only returns true once every
+     * published element has been fully consumed.
+     *
+     * @author Dominic Ward
+     */
+    template <typename T>
+    class SPSCRing
+    {
+    public:
+
+        /**
+         * @brief Constructs a ring holding up to @a capacity elements.
+         */
+        SPSCRing(int capacity) :
+            slots_(capacity < 1 ? 1 : capacity),
+            head_(0),
+            tail_(0)
+        {}
+
+        /**
+         * @brief Returns a pointer to the next free slot, or a null pointer
+         * if the ring is full. Producer only.
+         */
+        T* getWriteSlot()
+        {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+                return nullptr;
+            return &slots_[tail % slots_.size()];
+        }
+
+        /**
+         * @brief Publishes the slot obtained from getWriteSlot(). Producer
+         * only.
+         */
+        void commitWrite()
+        {
+            tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+        }
+
+        /**
+         * @brief Returns a pointer to the oldest published slot, or a null
+         * pointer if the ring is empty. Consumer only.
+         */
+        T* getReadSlot()
+        {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire))
+                return nullptr;
+            return &slots_[head % slots_.size()];
+        }
+
+        /**
+         * @brief Releases the slot obtained from getReadSlot(). Consumer
+         * only.
+         */
+        void commitRead()
+        {
+            head_.store(head_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+        }
+
+        /**
+         * @brief Returns true if all published elements have been consumed.
+         */
+        bool isEmpty() const
+        {
+            return head_.load(std::memory_order_acquire) ==
+                tail_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Returns the number of slots.
+         */
+        int getCapacity() const
+        {
+            return (int)slots_.size();
+        }
+
+        /**
+         * @brief Returns a slot for in-place initialisation. Must not be
+         * called while either side of the ring is in use.
+         */
+        T& getSlot(int i)
+        {
+            return slots_[i];
+        }
+
+    private:
+
+        vector<T> slots_;
+        //padding keeps the producer and consumer indices on separate cache lines
+        char padding0_[LOUDNESS_ALIGNMENT];
+        std::atomic<std::size_t> head_;
+        char padding1_[LOUDNESS_ALIGNMENT];
+        std::atomic<std::size_t> tail_;
+    };
+}
+
+#endif
@@ -51,7 +51,7 @@ int band_matrix::dim() const {
 
 // defines the new operator (), so that we can access the elements
 // by A(i,j), index going from i=0,...,dim()-1
-double & band_matrix::operator () (int i, int j) {
+Real & band_matrix::operator () (int i, int j) {
    int k=j-i;       // what band is the entry
    assert( (i>=0) && (i<dim()) && (j>=0) && (j<dim()) );
    assert( (-num_lower()<=k) && (k<=num_upper()) );
@@ -59,7 +59,7 @@ double & band_matrix::operator () (int i, int j) {
    if(k>=0)   return m_upper[k][i];
    else	    return m_lower[-k][i];
 }
-double band_matrix::operator () (int i, int j) const {
+Real band_matrix::operator () (int i, int j) const {
    int k=j-i;       // what band is the entry
    assert( (i>=0) && (i<dim()) && (j>=0) && (j<dim()) );
    assert( (-num_lower()<=k) && (k<=num_upper()) );
@@ -68,11 +68,11 @@ double band_matrix::operator () (int i, int j) const {
    else	    return m_lower[-k][i];
 }
 // second diag (used in LU decomposition), saved in m_lower
-double band_matrix::saved_diag(int i) const {
+Real band_matrix::saved_diag(int i) const {
    assert( (i>=0) && (i<dim()) );
    return m_lower[0][i];
 }
-double & band_matrix::saved_diag(int i) {
+Real & band_matrix::saved_diag(int i) {
    assert( (i>=0) && (i<dim()) );
    return m_lower[0][i];
 }
@@ -81,7 +81,7 @@ double & band_matrix::saved_diag(int i) {
 void band_matrix::lu_decompose() {
    int  i_max,j_max;
    int  j_min;
-   double x;
+   Real x;
 
    // preconditioning
    // normalize column i so that a_ii=1
@@ -112,11 +112,11 @@ void band_matrix::lu_decompose() {
    }
 }
 // solves Ly=b
-std::vector<double> band_matrix::l_solve(const std::vector<double>& b) const {
+std::vector<Real> band_matrix::l_solve(const std::vector<Real>& b) const {
    assert( this->dim()==(int)b.size() );
-   std::vector<double> x(this->dim());
+   std::vector<Real> x(this->dim());
    int j_start;
-   double sum;
+   Real sum;
    for(int i=0; i<this->dim(); i++) {
       sum=0;
       j_start=std::max(0,i-this->num_lower());
@@ -126,11 +126,11 @@ std::vector<double> band_matrix::l_solve(const std::vector<double>& b) const {
    return x;
 }
 // solves Rx=y
-std::vector<double> band_matrix::r_solve(const std::vector<double>& b) const {
+std::vector<Real> band_matrix::r_solve(const std::vector<Real>& b) const {
    assert( this->dim()==(int)b.size() );
-   std::vector<double> x(this->dim());
+   std::vector<Real> x(this->dim());
    int j_stop;
-   double sum;
+   Real sum;
    for(int i=this->dim()-1; i>=0; i--) {
       sum=0;
       j_stop=std::min(this->dim()-1,i+this->num_upper());
@@ -140,10 +140,10 @@ std::vector<double> band_matrix::r_solve(const std::vector<double>& b) const {
    return x;
 }
 
-std::vector<double> band_matrix::lu_solve(const std::vector<double>& b,
+std::vector<Real> band_matrix::lu_solve(const std::vector<Real>& b,
       bool is_lu_decomposed) {
    assert( this->dim()==(int)b.size() );
-   std::vector<double>  x,y;
+   std::vector<Real>  x,y;
    if(is_lu_decomposed==false) {
       this->lu_decompose();
    }
@@ -159,8 +159,8 @@ std::vector<double> band_matrix::lu_solve(const std::vector<double>& b,
 // spline implementation
 // -----------------------
 
-void spline::set_points(const std::vector<double>& x,
-                          const std::vector<double>& y, bool cubic_spline) {
+void spline::set_points(const std::vector<Real>& x,
+                          const std::vector<Real>& y, bool cubic_spline) {
    assert(x.size()==y.size());
    m_x=x;
    m_y=y;
@@ -174,7 +174,7 @@ void spline::set_points(const std::vector<double>& x,
       // setting up the matrix and right hand side of the equation system
       // for the parameters b[]
       band_matrix A(n,1,1);
-      std::vector<double>  rhs(n);
+      std::vector<Real>  rhs(n);
       for(int i=1; i<n-1; i++) {
          A(i,i-1)=1.0/3.0*(x[i]-x[i-1]);
          A(i,i)=2.0/3.0*(x[i+1]-x[i-1]);
@@ -213,21 +213,21 @@ void spline::set_points(const std::vector<double>& x,
 
    // for the right boundary we define
    // f_{n-1}(x) = b*(x-x_{n-1})^2 + c*(x-x_{n-1}) + y_{n-1}
-   double h=x[n-1]-x[n-2];
+   Real h=x[n-1]-x[n-2];
    // m_b[n-1] is determined by the boundary condition
    m_a[n-1]=0.0;
    m_c[n-1]=3.0*m_a[n-2]*h*h+2.0*m_b[n-2]*h+m_c[n-2];   // = f'_{n-2}(x_{n-1})
 }
 
-double spline::operator() (double x) const {
+Real spline::operator() (Real x) const {
    size_t n=m_x.size();
    // find the closest point m_x[idx] < x, idx=0 even if x<m_x[0]
-   std::vector<double>::const_iterator it;
+   std::vector<Real>::const_iterator it;
    it=std::lower_bound(m_x.begin(),m_x.end(),x);
    int idx=std::max( int(it-m_x.begin())-1, 0);
 
-   double h=x-m_x[idx];
-   double interpol;
+   Real h=x-m_x[idx];
+   Real interpol;
    if(x<m_x[0]) {
       // extrapolation to the left
       interpol=((m_b[0])*h + m_c[0])*h + m_y[0];
@@ -241,8 +241,103 @@ double spline::operator() (double x) const {
    return interpol;
 }
 
+
+
+// fixed_knot_spline implementation
+// --------------------------------
+
+void fixed_knot_spline::set_knots(const std::vector<Real>& x) {
+   m_x=x;
+   m_n=x.size();
+   assert(m_n>=2);
+   m_h.resize(m_n-1);
+   m_inv_h.resize(m_n-1);
+   for(int i=0; i<m_n-1; i++) {
+      assert(x[i]<x[i+1]);
+      m_h[i]=x[i+1]-x[i];
+      m_inv_h[i]=1.0/m_h[i];
+   }
+
+   // same tridiagonal system as spline::set_points, with b[0]=b[n-1]=0,
+   // eliminated downwards (Thomas algorithm) for rows 1..n-2
+   m_lower.assign(m_n,0.0);
+   m_upper.assign(m_n,0.0);
+   m_inv_pivot.assign(m_n,0.0);
+   for(int i=1; i<m_n-1; i++) {
+      Real lower=1.0/3.0*m_h[i-1];
+      Real pivot=2.0/3.0*(m_h[i-1]+m_h[i]) - lower*m_upper[i-1];
+      m_lower[i]=lower;
+      m_inv_pivot[i]=1.0/pivot;
+      m_upper[i]=1.0/3.0*m_h[i]*m_inv_pivot[i];
+   }
+
+   m_slope.assign(m_n-1,0.0);
+   m_b.assign(m_n,0.0);
+   m_k.clear();
 }
 
+void fixed_knot_spline::set_queries(const std::vector<Real>& xq) {
+   assert(m_n>=2);
+   int nq=xq.size();
+   m_k.resize(nq);
+   m_wy0.resize(nq);
+   m_wy1.resize(nq);
+   m_wb0.resize(nq);
+   m_wb1.resize(nq);
 
+   for(int q=0; q<nq; q++) {
+      // closest knot x[idx] < xq, as in spline::operator()
+      std::vector<Real>::const_iterator it;
+      it=std::lower_bound(m_x.begin(),m_x.end(),xq[q]);
+      int idx=std::max( int(it-m_x.begin())-1, 0);
+      Real h=xq[q]-m_x[idx];
 
+      if(xq[q]>m_x[m_n-1]) {
+         // extrapolation to the right, f = c[n-1]*h + y[n-1] since b[n-1]=0
+         // and c[n-1] is the slope at x[n-1], written in terms of the
+         // last interval
+         int k=m_n-2;
+         Real d=m_h[k];
+         m_k[q]=k;
+         m_wy0[q]=-h*m_inv_h[k];
+         m_wy1[q]=1.0+h*m_inv_h[k];
+         m_wb0[q]=1.0/3.0*h*d;
+         m_wb1[q]=2.0/3.0*h*d;
+      } else {
+         // f = ((a*h + b)*h + c)*h + y with a and c in terms of y and b
+         int k=std::min(idx,m_n-2);
+         Real d=m_h[k];
+         Real h3=0.0;
+         if(xq[q]>=m_x[0])
+            h3=1.0/3.0*h*h*h*m_inv_h[k]; // no cubic term to the left
+         m_k[q]=k;
+         m_wy0[q]=1.0-h*m_inv_h[k];
+         m_wy1[q]=h*m_inv_h[k];
+         m_wb0[q]=h*h - 2.0/3.0*h*d - h3;
+         m_wb1[q]=h3 - 1.0/3.0*h*d;
+      }
+   }
+}
+
+void fixed_knot_spline::interpolate(const Real* y, Real* out, int out_stride) {
+   // forward elimination, then back substitution for b[]
+   for(int i=0; i<m_n-1; i++)
+      m_slope[i]=(y[i+1]-y[i])*m_inv_h[i];
+   Real prev=0.0;
+   for(int i=1; i<m_n-1; i++) {
+      prev=(m_slope[i]-m_slope[i-1] - m_lower[i]*prev)*m_inv_pivot[i];
+      m_b[i]=prev;
+   }
+   m_b[0]=m_b[m_n-1]=0.0;
+   for(int i=m_n-3; i>=1; i--)
+      m_b[i]-=m_upper[i]*m_b[i+1];
 
+   int nq=m_k.size();
+   for(int q=0; q<nq; q++) {
+      int k=m_k[q];
+      out[out_stride*q]=m_wy0[q]*y[k] + m_wy1[q]*y[k+1]
+                       + m_wb0[q]*m_b[k] + m_wb1[q]*m_b[k+1];
+   }
+}
+
+}
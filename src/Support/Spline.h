@@ -29,8 +29,8 @@ namespace loudness{
 // band matrix solver
 class band_matrix {
 private:
-   std::vector< std::vector<double> > m_upper;  // upper band
-   std::vector< std::vector<double> > m_lower;  // lower band
+   std::vector< std::vector<Real> > m_upper;  // upper band
+   std::vector< std::vector<Real> > m_lower;  // lower band
 public:
    band_matrix() {};                             // constructor
    band_matrix(int dim, int n_u, int n_l);       // constructor
@@ -44,15 +44,15 @@ public:
       return m_lower.size()-1;
    }
    // access operator
-   double & operator () (int i, int j);            // write
-   double   operator () (int i, int j) const;      // read
+   Real & operator () (int i, int j);            // write
+   Real   operator () (int i, int j) const;      // read
    // we can store an additional diogonal (in m_lower)
-   double& saved_diag(int i);
-   double  saved_diag(int i) const;
+   Real& saved_diag(int i);
+   Real  saved_diag(int i) const;
    void lu_decompose();
-   std::vector<double> r_solve(const std::vector<double>& b) const;
-   std::vector<double> l_solve(const std::vector<double>& b) const;
-   std::vector<double> lu_solve(const std::vector<double>& b,
+   std::vector<Real> r_solve(const std::vector<Real>& b) const;
+   std::vector<Real> l_solve(const std::vector<Real>& b) const;
+   std::vector<Real> lu_solve(const std::vector<Real>& b,
                                 bool is_lu_decomposed=false);
 
 };
@@ -62,16 +62,53 @@ public:
 class spline 
 {
 private:
-   std::vector<double> m_x,m_y;           // x,y coordinates of points
+   std::vector<Real> m_x,m_y;           // x,y coordinates of points
    // interpolation parameters
    // f(x) = a*(x-x_i)^3 + b*(x-x_i)^2 + c*(x-x_i) + y_i
-   std::vector<double> m_a,m_b,m_c,m_d;
+   std::vector<Real> m_a,m_b,m_c,m_d;
 public:
    spline(){};
    ~spline(){};
-   void set_points(const std::vector<double>& x,
-                   const std::vector<double>& y, bool cubic_spline=true);
-   double operator() (double x) const;
+   void set_points(const std::vector<Real>& x,
+                   const std::vector<Real>& y, bool cubic_spline=true);
+   Real operator() (Real x) const;
+};
+
+
+// cubic spline interpolation (zero curvature at both ends) with knots and
+// query points that are fixed in advance, for interpolating many sets of
+// y values. set_knots() factorises the equation system once and
+// set_queries() precomputes the interval and basis weights of each query
+// point, so interpolate() does an O(n) solve and a weighted sum per query,
+// without allocating memory. Results agree with spline to rounding error.
+class fixed_knot_spline
+{
+private:
+   int m_n;
+   std::vector<Real> m_x;
+   // knot spacing, its reciprocal and the factorised equation system
+   std::vector<Real> m_h,m_inv_h,m_lower,m_upper,m_inv_pivot;
+   // per query: first knot of the interval and the weights of
+   // y[k], y[k+1], b[k], b[k+1], where b[] are the curvature parameters
+   std::vector<int> m_k;
+   std::vector<Real> m_wy0,m_wy1,m_wb0,m_wb1;
+   // work space
+   std::vector<Real> m_slope,m_b;
+public:
+   fixed_knot_spline() : m_n(0) {};
+   ~fixed_knot_spline() {};
+   // x must be strictly increasing with at least two points
+   void set_knots(const std::vector<Real>& x);
+   // must be called after set_knots()
+   void set_queries(const std::vector<Real>& xq);
+   int num_knots() const {
+      return m_n;
+   }
+   int num_queries() const {
+      return m_k.size();
+   }
+   // y holds num_knots() values, out receives num_queries() values
+   void interpolate(const Real* y, Real* out, int out_stride=1);
 };
 
 }
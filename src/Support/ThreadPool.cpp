@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ThreadPool.h"
+
+namespace loudness{
+
+    ThreadPool::ThreadPool(int nThreads) :
+        nThreads_(nThreads < 1 ? 1 : nThreads),
+        func_(nullptr),
+        nTasks_(0),
+        nBusy_(0),
+        generation_(0),
+        nextTask_(0),
+        stop_(false)
+    {
+        for (int worker = 1; worker < nThreads_; worker++)
+            threads_.push_back(std::thread(&ThreadPool::workerLoop, this, worker));
+        LOUDNESS_DEBUG("ThreadPool: Started " << nThreads_ << " workers.");
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wakeCondition_.notify_all();
+        for (unsigned int i = 0; i < threads_.size(); i++)
+            threads_[i].join();
+    }
+
+    void ThreadPool::run(int nTasks, const TaskFunction &func)
+    {
+        if (nTasks <= 0)
+            return;
+
+        //no point waking the workers for a single task
+        if ((nThreads_ == 1) || (nTasks == 1))
+        {
+            for (int task = 0; task < nTasks; task++)
+                func(task, 0);
+            return;
+        }
+
+        std::lock_guard<std::mutex> runLock(runMutex_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            func_ = &func;
+            nTasks_ = nTasks;
+            nextTask_.store(0);
+            nBusy_ = nThreads_ - 1;
+            generation_++;
+        }
+        wakeCondition_.notify_all();
+
+        //the calling thread is worker 0
+        executeTasks(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        doneCondition_.wait(lock, [this]{ return nBusy_ == 0; });
+        func_ = nullptr;
+    }
+
+    int ThreadPool::getNThreads() const
+    {
+        return nThreads_;
+    }
+
+    void ThreadPool::workerLoop(int worker)
+    {
+        unsigned int seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wakeCondition_.wait(lock, [&]{ return stop_ || (generation_ != seen); });
+                if (stop_)
+                    return;
+                seen = generation_;
+            }
+
+            executeTasks(worker);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--nBusy_ == 0)
+                    doneCondition_.notify_one();
+            }
+        }
+    }
+
+    void ThreadPool::executeTasks(int worker)
+    {
+        int task;
+        while ((task = nextTask_.fetch_add(1)) < nTasks_)
+            (*func_)(task, worker);
+    }
+}
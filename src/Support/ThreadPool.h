@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014 Dominic Ward <contactdominicward@gmail.com>
+ *
+ * This file is part of Loudness
+ *
+ * Loudness is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Loudness is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Loudness.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "Common.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace loudness{
+
+    /**
+     * @class ThreadPool
+     *
+     * @brief A persistent pool of worker threads for data-parallel work.
+     *
+     * A pool of @a nThreads workers is created on construction. Worker 0 is
+     * the thread calling run(), so only nThreads - 1 background threads are
+     * spawned. The background threads sleep between calls to run().
+     *
+     * run() distributes @a nTasks independent tasks over the workers and
+     * returns once all tasks have completed. Each task is executed exactly
+     * once, and the index of the executing worker (0 to nThreads - 1) is
+     * passed along with the task index so that per-worker scratch memory can
+     * be used without locking. Concurrent calls to run() from different
+     * threads are serialised.
+     *
+     * @author Dominic Ward
+     *
+     * @sa Module::processTracks()
+     */
+    class ThreadPool
+    {
+    public:
+
+        typedef std::function<void(int task, int worker)> TaskFunction;
+
+        /**
+         * @brief Constructs a pool of @a nThreads workers (including the
+         * calling thread).
+         */
+        ThreadPool(int nThreads);
+        ~ThreadPool();
+
+        /**
+         * @brief Executes @a func for every task index in [0, nTasks) and
+         * blocks until all have completed.
+         */
+        void run(int nTasks, const TaskFunction &func);
+
+        /**
+         * @brief Returns the number of workers, including the calling
+         * thread.
+         */
+        int getNThreads() const;
+
+    private:
+
+        ThreadPool(const ThreadPool&);
+        ThreadPool& operator=(const ThreadPool&);
+
+        void workerLoop(int worker);
+        void executeTasks(int worker);
+
+        int nThreads_;
+        vector<std::thread> threads_;
+        std::mutex runMutex_, mutex_;
+        std::condition_variable wakeCondition_, doneCondition_;
+        const TaskFunction *func_;
+        int nTasks_, nBusy_;
+        unsigned int generation_;
+        std::atomic<int> nextTask_;
+        bool stop_;
+    };
+}
+
+#endif
@@ -18,6 +18,8 @@
  */
 
 #include "TrackBank.h"
+#include <stdlib.h>
+#include <string.h>
 
 namespace loudness{
 
@@ -27,12 +29,108 @@ namespace loudness{
         nChannels_ = 0;
         nSamples_ = 0;
         fs_ = 0;
+        trackStride_ = 0;
+        channelStride_ = 0;
+        bufferSize_ = 0;
+        layout_ = TRACK_MAJOR;
+        view_ = false;
         initialized_ = false;
         frameRate_ = 0;
+        data_ = 0;
+    }
+
+    TrackBank::TrackBank(const TrackBank &other)
+    {
+        data_ = 0;
+        bufferSize_ = 0;
+        view_ = false;
+        *this = other;
     }
 
     TrackBank::~TrackBank()
     {
+        if (!view_)
+            free(data_);
+    }
+
+    TrackBank& TrackBank::operator=(const TrackBank &other)
+    {
+        if (this != &other)
+        {
+            nTracks_ = other.nTracks_;
+            nChannels_ = other.nChannels_;
+            nSamples_ = other.nSamples_;
+            fs_ = other.fs_;
+            layout_ = other.layout_;
+            trig_ = other.trig_;
+            initialized_ = other.initialized_;
+            frameRate_ = other.frameRate_;
+            centreFreqs_ = other.centreFreqs_;
+            spatialPositions_ = other.spatialPositions_;
+            allocate();
+            if (other.view_)
+            {
+                //the view's tracks are spaced by its own stride
+                for (int track = 0; track < nTracks_; track++)
+                    memcpy(getTrackWritePointer(track),
+                           other.getTrackReadPointer(track),
+                           nChannels_ * nSamples_ * sizeof(Real));
+            }
+            else if (bufferSize_ > 0)
+                memcpy(data_, other.data_, bufferSize_ * sizeof(Real));
+        }
+        return *this;
+    }
+
+    void TrackBank::allocate()
+    {
+        if (view_)
+        {
+            data_ = 0;
+            bufferSize_ = 0;
+            view_ = false;
+        }
+
+        //Pad each track (or channel) so that it starts on an aligned boundary
+        const int align = LOUDNESS_ALIGNMENT / sizeof(Real);
+        int bufferSize;
+        if (layout_ == TRACK_MAJOR)
+        {
+            channelStride_ = nSamples_;
+            trackStride_ = ((nChannels_ * nSamples_ + align - 1) / align) * align;
+            bufferSize = nTracks_ * trackStride_;
+        }
+        else
+        {
+            trackStride_ = nSamples_;
+            channelStride_ = ((nTracks_ * nSamples_ + align - 1) / align) * align;
+            bufferSize = nChannels_ * channelStride_;
+        }
+
+        //reuse the existing buffer if the size is unchanged
+        if (data_ && (bufferSize == bufferSize_))
+        {
+            memset(data_, 0, bufferSize_ * sizeof(Real));
+            return;
+        }
+
+        free(data_);
+        data_ = 0;
+        bufferSize_ = bufferSize;
+        if (bufferSize_ > 0)
+        {
+            void *ptr = 0;
+            if (posix_memalign(&ptr, LOUDNESS_ALIGNMENT, bufferSize_ * sizeof(Real)))
+            {
+                LOUDNESS_ERROR("TrackBank: Failed to allocate "
+                        << bufferSize_ << " samples.");
+                bufferSize_ = 0;
+                initialized_ = false;
+                return;
+            }
+            data_ = static_cast<Real*>(ptr);
+            memset(data_, 0, bufferSize_ * sizeof(Real));
+        }
     }
 
     void TrackBank::initialize(int nTracks, int nChannels, int nSamples, int fs)
@@ -48,15 +146,10 @@ namespace loudness{
         initialized_ = true;
         centreFreqs_.assign(nChannels_, 0.0);
 
-        signal_.resize(nTracks_);
         spatialPositions_.resize(nTracks_);
         for (int track = 0; track < nTracks_; track++)
-        {
             spatialPositions_[track].resize(nChannels_);
-            signal_[track].resize(nChannels_);
-            for (int i=0; i<nChannels_; i++)
-                signal_[track][i].assign(nSamples_,0.0);
-        }
+        allocate();
     }
 
     void TrackBank::initialize(const TrackBank &input)
@@ -74,15 +167,10 @@ namespace loudness{
             centreFreqs_ = input.getCentreFreqs();
             trig_.assign(nTracks_, 1);
             
-            signal_.resize(nTracks_);
             spatialPositions_.resize(nTracks_);
             for (int track = 0; track < nTracks_; track++)
-            {
                 spatialPositions_[track].resize(nChannels_);
-                signal_[track].resize(nChannels_);
-                for (int i=0; i<nChannels_; i++)
-                    signal_[track][i].assign(nSamples_,0.0);
-            }
+            allocate();
         }
         else
         {
@@ -103,15 +191,10 @@ namespace loudness{
             initialized_ = true;
             centreFreqs_.assign(nChannels_, 0.0);
 
-            signal_.resize(nTracks_);
             spatialPositions_.resize(nTracks_);
             for (int track = 0; track < nTracks_; track++)
-            {
                 spatialPositions_[track].resize(nChannels_);
-                signal_[track].resize(nChannels_);
-                for (int i=0; i<nChannels_; i++)
-                    signal_[track][i].assign(nSamples_,0.0);
-            }
+            allocate();
         }
         else
         {
@@ -134,6 +217,62 @@ namespace loudness{
         */
     }
 
+    void TrackBank::setLayout(Layout layout)
+    {
+        if (layout == layout_)
+            return;
+
+        if (view_)
+        {
+            LOUDNESS_ERROR("TrackBank: Cannot change the layout of a view.");
+            return;
+        }
+
+        if (!initialized_ || bufferSize_ == 0)
+        {
+            layout_ = layout;
+            return;
+        }
+
+        TrackBank old(*this);
+        layout_ = layout;
+        allocate();
+        for (int track = 0; track < nTracks_; track++)
+        {
+            for (int chn = 0; chn < nChannels_; chn++)
+            {
+                memcpy(getSignalWritePointer(track, chn),
+                       old.getSignalReadPointer(track, chn),
+                       nSamples_ * sizeof(Real));
+            }
+        }
+    }
+
+    void TrackBank::setView(Real *data, int trackStride)
+    {
+        if (!initialized_ || (layout_ != TRACK_MAJOR)
+                || (trackStride < nChannels_ * nSamples_))
+        {
+            LOUDNESS_ERROR("TrackBank: A view requires an initialised "
+                    << "TRACK_MAJOR TrackBank and a track stride of at least "
+                    << nChannels_ * nSamples_ << " samples.");
+            return;
+        }
+
+        if (!view_)
+            free(data_);
+        data_ = data;
+        bufferSize_ = 0;
+        trackStride_ = trackStride;
+        channelStride_ = nSamples_;
+        view_ = true;
+    }
+
+    bool TrackBank::isView() const
+    {
+        return view_;
+    }
+
     void TrackBank::setFs(int fs)
     {
         fs_ = fs;
@@ -168,7 +307,11 @@ namespace loudness{
     void TrackBank::setSignal(int track, int channel, const RealVec &signal)
     {
         if(channel<nChannels_ && (int)signal.size()==nSamples_ && track < nTracks_)
-            signal_[track][channel] = signal;
+        {
+            Real *dst = getSignalWritePointer(track, channel);
+            for (int smp = 0; smp < nSamples_; smp++)
+                dst[smp] = signal[smp];
+        }
         else
         {
             LOUDNESS_ERROR("TrackBank: "
@@ -176,9 +319,10 @@ namespace loudness{
         }
     }
 
-    const RealVec &TrackBank::getSignal(int track, int channel) const
+    RealVec TrackBank::getSignal(int track, int channel) const
     {
-        return signal_[track][channel];
+        const Real *src = getSignalReadPointer(track, channel);
+        return RealVec(src, src + nSamples_);
     }
 
     const RealVec &TrackBank::getCentreFreqs() const
@@ -42,15 +42,46 @@ namespace loudness{
      * typically lower than the host rate.
      *
      * When used for a partial masking model.
+     *
+     * All samples are stored in a single contiguous buffer aligned to
+     * LOUDNESS_ALIGNMENT bytes. The sample at (track, channel, index) lives at
+     * offset track*getTrackStride() + channel*getChannelStride() + index. Two
+     * layouts are available (see setLayout()):
+     *
+     * 1. TRACK_MAJOR (default) - all channels of a track are adjacent, so a
+     * track can be streamed linearly. Each track starts on an aligned boundary.
+     * 2. CHANNEL_MAJOR - all tracks of a channel are adjacent, so a channel can
+     * be streamed linearly across tracks. Each channel starts on an aligned
+     * boundary.
+     *
+     * In both layouts the samples of a single channel are contiguous. Use the
+     * read/write pointer accessors in processing kernels to avoid per-sample
+     * index arithmetic.
+     *
+     * A TrackBank can also be a view of samples held elsewhere (see
+     * setView()), such as the ring buffer of a FrameGenerator, so a module
+     * can pass a frame on without copying it.
      * 
      * @author Dominic Ward
      */
     class TrackBank
     {
     public:
+
+        /**
+         * @brief Memory layout of the sample buffer.
+         */
+        enum Layout{
+            TRACK_MAJOR = 0 /**< Tracks are outermost, samples innermost. */,
+            CHANNEL_MAJOR = 1 /**< Channels are outermost, samples innermost. */
+        };
+
         TrackBank();
+        TrackBank(const TrackBank &other);
         ~TrackBank();
 
+        TrackBank& operator=(const TrackBank &other);
+
         /**
          * @brief Initialises the TrackBank with input arguments.
          *
@@ -78,6 +109,39 @@ namespace loudness{
          */
         void clear();
 
+        /**
+         * @brief Sets the memory layout of the sample buffer.
+         *
+         * If the TrackBank is already initialised, the samples are moved into
+         * a new buffer with the requested layout.
+         *
+         * @param layout TRACK_MAJOR or CHANNEL_MAJOR.
+         */
+        void setLayout(Layout layout);
+
+        /**
+         * @brief Makes the TrackBank a view of samples it does not own.
+         *
+         * The TrackBank must be initialised with the TRACK_MAJOR layout. Its
+         * own buffer is released, and track t then starts at @a data +
+         * t*@a trackStride, with channels nSamples apart. The shape and
+         * metadata are unchanged. The samples must remain valid while the
+         * view is in use, and writing to the view writes to them. Call again
+         * to move the view; initialize(), resize() and assignment from another
+         * TrackBank give the TrackBank its own buffer again. A copy of a view
+         * owns its samples.
+         *
+         * @param data Pointer to the first sample of the first track.
+         * @param trackStride Distance in samples between consecutive tracks,
+         * at least nChannels * nSamples.
+         */
+        void setView(Real *data, int trackStride);
+
+        /**
+         * @brief Returns true if the TrackBank is a view (see setView()).
+         */
+        bool isView() const;
+
         /*
          * setters
          */
@@ -132,12 +196,61 @@ namespace loudness{
          */
         inline void setSample(int track, int channel, int index, Real sample) 
         {
-            signal_[track][channel][index] = sample;
+            data_[track*trackStride_ + channel*channelStride_ + index] = sample;
         }
 
         inline void sumSample(int track, int channel, int index, Real sample)
         {
-            signal_[track][channel][index] += sample;
+            data_[track*trackStride_ + channel*channelStride_ + index] += sample;
+        }
+
+        /**
+         * @brief Returns a pointer for writing samples of a channel.
+         *
+         * The @a nSamples samples of the channel are contiguous from the
+         * returned address.
+         *
+         * @param track Track index.
+         * @param channel Channel index.
+         * @param index Sample index.
+         *
+         * @return Pointer to the sample.
+         */
+        inline Real* getSignalWritePointer(int track, int channel, int index = 0)
+        {
+            return data_ + track*trackStride_ + channel*channelStride_ + index;
+        }
+
+        /**
+         * @brief Returns a pointer to the first sample of a track.
+         *
+         * Channel c of the track starts at c*getChannelStride() from the
+         * returned address.
+         */
+        inline Real* getTrackWritePointer(int track)
+        {
+            return data_ + track*trackStride_;
+        }
+
+        /**
+         * @brief Returns a pointer to the first sample of a channel of the
+         * first track.
+         *
+         * Track t of the channel starts at t*getTrackStride() from the
+         * returned address.
+         */
+        inline Real* getChannelWritePointer(int channel)
+        {
+            return data_ + channel*channelStride_;
+        }
+
+        /**
+         * @brief Returns a pointer to the spatial positions of a track, one
+         * per channel.
+         */
+        inline Real* getSpatialPositionWritePointer(int track)
+        {
+            return &spatialPositions_[track][0];
         }
 
         /**
@@ -226,10 +339,70 @@ namespace loudness{
          */
         inline Real getSample(int track, int channel, int index) const
         {
-            return signal_[track][channel][index];
+            return data_[track*trackStride_ + channel*channelStride_ + index];
+        }
+
+        /**
+         * @brief Returns a read-only pointer to the samples of a channel.
+         *
+         * @sa getSignalWritePointer()
+         */
+        inline const Real* getSignalReadPointer(int track, int channel, int index = 0) const
+        {
+            return data_ + track*trackStride_ + channel*channelStride_ + index;
         }
 
-        const RealVec &getSignal(int track, int channel) const;
+        /**
+         * @brief Returns a read-only pointer to the first sample of a track.
+         *
+         * @sa getTrackWritePointer()
+         */
+        inline const Real* getTrackReadPointer(int track) const
+        {
+            return data_ + track*trackStride_;
+        }
+
+        /**
+         * @brief Returns a read-only pointer to the first sample of a channel
+         * of the first track.
+         *
+         * @sa getChannelWritePointer()
+         */
+        inline const Real* getChannelReadPointer(int channel) const
+        {
+            return data_ + channel*channelStride_;
+        }
+
+        /**
+         * @brief Returns the distance (in samples) between the first samples
+         * of two consecutive tracks.
+         */
+        inline int getTrackStride() const
+        {
+            return trackStride_;
+        }
+
+        /**
+         * @brief Returns the distance (in samples) between the first samples
+         * of two consecutive channels.
+         */
+        inline int getChannelStride() const
+        {
+            return channelStride_;
+        }
+
+        /**
+         * @brief Returns the memory layout of the sample buffer.
+         */
+        inline Layout getLayout() const
+        {
+            return layout_;
+        }
+
+        /**
+         * @brief Returns a copy of the samples of a channel.
+         */
+        RealVec getSignal(int track, int channel) const;
 
         /**
          * @brief Returns the centre frequency of a channel.
@@ -280,11 +453,21 @@ namespace loudness{
 
     private:
 
+        /**
+         * @brief Computes the strides for the current layout and (re)allocates
+         * a zeroed sample buffer. A view is detached first.
+         */
+        void allocate();
+
         int nTracks_, nChannels_, nSamples_, fs_;
-        BoolVec trig_;
+        int trackStride_, channelStride_, bufferSize_;
+        Layout layout_;
+        bool view_;
+        //one byte per track (not vector<bool>) so tracks can be set concurrently
+        vector<char> trig_;
         bool initialized_;
         Real frameRate_;
-        RealVecVecVec signal_;
+        Real *data_;
         RealVec centreFreqs_;
         RealVecVec spatialPositions_;
     }; 
@@ -44,6 +44,24 @@ namespace cnpy {
     NpyArray npz_load(std::string fname, std::string varname);
     NpyArray npy_load(std::string fname);
 
+    //copy the elements of a floating point array into a vector of T,
+    //converting from the stored precision (float or double) as required
+    template<typename T> std::vector<T> npy_data_as(const NpyArray& arr) {
+        unsigned int nels = 1;
+        for(unsigned int i = 0; i < arr.shape.size(); i++) nels *= arr.shape[i];
+        std::vector<T> out(nels);
+        if(arr.word_size == sizeof(float)) {
+            const float* src = reinterpret_cast<const float*>(arr.data);
+            for(unsigned int i = 0; i < nels; i++) out[i] = (T)src[i];
+        }
+        else {
+            assert(arr.word_size == sizeof(double));
+            const double* src = reinterpret_cast<const double*>(arr.data);
+            for(unsigned int i = 0; i < nels; i++) out[i] = (T)src[i];
+        }
+        return out;
+    }
+
     template<typename T> std::vector<char>& operator+=(std::vector<char>& lhs, const T rhs) {
         //write in little endian
         for(char byte = 0; byte < sizeof(T); byte++) {
@@ -21,7 +21,7 @@
 %{
 #define SWIG_FILE_WITH_INIT
 
-#include "../src/Support/SignalBank.h"
+#include "../src/Support/TrackBank.h"
 #include "../src/Support/Module.h"
 #include "../src/Support/Model.h"
 #include "../src/Support/Spline.h"
@@ -43,7 +43,6 @@
 #include "../src/Modules/CompressSpectrum.h"
 #include "../src/Modules/WeightSpectrum.h"
 #include "../src/Models/DynamicLoudnessGM.h"
-#include "../src/Models/SteadyLoudnessANSIS3407.h"
 %}
 
 //Required for integration with numpy arrays
@@ -53,10 +52,26 @@
 import_array();
 %}
 
+%include "std_vector.i"
+
+#ifdef LOUDNESS_SINGLE_PRECISION
+//apply all of the float typemaps to Real
+%apply float { Real };
+
+namespace std {
+    //The argument to %template() is the name of the instantiation in the target language
+    %template(RealVec) vector<float>;
+    //filter coefficients are always double precision
+    %template(DoubleVec) vector<double>;
+    //apply all of the float vector typemaps to RealVec
+    %apply vector<float> { RealVec };
+    //apply all of the float vector reference typemaps to const RealVec&
+    %apply const vector<float>& { const RealVec&};
+}
+#else
 //apply all of the double typemaps to Real
 %apply double { Real };
 
-%include "std_vector.i"
 namespace std {
     //The argument to %template() is the name of the instantiation in the target language
     %template(RealVec) vector<double>;
@@ -65,6 +80,7 @@ namespace std {
     //apply all of the double vector reference typemaps to const RealVec&
     %apply const vector<double>& { const RealVec&};
 }
+#endif
 
 using namespace std;
 %include "std_string.i"
@@ -73,7 +89,7 @@ namespace loudness{
 using std::string;
 }
 
-%include "../src/Support/SignalBank.h"
+%include "../src/Support/TrackBank.h"
 %include "../src/Support/Module.h"
 %include "../src/Support/Model.h"
 %include "../src/Support/Spline.h"
@@ -94,7 +110,6 @@ using std::string;
 %include "../src/Modules/RoexBankANSIS3407.h"
 %include "../src/Modules/FastRoexBank.h"
 %include "../src/Models/DynamicLoudnessGM.h"
-%include "../src/Models/SteadyLoudnessANSIS3407.h"
 
 
 
@@ -2,6 +2,19 @@
 
 from distutils.core import setup, Extension
 from distutils import sysconfig
+import os
+
+#LOUDNESS_SINGLE_PRECISION=1 builds the bindings with float samples
+swig_opts = ['-c++']
+define_macros = []
+fftw = 'fftw3'
+if os.environ.get('LOUDNESS_SINGLE_PRECISION', '0') == '1':
+    swig_opts.append('-DLOUDNESS_SINGLE_PRECISION')
+    define_macros.append(('LOUDNESS_SINGLE_PRECISION', None))
+    fftw = 'fftw3f'
+#LOUDNESS_PROFILE=1 enables per-module statistics (Model.getModuleStats)
+if os.environ.get('LOUDNESS_PROFILE', '0') == '1':
+    define_macros.append(('LOUDNESS_PROFILE', None))
 
 setup(name="loudness",
         py_modules=['loudness'], 
@@ -9,32 +22,47 @@ setup(name="loudness",
         [
             "loudness.i",
             "../src/cnpy/cnpy.cpp",
-            "../src/Support/SignalBank.cpp",
+            "../src/Modules/AudioFileCutter.cpp",
+            "../src/Support/TrackBank.cpp",
             "../src/Support/Module.cpp",
-            "../src/Support/Model.cpp",
-            "../src/Support/Spline.cpp",
-            "../src/Support/AuditoryTools.cpp",
+            "../src/Support/FusedModule.cpp",
+            "../src/Support/ThreadPool.cpp",
+            "../src/Support/Pipeline.cpp",
             "../src/Support/Timer.cpp",
+            "../src/Support/MirroredRing.cpp",
+            "../src/Support/LevelWeightCache.cpp",
+            "../src/Support/SIMDMath.cpp",
+            "../src/Support/LogLookupTable.cpp",
+            "../src/Support/AuditoryTools.cpp",
+            "../src/Support/Spline.cpp",
+            "../src/Support/FFTW.cpp",
             "../src/Support/Filter.cpp",
-            "../src/Modules/AudioFileCutter.cpp",
+            "../src/Support/FilterBank.cpp",
+            "../src/Support/Model.cpp",
             "../src/Modules/FrameGenerator.cpp",
             "../src/Modules/FIR.cpp",
             "../src/Modules/IIR.cpp",
             "../src/Modules/Butter.cpp",
-            "../src/Modules/IntegratedLoudnessGM.cpp",
-            "../src/Modules/SpecificLoudnessGM.cpp",
             "../src/Modules/RoexBankANSIS3407.cpp",
             "../src/Modules/FastRoexBank.cpp",
             "../src/Modules/DoubleRoexBank.cpp",
             "../src/Modules/PowerSpectrum.cpp",
+            "../src/Modules/SlidingPowerSpectrum.cpp",
             "../src/Modules/GoertzelPS.cpp",
-            "../src/Modules/CompressSpectrum.cpp",
+            "../src/Modules/PowerSpectrumAndSpatialDetection.cpp",
             "../src/Modules/WeightSpectrum.cpp",
+            "../src/Modules/CompressSpectrum.cpp",
+            "../src/Modules/SpecificLoudnessGM.cpp",
+            "../src/Modules/IntegratedLoudnessGM.cpp",
+            "../src/Modules/SpecificPartialLoudnessGM.cpp",
+            "../src/Modules/IntegratedPartialLoudnessGM.cpp",
             "../src/Models/DynamicLoudnessGM.cpp",
-            "../src/Models/SteadyLoudnessANSIS3407.cpp"
+            "../src/Models/DynamicPartialLoudnessGM.cpp"
             ],
         #include_dirs = [numpy_include, "/usr/include"],
         library_dirs=['/usr/lib', '/usr/local/lib'],
-        libraries=['fftw3', 'sndfile'],
-        swig_opts=['-c++'],
-        extra_compile_args=["-std=c++11", "-fPIC", "-O3"])])
+        libraries=[fftw, 'sndfile'],
+        define_macros=define_macros,
+        swig_opts=swig_opts,
+        extra_compile_args=["-std=c++11", "-fPIC", "-O3", "-pthread"],
+        extra_link_args=["-pthread"])])